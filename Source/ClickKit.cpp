@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    ClickKit.cpp
+    Created: 20 Oct 2026 7:36:04am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "ClickKit.h"
+#include "RealtimeLog.h"
+
+std::unique_ptr<ClickKit> ClickKit::createBuiltIn(ClickSampleCache& cache, double sampleRate, bool isDouble)
+{
+    auto kit = std::make_unique<ClickKit>();
+    kit->sampleRate = sampleRate;
+    kit->isDouble = isDouble;
+    for (int slot = 0; slot < numSlots; slot++)
+    {
+        kit->samples[(size_t)slot] = cache.getSample((ClickSampleId)slot, sampleRate);
+        kit->isBuiltIn[(size_t)slot] = true;
+        if (isDouble)
+        {
+            kit->samples[(size_t)slot]->prepareDouble();
+        }
+    }
+    return kit;
+}
+
+bool ClickKit::isOnlyUser() const
+{
+    for (int slot = 0; slot < numSlots; slot++)
+    {
+        if (!isBuiltIn[(size_t)slot] && samples[(size_t)slot]->getReferenceCount() > 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+const juce::StringArray ClickKitLoader::slotNames{ "accent", "beat", "subdivision" };
+
+ClickKitLoader::ClickKitLoader(ClickSampleCache& _cache)
+    : juce::Thread("click kit loader"), cache(_cache)
+{
+    formats.registerBasicFormats();
+}
+
+ClickKitLoader::~ClickKitLoader()
+{
+    stopThread(-1);
+}
+
+void ClickKitLoader::load(const juce::File& folder, double sampleRate, bool isDouble)
+{
+    {
+        const juce::ScopedLock sl(requestLock);
+        requestedFolder = folder;
+        requestedSampleRate = sampleRate;
+        isDoubleRequested = isDouble;
+        hasRequest = true;
+    }
+    if (!isThreadRunning())
+    {
+        startThread(juce::Thread::Priority::low);
+    }
+    notify();
+}
+
+void ClickKitLoader::run()
+{
+    while (!threadShouldExit())
+    {
+        juce::File folder;
+        double sampleRate = 0;
+        bool isDouble = false;
+        {
+            const juce::ScopedLock sl(requestLock);
+            folder = requestedFolder;
+            sampleRate = requestedSampleRate;
+            isDouble = isDoubleRequested;
+            if (!std::exchange(hasRequest, false))
+            {
+                folder = juce::File();
+            }
+        }
+        if (folder == juce::File())
+        {
+            wait(-1);
+            continue;
+        }
+
+        auto kit = build(folder, sampleRate, isDouble);
+        if (kit != nullptr && !threadShouldExit() && onLoaded)
+        {
+            onLoaded(std::move(kit));
+        }
+    }
+}
+
+std::unique_ptr<ClickKit> ClickKitLoader::build(const juce::File& folder, double sampleRate, bool isDouble)
+{
+    auto kit = ClickKit::createBuiltIn(cache, sampleRate, isDouble);
+    kit->folder = folder;
+    int numLoaded = 0;
+    int numCached = 0;
+    for (int slot = 0; slot < ClickKit::numSlots; slot++)
+    {
+        if (threadShouldExit())
+        {
+            return nullptr;
+        }
+        //any extension a registered format reads, the first one found wins
+        juce::File file;
+        for (const auto& candidate : folder.findChildFiles(juce::File::findFiles, false, slotNames[slot] + ".*"))
+        {
+            if (formats.findFormatForFileExtension(candidate.getFileExtension()) != nullptr)
+            {
+                file = candidate;
+                break;
+            }
+        }
+        if (file == juce::File())
+        {
+            continue;
+        }
+
+        //a sound loaded before, at this rate, comes back mapped from the disk cache without decoding
+        const juce::SHA256 sourceHash(file);
+        auto sample = diskCache.find(sourceHash, sampleRate);
+        if (sample != nullptr)
+        {
+            numCached++;
+        }
+        else
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+            if (reader == nullptr || reader->lengthInSamples <= 0)
+            {
+                RealtimeLog::write(LogMessage::clickKitSlotFailed, slot);
+                continue;
+            }
+
+            auto data = ClickSampleCache::readAndResample(*reader, sampleRate);
+            const float peak = data.getMagnitude(0, data.getNumSamples());
+            if (peak > 0.0f)
+            {
+                data.applyGain(normalizedPeak / peak);
+            }
+            //played from the mapped entry when it could be written, so other instances share its pages
+            sample = diskCache.store(sourceHash, sampleRate, data);
+            if (sample == nullptr)
+            {
+                sample = new ClickSample(std::move(data));
+            }
+        }
+        if (isDouble)
+        {
+            sample->prepareDouble();
+        }
+        kit->samples[(size_t)slot] = sample;
+        kit->isBuiltIn[(size_t)slot] = false;
+        numLoaded++;
+    }
+    RealtimeLog::write(LogMessage::clickKitLoaded, numLoaded, numCached, sampleRate);
+    return kit;
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    ClickKit.h
+    Created: 20 Oct 2026 7:36:04am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ClickSampleCache.h"
+#include "ClickKitDiskCache.h"
+
+//the sound every ClickSampleId slot plays, all at one sample rate, either the built in clicks or a user's kit
+//never changed after it's built, the processor hands a new one to the audio thread through an atomic pointer
+//like an engine, and the old one is freed on the message thread
+class ClickKit
+{
+public:
+    static constexpr int numSlots = 3; //in ClickSampleId order
+
+    //any thread but the audio thread, the clicks compiled into BinaryData, isDouble also makes their double copies
+    static std::unique_ptr<ClickKit> createBuiltIn(ClickSampleCache& cache, double sampleRate, bool isDouble);
+
+    const ClickSample::Ptr& getSample(ClickSampleId id) const { return samples[(size_t)id]; }
+    double getSampleRate() const { return sampleRate; }
+    //every sample has its double copy, so a double precision host can play this kit
+    bool hasDoubleData() const { return isDouble; }
+    //the folder a user kit came from, a default File for the built in one
+    const juce::File& getFolder() const { return folder; }
+
+    //true once nothing but this kit holds any of its samples from files, so freeing it won't pull one out from under a voice
+    //built in samples are held by the cache too, which only lets go of them on the message thread
+    bool isOnlyUser() const;
+
+private:
+    friend class ClickKitLoader;
+
+    std::array<ClickSample::Ptr, numSlots> samples;
+    std::array<bool, numSlots> isBuiltIn{};
+    double sampleRate = 0;
+    bool isDouble = false;
+    juce::File folder;
+};
+
+//builds user kits on a thread of its own, so a big file or a slow disk never holds up the audio or the UI
+//a kit is a folder with a file per slot named accent, beat and subdivision, in any format the AudioFormatManager reads
+//(WAV, AIFF, FLAC, Ogg Vorbis), a slot without a file, or with one that can't be read, keeps the built in click
+//every sound is decoded, peak normalized to normalizedPeak and resampled to the sample rate (and precision) the kit was asked for,
+//then kept in the ClickKitDiskCache, so loading the same files at the same rate again only maps them
+class ClickKitLoader : private juce::Thread
+{
+public:
+    static constexpr float normalizedPeak = 0.89f; //-1 dBFS
+    static const juce::StringArray slotNames; //file names without extension, in ClickSampleId order
+
+    ClickKitLoader(ClickSampleCache& _cache);
+    ~ClickKitLoader() override;
+
+    //called on the loader thread with each kit it finishes
+    std::function<void(std::unique_ptr<ClickKit>)> onLoaded;
+
+    //any thread, a request that hasn't started yet is replaced by a newer one, isDouble for a double precision host
+    void load(const juce::File& folder, double sampleRate, bool isDouble);
+    //waits for a kit that is being built and stops the thread, onLoaded isn't called after this
+    void stopLoading() { stopThread(-1); }
+
+private:
+    void run() override;
+    std::unique_ptr<ClickKit> build(const juce::File& folder, double sampleRate, bool isDouble);
+
+    ClickSampleCache& cache;
+    juce::AudioFormatManager formats;
+    ClickKitDiskCache diskCache;
+
+    juce::CriticalSection requestLock;
+    juce::File requestedFolder;
+    double requestedSampleRate = 0;
+    bool isDoubleRequested = false;
+    bool hasRequest = false;
+};
@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+    ClickKitDiskCache.cpp
+    Created: 20 Oct 2026 8:14:50am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "ClickKitDiskCache.h"
+
+//the start of every entry, followed by padding up to dataOffset
+struct ClickKitDiskCache::Header
+{
+    static constexpr juce::uint32 currentVersion = 1; //bumped whenever the layout or what ClickKitLoader does to a sound changes
+
+    char magic[8];
+    juce::uint32 version;
+    juce::uint32 numChannels;
+    juce::int64 numSamples;
+    juce::int64 channelStride; //floats from the start of one channel to the next, a multiple of floatsPerAlignment
+    double sampleRate;
+    juce::uint8 sourceHash[32];
+    juce::uint64 checksum; //of everything after the header's padding
+};
+
+namespace
+{
+    const char entryMagic[8] = { 'M', 'G', 'C', 'L', 'I', 'C', 'K', 0 };
+    const char* const entryExtension = ".mgclick";
+
+    //FNV-1a, enough to catch a truncated or half written entry, which is all it's for
+    juce::uint64 updateChecksum(juce::uint64 checksum, const void* data, size_t numBytes)
+    {
+        auto* bytes = static_cast<const juce::uint8*>(data);
+        for (size_t i = 0; i < numBytes; i++)
+        {
+            checksum = (checksum ^ bytes[i]) * 1099511628211ull;
+        }
+        return checksum;
+    }
+    constexpr juce::uint64 checksumSeed = 14695981039346656037ull;
+}
+
+ClickKitDiskCache::ClickKitDiskCache(juce::File _folder, juce::int64 _maxBytes)
+    : folder(std::move(_folder)), maxBytes(_maxBytes)
+{
+    static_assert(sizeof(Header) <= dataOffset, "the header has to fit before the data");
+}
+
+juce::File ClickKitDiskCache::getDefaultFolder()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("MetroGnome").getChildFile("KitCache");
+}
+
+juce::File ClickKitDiskCache::getEntryFile(const juce::SHA256& sourceHash, double sampleRate) const
+{
+    //the header holds the exact key, the name only has to tell entries apart
+    return folder.getChildFile(sourceHash.toHexString().substring(0, 32) + "-" + juce::String(juce::roundToInt(sampleRate)) + entryExtension);
+}
+
+ClickSample::Ptr ClickKitDiskCache::find(const juce::SHA256& sourceHash, double sampleRate)
+{
+    auto file = getEntryFile(sourceHash, sampleRate);
+    if (!file.existsAsFile())
+    {
+        return nullptr;
+    }
+
+    auto mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly, false);
+    auto* data = static_cast<const char*>(mapping->getData());
+    const auto size = (juce::int64)mapping->getSize();
+    Header header;
+    bool isValid = data != nullptr && size >= dataOffset;
+    if (isValid)
+    {
+        std::memcpy(&header, data, sizeof(Header));
+        const auto& hash = sourceHash.getRawData();
+        isValid = std::memcmp(header.magic, entryMagic, sizeof(entryMagic)) == 0
+            && header.version == Header::currentVersion
+            && header.sampleRate == sampleRate
+            && hash.getSize() == sizeof(header.sourceHash) && std::memcmp(header.sourceHash, hash.getData(), sizeof(header.sourceHash)) == 0
+            && header.numChannels > 0 && header.numChannels <= 8
+            && header.numSamples > 0 && header.numSamples <= header.channelStride && header.channelStride % floatsPerAlignment == 0
+            && size == dataOffset + (juce::int64)header.numChannels * header.channelStride * (juce::int64)sizeof(float);
+    }
+    if (isValid)
+    {
+        isValid = updateChecksum(checksumSeed, data + dataOffset, (size_t)(size - dataOffset)) == header.checksum;
+    }
+    if (!isValid)
+    {
+        //left by a crash, a full disk or an older build, it's decoded and written again
+        mapping.reset();
+        file.deleteFile();
+        return nullptr;
+    }
+
+    //the eviction goes by this, some file systems don't keep it up themselves
+    file.setLastAccessTime(juce::Time::getCurrentTime());
+
+    std::array<float*, 8> channels{};
+    for (juce::uint32 channel = 0; channel < header.numChannels; channel++)
+    {
+        //mapped read only, ClickSample never writes to its data
+        channels[channel] = reinterpret_cast<float*>(const_cast<char*>(data + dataOffset)) + channel * header.channelStride;
+    }
+    return new ClickSample(std::move(mapping), channels.data(), (int)header.numChannels, (int)header.numSamples);
+}
+
+ClickSample::Ptr ClickKitDiskCache::store(const juce::SHA256& sourceHash, double sampleRate, const juce::AudioBuffer<float>& data)
+{
+    if (!folder.createDirectory() || data.getNumChannels() <= 0 || data.getNumChannels() > 8 || data.getNumSamples() <= 0)
+    {
+        return nullptr;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, entryMagic, sizeof(entryMagic));
+    header.version = Header::currentVersion;
+    header.numChannels = (juce::uint32)data.getNumChannels();
+    header.numSamples = data.getNumSamples();
+    header.channelStride = (data.getNumSamples() + floatsPerAlignment - 1) / floatsPerAlignment * floatsPerAlignment;
+    header.sampleRate = sampleRate;
+    const auto& hash = sourceHash.getRawData();
+    std::memcpy(header.sourceHash, hash.getData(), juce::jmin(hash.getSize(), sizeof(header.sourceHash)));
+
+    const std::vector<float> padding((size_t)(header.channelStride - header.numSamples), 0.0f);
+    header.checksum = checksumSeed;
+    for (int channel = 0; channel < data.getNumChannels(); channel++)
+    {
+        header.checksum = updateChecksum(header.checksum, data.getReadPointer(channel), (size_t)data.getNumSamples() * sizeof(float));
+        header.checksum = updateChecksum(header.checksum, padding.data(), padding.size() * sizeof(float));
+    }
+
+    //written next to the entry and renamed over it, so another process never maps half an entry
+    auto file = getEntryFile(sourceHash, sampleRate);
+    juce::TemporaryFile temporary(file);
+    {
+        juce::FileOutputStream stream(temporary.getFile());
+        if (stream.failedToOpen())
+        {
+            return nullptr;
+        }
+        char headerBytes[dataOffset] = {};
+        std::memcpy(headerBytes, &header, sizeof(Header));
+        stream.write(headerBytes, dataOffset);
+        for (int channel = 0; channel < data.getNumChannels(); channel++)
+        {
+            stream.write(data.getReadPointer(channel), (size_t)data.getNumSamples() * sizeof(float));
+            stream.write(padding.data(), padding.size() * sizeof(float));
+        }
+        stream.flush();
+        if (stream.getStatus().failed())
+        {
+            return nullptr;
+        }
+    }
+    if (!temporary.overwriteTargetFileWithTemporary())
+    {
+        return nullptr;
+    }
+
+    evict(file);
+    return find(sourceHash, sampleRate);
+}
+
+void ClickKitDiskCache::evict(const juce::File& keep)
+{
+    //least recently used first, an entry another process still has mapped stays readable to it after it's deleted
+    auto entries = folder.findChildFiles(juce::File::findFiles, false, juce::String("*") + entryExtension);
+    juce::int64 totalBytes = 0;
+    for (const auto& entry : entries)
+    {
+        totalBytes += entry.getSize();
+    }
+    if (totalBytes <= maxBytes)
+    {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const juce::File& a, const juce::File& b) { return a.getLastAccessTime() < b.getLastAccessTime(); });
+    for (const auto& entry : entries)
+    {
+        if (totalBytes <= maxBytes)
+        {
+            break;
+        }
+        if (entry == keep)
+        {
+            continue;
+        }
+        const auto entryBytes = entry.getSize();
+        if (entry.deleteFile())
+        {
+            totalBytes -= entryBytes;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    ClickKitDiskCache.h
+    Created: 20 Oct 2026 8:14:50am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ClickSampleCache.h"
+
+//kit sounds as ClickKitLoader leaves them (decoded, normalized, resampled) kept on disk, so a kit that was loaded before
+//comes back without decoding anything
+//an entry is one sound at one sample rate, keyed by the SHA-256 of its source file, laid out as a header and then raw floats
+//with every channel starting on a 64 byte boundary, found entries are played straight from a juce::MemoryMappedFile,
+//so every instance and process using the same sound shares its pages
+//entries are checked (layout, key and a checksum of the data) before they're used, a bad one is deleted and decoded again,
+//new ones are written to a temporary file and renamed into place, and the least recently used go once the folder passes maxBytes
+//the layout is the machine's own (byte order, float format), the cache is never meant to be copied anywhere
+class ClickKitDiskCache
+{
+public:
+    static constexpr juce::int64 defaultMaxBytes = 64 * 1024 * 1024;
+
+    ClickKitDiskCache(juce::File _folder = getDefaultFolder(), juce::int64 _maxBytes = defaultMaxBytes);
+
+    static juce::File getDefaultFolder();
+
+    //the sound decoded from a file with sourceHash at sampleRate, mapped from its entry, nullptr if there isn't a good one
+    ClickSample::Ptr find(const juce::SHA256& sourceHash, double sampleRate);
+    //writes data as the entry for sourceHash at sampleRate and returns it mapped from there, nullptr if it couldn't be written
+    ClickSample::Ptr store(const juce::SHA256& sourceHash, double sampleRate, const juce::AudioBuffer<float>& data);
+
+private:
+    struct Header;
+
+    static constexpr int dataOffset = 128; //bytes before the first channel, a multiple of 64
+    static constexpr int floatsPerAlignment = 16; //64 bytes
+
+    juce::File getEntryFile(const juce::SHA256& sourceHash, double sampleRate) const;
+    void evict(const juce::File& keep);
+
+    juce::File folder;
+    juce::int64 maxBytes;
+};
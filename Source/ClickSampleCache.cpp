@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    ClickSampleCache.cpp
+    Created: 19 Oct 2026 11:02:17am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "ClickSampleCache.h"
+
+ClickSample::Ptr ClickSampleCache::getSample(ClickSampleId id, double sampleRate)
+{
+    const juce::ScopedLock sl(lock);
+
+    //drop clicks decoded for sample rates nobody is using anymore
+    for (int i = entries.size(); --i >= 0;)
+    {
+        if (entries.getReference(i).sample->getReferenceCount() == 1)
+        {
+            entries.remove(i);
+        }
+    }
+
+    for (auto& entry : entries)
+    {
+        if (entry.id == id && entry.sampleRate == sampleRate)
+        {
+            return entry.sample;
+        }
+    }
+
+    ClickSample::Ptr sample = new ClickSample(decode(id, sampleRate));
+    entries.add({ id, sampleRate, sample });
+    return sample;
+}
+
+juce::AudioBuffer<float> ClickSampleCache::decode(ClickSampleId id, double sampleRate)
+{
+    const char* wavData = BinaryData::rimshot_high_wav;
+    int wavSize = BinaryData::rimshot_high_wavSize;
+    if (id == ClickSampleId::rimShotLow)
+    {
+        wavData = BinaryData::rimshot_low_wav;
+        wavSize = BinaryData::rimshot_low_wavSize;
+    }
+    else if (id == ClickSampleId::rimShotSub)
+    {
+        wavData = BinaryData::rimshot_sub_wav;
+        wavSize = BinaryData::rimshot_sub_wavSize;
+    }
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatReader> reader(wavFormat.createReaderFor(new juce::MemoryInputStream(wavData, (size_t)wavSize, false), true));
+    if (reader == nullptr)
+    {
+        jassertfalse;
+        return {};
+    }
+    return readAndResample(*reader, sampleRate);
+}
+
+juce::AudioBuffer<float> ClickSampleCache::readAndResample(juce::AudioFormatReader& reader, double sampleRate)
+{
+    //a few extra zeroed samples at the end so the interpolator never reads past the click
+    const int fileLength = (int)reader.lengthInSamples;
+    const int numChannels = (int)reader.numChannels;
+    juce::AudioBuffer<float> fileData(numChannels, fileLength + 4);
+    fileData.clear();
+    reader.read(&fileData, 0, fileLength, 0, true, true);
+
+    if (sampleRate <= 0 || reader.sampleRate == sampleRate)
+    {
+        fileData.setSize(numChannels, fileLength, true);
+        return fileData;
+    }
+
+    const double ratio = reader.sampleRate / sampleRate;
+    const int resampledLength = (int)std::ceil(fileLength / ratio);
+    juce::AudioBuffer<float> resampled(numChannels, resampledLength);
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        juce::LagrangeInterpolator interpolator;
+        interpolator.process(ratio, fileData.getReadPointer(channel), resampled.getWritePointer(channel), resampledLength);
+    }
+    return resampled;
+}
+
+
+void ClickVoice::setSample(ClickSample::Ptr newSample)
+{
+    sample = newSample;
+    length = sample != nullptr ? sample->getData<float>().getNumSamples() : 0;
+    position = length;
+    numPending = 0;
+}
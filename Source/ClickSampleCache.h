@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+    ClickSampleCache.h
+    Created: 19 Oct 2026 11:02:17am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//the click sounds compiled into BinaryData
+enum class ClickSampleId
+{
+    rimShotHigh = 0,
+    rimShotLow,
+    rimShotSub
+};
+
+//a decoded click, already resampled to the sample rate it was requested at
+//kept in float, and in double too once a double precision host asks for it, so the voices mix it straight into either buffer
+//only the double copy is ever added after construction, and only once, so any number of engines can read it at once
+class ClickSample : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<ClickSample>;
+
+    ClickSample(juce::AudioBuffer<float>&& decodedData) : data(std::move(decodedData)) {}
+
+    //plays the float data straight from a mapped ClickKitDiskCache entry, which it keeps open, so a float host shares its pages
+    ClickSample(std::unique_ptr<juce::MemoryMappedFile> _mapping, float* const* channels, int numChannels, int numSamples)
+        : mapping(std::move(_mapping)), data(channels, numChannels, numSamples)
+    {
+    }
+
+    //any thread but the audio thread, makes the double copy the first time it's called, before a double precision host plays this click
+    void prepareDouble() const
+    {
+        std::call_once(doubleDataFlag, [this] { doubleData.makeCopyOf(data); });
+    }
+
+    template <typename SampleType>
+    const juce::AudioBuffer<SampleType>& getData() const
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+        {
+            jassert(doubleData.getNumSamples() == data.getNumSamples()); //prepareDouble wasn't called
+            return doubleData;
+        }
+        else
+        {
+            return data;
+        }
+    }
+
+private:
+    std::unique_ptr<juce::MemoryMappedFile> mapping; //before data, which can point into it
+    juce::AudioBuffer<float> data;
+    mutable std::once_flag doubleDataFlag;
+    mutable juce::AudioBuffer<double> doubleData;
+};
+
+//process wide cache of decoded clicks keyed by sample id and sample rate
+//held through juce::SharedResourcePointer<ClickSampleCache>, so every engine of every plugin instance shares one copy
+//of each click, it is created by the first instance and deleted when the last one goes away
+class ClickSampleCache
+{
+public:
+    //any thread but the audio thread, decodes the click the first time a sample rate asks for it
+    ClickSample::Ptr getSample(ClickSampleId id, double sampleRate);
+
+    //reads all of reader and resamples it to sampleRate (0 keeps the file's own), for the built in clicks and user kits alike
+    static juce::AudioBuffer<float> readAndResample(juce::AudioFormatReader& reader, double sampleRate);
+
+private:
+    static juce::AudioBuffer<float> decode(ClickSampleId id, double sampleRate);
+
+    struct Entry
+    {
+        ClickSampleId id;
+        double sampleRate;
+        ClickSample::Ptr sample;
+    };
+
+    juce::CriticalSection lock;
+    juce::Array<Entry> entries;
+};
+
+//plays one ClickSample into the engine's output, a click that doesn't fit in the current block carries on into the next ones
+//clicks can be triggered further ahead than one block (the click offsets hold them back), a few wait their turn in a fixed size list
+class ClickVoice
+{
+public:
+    //message thread only, call while the audio thread isn't rendering (e.g. prepareToPlay)
+    void setSample(ClickSample::Ptr newSample);
+
+    //audio thread, the next click plays newSample and whatever is still ringing stops, unless it already is the voice's sample
+    //whoever handed the sample over keeps the old one alive past this, so a voice never frees a sample on the audio thread
+    void switchSample(const ClickSample::Ptr& newSample)
+    {
+        if (newSample == sample)
+        {
+            return;
+        }
+        sample = newSample;
+        length = sample != nullptr ? sample->getData<float>().getNumSamples() : 0;
+        position = length;
+    }
+
+    //starts the click startOffset samples into the next block that gets rendered, scaled by gain (the step's level)
+    //the new click cuts off whatever is still ringing when it starts, it is dropped (and false returned) if maxPendingClicks are already waiting
+    bool trigger(int startOffset, float newGain = 1.0f)
+    {
+        if (numPending == maxPendingClicks)
+        {
+            return false;
+        }
+        pending[(size_t)numPending++] = { startOffset, newGain };
+        return true;
+    }
+
+    //true while a click is ringing or waiting to start
+    bool isActive() const { return position < length || numPending > 0; }
+
+    //mixes the part of the click that falls in this block into every channel of buffer
+    //NumChannels is the engine's compile time channel count, 0 means use the buffer's, SampleType is the host's precision
+    template <int NumChannels, typename SampleType>
+    void render(juce::AudioBuffer<SampleType>& buffer)
+    {
+        const int numSamples = buffer.getNumSamples();
+        int blockPosition = 0;
+        while (numPending > 0)
+        {
+            //the earliest waiting click, they are usually already in order
+            int next = 0;
+            for (int i = 1; i < numPending; i++)
+            {
+                if (pending[(size_t)i].startOffset < pending[(size_t)next].startOffset)
+                {
+                    next = i;
+                }
+            }
+            const int start = juce::jmax(blockPosition, pending[(size_t)next].startOffset);
+            if (start >= numSamples)
+            {
+                break;
+            }
+            renderSegment<NumChannels>(buffer, blockPosition, start);
+            position = 0;
+            gain = pending[(size_t)next].gain;
+            pending[(size_t)next] = pending[(size_t)--numPending];
+            blockPosition = start;
+        }
+        renderSegment<NumChannels>(buffer, blockPosition, numSamples);
+
+        for (int i = 0; i < numPending; i++)
+        {
+            pending[(size_t)i].startOffset -= numSamples;
+        }
+    }
+
+private:
+    //plays the current click from blockStart up to blockEnd
+    template <int NumChannels, typename SampleType>
+    void renderSegment(juce::AudioBuffer<SampleType>& buffer, int blockStart, int blockEnd)
+    {
+        const int numToCopy = juce::jmin(blockEnd - blockStart, length - position);
+        if (numToCopy > 0)
+        {
+            const auto& data = sample->getData<SampleType>();
+            const int numChannels = NumChannels > 0 ? NumChannels : buffer.getNumChannels();
+            for (int channel = 0; channel < numChannels; channel++)
+            {
+                buffer.addFrom(channel, blockStart, data, channel % data.getNumChannels(), position, numToCopy, (SampleType)gain);
+            }
+        }
+        position = juce::jmin(length, position + blockEnd - blockStart);
+    }
+
+    //a click waits for at most the click delay (100ms of lookahead plus a 100ms offset), a groove step and the rest of its block,
+    //Default mode's subdivisions come every 12.5ms at 300 bpm, so this holds them at any offset with blocks of up to 175ms
+    //only denser tuplets or longer blocks can fill it, the engines count what's dropped for the diagnostics
+    static constexpr int maxPendingClicks = 32;
+
+    struct PendingClick
+    {
+        int startOffset = 0; //from the start of the next block
+        float gain = 1.0f;
+    };
+
+    ClickSample::Ptr sample;
+    int length = 0;
+    float gain = 1.0f;
+    int position = 0; //read position in the current click at the start of the next block, length once it has finished
+    std::array<PendingClick, maxPendingClicks> pending;
+    int numPending = 0;
+};
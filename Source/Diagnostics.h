@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    Diagnostics.h
+    Created: 20 Oct 2026 4:48:16am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//what the editor's diagnostics panel shows, for checking a rig that starts to crackle
+//the audio thread is the only writer, the counters only ever go up and are stored with relaxed atomics,
+//the panel samples them a few times a second and works out rates from the difference
+struct DiagnosticCounters
+{
+    //audio thread only
+    static void add(std::atomic<juce::uint64>& counter, juce::uint64 amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    //processBlock time against the block's duration, also counts the blocks that took longer than real time (getXRunCount)
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+
+    std::atomic<juce::uint64> blocks{ 0 };
+    std::atomic<juce::uint64> callbackGaps{ 0 }; //the host called processBlock more than two blocks' time after the previous call
+    std::atomic<juce::uint64> hostTimeJumps{ 0 }; //the playing host's position didn't carry on from the last block (seeks and loops count too)
+    std::atomic<juce::uint64> clicks{ 0 }; //clicks the engines, the song or the loop cache played
+    std::atomic<juce::uint64> droppedClicks{ 0 }; //triggered while a voice already had as many waiting as it holds
+    std::atomic<int> activeVoices{ 0 }; //of the live engine, at the end of the last block, the loop cache plays without voices
+    std::atomic<juce::uint64> midiEvents{ 0 }; //sent to the host
+    std::atomic<juce::uint64> droppedMidiEvents{ 0 }; //that couldn't be added to a block's buffer or the delay's list
+};
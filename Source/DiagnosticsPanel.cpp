@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    DiagnosticsPanel.cpp
+    Created: 20 Oct 2026 4:48:16am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "DiagnosticsPanel.h"
+
+DiagnosticsPanel::DiagnosticsPanel(DiagnosticCounters& _counters) : counters(_counters)
+{
+    setInterceptsMouseClicks(false, false);
+}
+
+void DiagnosticsPanel::visibilityChanged()
+{
+    //nothing is sampled while the panel is hidden
+    if (isVisible())
+    {
+        lastClicks = counters.clicks.load(std::memory_order_relaxed);
+        lastSampleMs = juce::Time::getMillisecondCounterHiRes();
+        timerCallback();
+        startTimerHz(sampleRateHz);
+    }
+    else
+    {
+        stopTimer();
+    }
+}
+
+void DiagnosticsPanel::timerCallback()
+{
+    const double nowMs = juce::Time::getMillisecondCounterHiRes();
+    const auto clicks = counters.clicks.load(std::memory_order_relaxed);
+    const double seconds = (nowMs - lastSampleMs) / 1000.0;
+    const double clicksPerSecond = seconds > 0 ? (clicks - lastClicks) / seconds : 0.0;
+    lastClicks = clicks;
+    lastSampleMs = nowMs;
+
+    lines.clearQuick();
+    lines.add("DSP load: " + juce::String(counters.loadMeasurer.getLoadAsPercentage(), 1) + " %");
+    lines.add("overruns: " + juce::String(counters.loadMeasurer.getXRunCount()) + "   late callbacks: " + juce::String((juce::int64)counters.callbackGaps.load(std::memory_order_relaxed)));
+    lines.add("host time jumps: " + juce::String((juce::int64)counters.hostTimeJumps.load(std::memory_order_relaxed)));
+    lines.add("clicks/s: " + juce::String(clicksPerSecond, 1) + "   active voices: " + juce::String(counters.activeVoices.load(std::memory_order_relaxed))
+        + "   dropped: " + juce::String((juce::int64)counters.droppedClicks.load(std::memory_order_relaxed)));
+    lines.add("MIDI out: " + juce::String((juce::int64)counters.midiEvents.load(std::memory_order_relaxed))
+        + "   dropped: " + juce::String((juce::int64)counters.droppedMidiEvents.load(std::memory_order_relaxed)));
+    repaint();
+}
+
+void DiagnosticsPanel::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::black.withAlpha(0.7f));
+    g.fillRect(getLocalBounds());
+    g.setColour(juce::Colours::lightgrey);
+    auto area = getLocalBounds().reduced(5);
+    const int lineHeight = juce::jmax(1, area.getHeight() / juce::jmax(1, lines.size()));
+    for (const auto& line : lines)
+    {
+        g.drawText(line, area.removeFromTop(lineHeight), juce::Justification::centredLeft);
+    }
+}
@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+
+    DiagnosticsPanel.h
+    Created: 20 Oct 2026 4:48:16am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Diagnostics.h"
+
+//the editor's optional diagnostics readout, samples the processor's DiagnosticCounters a few times a second
+//and only draws the text it made then, however often the editor repaints
+class DiagnosticsPanel : public juce::Component, private juce::Timer
+{
+public:
+    DiagnosticsPanel(DiagnosticCounters& _counters);
+
+    void paint(juce::Graphics& g) override;
+    void visibilityChanged() override;
+
+private:
+    void timerCallback() override;
+
+    static constexpr int sampleRateHz = 4;
+
+    DiagnosticCounters& counters;
+    juce::uint64 lastClicks = 0;
+    double lastSampleMs = 0;
+    juce::StringArray lines;
+};
@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    GrooveTable.cpp
+    Created: 19 Oct 2026 9:48:26pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "GrooveTable.h"
+
+GrooveTable::GrooveTable()
+{
+    offsets.fill(0);
+    levels.fill(1.0f);
+}
+
+void GrooveTable::update(const GrooveTemplate& groove, juce::uint32 grooveVersion, float swing, bool isSwung, double cycleLength, int numSteps, int interval)
+{
+    numSteps = juce::jlimit(1, MAX_STEPS, numSteps);
+    if (grooveVersion == builtVersion && swing == builtSwing && isSwung == builtIsSwung && cycleLength == builtCycleLength
+        && numSteps == builtNumSteps && interval == builtInterval)
+    {
+        return;
+    }
+    builtVersion = grooveVersion;
+    builtSwing = swing;
+    builtIsSwung = isSwung;
+    builtCycleLength = cycleLength;
+    builtNumSteps = numSteps;
+    builtInterval = interval;
+
+    const double exactStep = cycleLength / numSteps;
+    //swing places the odd step of each pair at swing of the pair's length
+    const double swingDelay = isSwung ? (2.0 * juce::jlimit(0.5, 0.75, (double)swing) - 1.0) * exactStep : 0.0;
+    const int grooveLength = juce::jlimit(1, MAX_STEPS, groove.length);
+
+    for (int position = 0; position <= numSteps; position++)
+    {
+        const int step = position % numSteps;
+        const int grooveStep = step % grooveLength;
+        double lateness = groove.timing[(size_t)grooveStep] * exactStep;
+        if (step % 2 == 1)
+        {
+            lateness += swingDelay;
+        }
+        //where the step belongs, minus where counting whole intervals finds it
+        offsets[(size_t)position] = juce::jmax(0, juce::roundToInt(position * exactStep + lateness) - position * interval);
+        levels[(size_t)position] = groove.velocity[(size_t)grooveStep];
+    }
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    GrooveTable.h
+    Created: 19 Oct 2026 9:48:26pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "StepPattern.h"
+
+//sample offset and level of every step of one voice, worked out from its GrooveTemplate, SWING and the voice's step length
+//rebuilt only when one of those changes, so playing a step just adds its offset and scales by its level
+//the offsets also hold what the engine's whole sample intervals lose against the exact grid, so steps land where
+//k * cycleLength / numSteps puts them and the cycle comes out exact every time round
+class GrooveTable
+{
+public:
+    GrooveTable();
+
+    //audio thread, cycleLength is the exact length of the voice's cycle, interval the whole samples between the steps the engine counts
+    //and isSwung whether SWING (0.5 straight to 0.75) delays the odd steps, nothing is done if none of it changed
+    void update(const GrooveTemplate& groove, juce::uint32 grooveVersion, float swing, bool isSwung, double cycleLength, int numSteps, int interval);
+
+    //step can be numSteps too, the first step of the next cycle, which the engines count at the end of the one before
+    int getOffset(int step) const { return offsets[(size_t)step]; }
+    float getLevel(int step) const { return levels[(size_t)step]; }
+
+private:
+    std::array<int, MAX_STEPS + 1> offsets;
+    std::array<float, MAX_STEPS + 1> levels;
+
+    //what the table was built from
+    juce::uint32 builtVersion = 0;
+    float builtSwing = -1.0f;
+    bool builtIsSwung = false;
+    double builtCycleLength = 0;
+    int builtNumSteps = 0;
+    int builtInterval = 0;
+};
@@ -0,0 +1,342 @@
+/*
+  ==============================================================================
+
+    LoopCache.cpp
+    Created: 19 Oct 2026 11:12:37pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "LoopCache.h"
+
+namespace
+{
+    const double maxLoopSeconds = 20.0; //longer cycles (slow polymeters) always render live
+    const double warmUpSeconds = 1.0; //run on after the first cycle, so clicks from before the snapshot have rung out
+    const int workerIntervalMs = 20;
+}
+
+bool LoopKey::matchesParameters(juce::AudioProcessorValueTreeState& apvts) const
+{
+    return apvts.getRawParameterValue("BPM")->load() == bpm
+        && apvts.getRawParameterValue("SWING")->load() == swing
+        && apvts.getRawParameterValue("RHYTHM1_ROTATE")->load() == rotate1
+        && apvts.getRawParameterValue("RHYTHM2_ROTATE")->load() == rotate2
+        && !apvts.getRawParameterValue("DAW_CONNECTED")->load()
+        && !apvts.getRawParameterValue("DAW_PLAYING")->load();
+}
+
+LoopCache::LoopCache(juce::AudioProcessorValueTreeState& _apvts, RhythmConfigExchange& _rhythmConfigs, StepPatternExchange& _stepPatterns, EngineDisplayState& _displayState, ScheduledClickQueue& _scheduledClicks)
+    : juce::Thread("MetroGnome loop cache"), apvts(_apvts), rhythmConfigs(_rhythmConfigs), stepPatterns(_stepPatterns), displayState(_displayState), scheduledClicks(_scheduledClicks)
+{
+}
+
+LoopCache::~LoopCache()
+{
+    stopThread(1000);
+    delete pendingRender.exchange(nullptr);
+    delete retiredRender.exchange(nullptr);
+}
+
+void LoopCache::prepare(double _sampleRate, int _blockSize)
+{
+    stopThread(1000);
+
+    sampleRate = _sampleRate;
+    blockSize = juce::jmax(1, _blockSize);
+    activeRender.reset();
+    delete pendingRender.exchange(nullptr);
+    delete retiredRender.exchange(nullptr);
+    requestState.store(idle);
+    restart();
+    pieceMidi.ensureSize(2048);
+
+    for (int mode = 0; mode < (int)snapshotEngines.size(); mode++)
+    {
+        snapshotEngines[(size_t)mode] = RhythmEngine::createForMode(mode, &apvts, &loopConfigs, &loopPatterns, &loopDisplay, &loopClicks);
+        snapshotEngines[(size_t)mode]->prepareToPlay(sampleRate, blockSize);
+    }
+
+    startThread();
+}
+
+template <typename SampleType>
+void LoopCache::process(RhythmEngine& engine, const ClickKit& kit, OutputRouting<SampleType>& routing, juce::MidiBuffer& midiMessages, const LoopKey& key, bool isCacheable, juce::int64 blockStart, bool isAnalyzing)
+{
+    TRACE_SCOPE("loop cache");
+    //a finished loop is only taken once the worker is done with the request, so an idle worker with nothing new means the loop is missing or stale
+    //the loop that is playing stays until the live engine has taken over again
+    const bool isWorkerIdle = requestState.load(std::memory_order_acquire) == idle;
+    if (!isPlayingLoop && retiredRender.load() == nullptr)
+    {
+        if (auto* nextRender = pendingRender.exchange(nullptr))
+        {
+            retiredRender.store(activeRender.release());
+            activeRender.reset(nextRender);
+        }
+    }
+
+    const bool isRendered = activeRender != nullptr && activeRender->key == key && activeRender->generation == generation;
+    const bool canPlayLoop = isCacheable && isRendered && activeRender->isPlayable;
+    if (!isPlayingLoop && canPlayLoop && blockStart >= activeRender->loopStart)
+    {
+        //the live engine stops here, everything it would have played from now on is in the loop
+        isPlayingLoop = true;
+    }
+    if (!isPlayingLoop && isCacheable && !isRendered && isWorkerIdle)
+    {
+        takeSnapshot(engine, key, blockStart);
+    }
+
+    const int numSamples = routing.main.getNumSamples();
+    int startSample = 0;
+    while (startSample < numSamples)
+    {
+        if (!isPlayingLoop)
+        {
+            scheduledClicks.beginBlock(blockStart + startSample, isAnalyzing);
+            if (startSample == 0)
+            {
+                engine.getNextAudioBlock(routing, midiMessages);
+            }
+            else
+            {
+                //the rest of a block the loop handed back part way through
+                OutputRouting<SampleType> piece;
+                piece.referToPartOf(routing, startSample, numSamples - startSample);
+                pieceMidi.clear();
+                engine.getNextAudioBlock(piece, pieceMidi);
+                midiMessages.addEvents(pieceMidi, 0, -1, startSample);
+            }
+            break;
+        }
+
+        const auto& render = *activeRender;
+        const juce::int64 phase = (blockStart + startSample - render.loopStart) % render.cycleLength;
+        int pieceSize = numSamples - startSample;
+        if (!canPlayLoop)
+        {
+            //something changed, the loop plays on to the next point the live engine's state was captured at
+            if (phase % render.captureInterval == 0)
+            {
+                //the capture's voices hold the samples of the kit the loop was rendered with, the live engine goes back to the current one
+                engine.copyStateFrom(*render.captures[(size_t)(phase / render.captureInterval)]);
+                engine.useKit(kit);
+                isPlayingLoop = false;
+                continue;
+            }
+            const juce::int64 nextCapture = juce::jmin<juce::int64>(render.cycleLength, (phase / render.captureInterval + 1) * render.captureInterval);
+            pieceSize = (int)juce::jmin<juce::int64>(pieceSize, nextCapture - phase);
+        }
+        playLoop(routing, midiMessages, startSample, pieceSize, phase, blockStart, isAnalyzing);
+        startSample += pieceSize;
+    }
+}
+
+template <typename SampleType>
+void LoopCache::playLoop(OutputRouting<SampleType>& routing, juce::MidiBuffer& midiMessages, int startSample, int numSamples, juce::int64 phase, juce::int64 blockStart, bool isAnalyzing)
+{
+    auto& render = *activeRender;
+    const auto& loop = render.getLoop<SampleType>();
+    scheduledClicks.beginBlock(blockStart, isAnalyzing);
+
+    //the piece is cut where it wraps past the end of the cycle
+    int done = 0;
+    int position = (int)phase;
+    while (done < numSamples)
+    {
+        const int segmentSize = juce::jmin(numSamples - done, render.cycleLength - position);
+        const int destStart = startSample + done;
+        for (int channel = 0; channel < routing.main.getNumChannels(); channel++)
+        {
+            routing.main.addFrom(channel, destStart, loop, channel % loop.getNumChannels(), position, segmentSize);
+        }
+
+        auto midiEvent = std::lower_bound(render.midi.begin(), render.midi.end(), position, [](const LoopRender::MidiEvent& event, int value) { return event.position < value; });
+        for (; midiEvent != render.midi.end() && midiEvent->position < position + segmentSize; ++midiEvent)
+        {
+            midiMessages.addEvent(midiEvent->message, destStart + midiEvent->position - position);
+        }
+
+        auto click = std::lower_bound(render.clicks.begin(), render.clicks.end(), position, [](const ScheduledClick& scheduled, int value) { return scheduled.samplePosition < value; });
+        for (; click != render.clicks.end() && click->samplePosition < position + segmentSize; ++click)
+        {
+            scheduledClicks.push(destStart + (int)click->samplePosition - position, click->voice, click->step);
+        }
+
+        done += segmentSize;
+        position = (position + segmentSize) % render.cycleLength;
+    }
+
+    //the counters the engine would have shown at the end of the piece
+    const int endPosition = position == 0 ? render.cycleLength : position;
+    auto change = std::upper_bound(render.display.begin(), render.display.end(), endPosition, [](int value, const LoopRender::DisplayChange& displayChange) { return value < displayChange.position; });
+    if (change != render.display.begin())
+    {
+        --change;
+        displayState.counter1.store(change->counter1, std::memory_order_relaxed);
+        displayState.counter2.store(change->counter2, std::memory_order_relaxed);
+    }
+}
+
+template void LoopCache::process<float>(RhythmEngine&, const ClickKit&, OutputRouting<float>&, juce::MidiBuffer&, const LoopKey&, bool, juce::int64, bool);
+template void LoopCache::process<double>(RhythmEngine&, const ClickKit&, OutputRouting<double>&, juce::MidiBuffer&, const LoopKey&, bool, juce::int64, bool);
+
+void LoopCache::takeSnapshot(RhythmEngine& engine, const LoopKey& key, juce::int64 blockStart)
+{
+    //audio thread, only copies, the worker does the rendering
+    request.key = key;
+    request.generation = generation;
+    request.snapshotTime = blockStart;
+    request.config = rhythmConfigs.getActive();
+    request.patterns = stepPatterns.getActive();
+    snapshotEngines[(size_t)key.mode]->copyStateFrom(engine);
+    requestState.store(requested, std::memory_order_release);
+}
+
+void LoopCache::run()
+{
+    while (!threadShouldExit())
+    {
+        delete retiredRender.exchange(nullptr);
+
+        if (requestState.load(std::memory_order_acquire) == requested)
+        {
+            if (auto render = renderRequest())
+            {
+                //a loop the audio thread hasn't taken yet is out of date now
+                delete pendingRender.exchange(render.release());
+            }
+            requestState.store(idle, std::memory_order_release);
+        }
+        wait(workerIntervalMs);
+    }
+}
+
+std::unique_ptr<LoopRender> LoopCache::renderRequest()
+{
+    auto render = std::make_unique<LoopRender>();
+    render->key = request.key;
+    render->generation = request.generation;
+
+    auto& engine = *snapshotEngines[(size_t)request.key.mode];
+    loopConfigs.publish(request.config);
+    loopConfigs.acquire();
+    loopPatterns.publish(request.patterns);
+    loopPatterns.acquire();
+
+    //a step with a probability rolls differently every bar, so the output never repeats
+    bool isRepeating = true;
+    for (const auto& lanes : request.patterns.lanes)
+    {
+        isRepeating = isRepeating && std::all_of(lanes.probability.begin(), lanes.probability.end(), [](float probability) { return probability >= 1.0f; });
+    }
+    const juce::int64 cycleLength = engine.getCycleLength();
+    if (!isRepeating || cycleLength <= 0 || cycleLength > (juce::int64)(maxLoopSeconds * sampleRate))
+    {
+        return render;
+    }
+
+    //the copy takes up to a cycle to settle into its repeating state (counters that were mid bar, a config that just swapped in)
+    const juce::int64 warmUp = cycleLength + (juce::int64)(warmUpSeconds * sampleRate);
+    render->loopStart = request.snapshotTime + warmUp;
+    render->cycleLength = (int)cycleLength;
+    render->captureInterval = juce::jmax(blockSize, (int)((cycleLength + maxCaptures - 1) / maxCaptures));
+    if (request.key.isDouble)
+    {
+        renderLoop<double>(engine, *render, warmUp);
+    }
+    else
+    {
+        renderLoop<float>(engine, *render, warmUp);
+    }
+
+    if (!request.key.matchesParameters(apvts))
+    {
+        //a param the engine reads itself moved while it ran, the audio thread asks again with the new settings
+        return nullptr;
+    }
+    render->isPlayable = true;
+    return render;
+}
+
+template <typename SampleType>
+void LoopCache::renderLoop(RhythmEngine& engine, LoopRender& render, juce::int64 warmUp)
+{
+    const int numChannels = juce::jmax(1, render.key.numChannels);
+    auto& loop = render.getLoop<SampleType>();
+    loop.setSize(numChannels, render.cycleLength);
+    loop.clear();
+    render.captures.reserve((size_t)(render.cycleLength / render.captureInterval + 1));
+
+    juce::AudioBuffer<SampleType> block(numChannels, blockSize);
+    juce::MidiBuffer blockMidi;
+    std::array<ScheduledClick, 64> clicks;
+    const juce::int64 loopEnd = warmUp + render.cycleLength;
+    auto isInLoop = [warmUp, loopEnd](juce::int64 position) { return position >= warmUp && position < loopEnd; };
+
+    juce::int64 position = 0;
+    while (position < loopEnd)
+    {
+        //blocks also end on the loop start and every capture point, so the engine's state can be copied between them
+        if (position >= warmUp && (position - warmUp) % render.captureInterval == 0)
+        {
+            auto capture = RhythmEngine::createForMode(render.key.mode, &apvts, &loopConfigs, &loopPatterns, &loopDisplay, &loopClicks);
+            capture->copyStateFrom(engine);
+            render.captures.push_back(std::move(capture));
+        }
+        const juce::int64 nextStop = position < warmUp ? warmUp : warmUp + ((position - warmUp) / render.captureInterval + 1) * render.captureInterval;
+        const int numSamples = (int)juce::jmin<juce::int64>(blockSize, nextStop - position, loopEnd - position);
+
+        block.clear();
+        blockMidi.clear();
+        OutputRouting<SampleType> routing;
+        routing.main = juce::AudioBuffer<SampleType>(block.getArrayOfWritePointers(), numChannels, 0, numSamples);
+        loopClicks.beginBlock(position, true);
+        engine.getNextAudioBlock(routing, blockMidi);
+
+        const juce::int64 copyStart = juce::jmax(position, warmUp);
+        if (copyStart < position + numSamples)
+        {
+            for (int channel = 0; channel < numChannels; channel++)
+            {
+                loop.copyFrom(channel, (int)(copyStart - warmUp), block, channel, (int)(copyStart - position), (int)(position + numSamples - copyStart));
+            }
+        }
+        for (const auto metadata : blockMidi)
+        {
+            //note offs can fall past the block, they still go where they land in the cycle
+            const juce::int64 eventPosition = position + metadata.samplePosition;
+            if (isInLoop(eventPosition))
+            {
+                render.midi.push_back({ (int)(eventPosition - warmUp), metadata.getMessage() });
+            }
+        }
+        int numClicks;
+        while ((numClicks = loopClicks.pop(clicks.data(), (int)clicks.size())) > 0)
+        {
+            for (int i = 0; i < numClicks; i++)
+            {
+                if (isInLoop(clicks[(size_t)i].samplePosition))
+                {
+                    render.clicks.push_back({ clicks[(size_t)i].samplePosition - warmUp, clicks[(size_t)i].voice, clicks[(size_t)i].step });
+                }
+            }
+        }
+
+        position += numSamples;
+        if (position >= warmUp)
+        {
+            const int counter1 = loopDisplay.counter1.load(std::memory_order_relaxed);
+            const int counter2 = loopDisplay.counter2.load(std::memory_order_relaxed);
+            if (render.display.empty() || render.display.back().counter1 != counter1 || render.display.back().counter2 != counter2)
+            {
+                render.display.push_back({ (int)(position - warmUp), counter1, counter2 });
+            }
+        }
+    }
+
+    std::stable_sort(render.midi.begin(), render.midi.end(), [](const LoopRender::MidiEvent& a, const LoopRender::MidiEvent& b) { return a.position < b.position; });
+    std::stable_sort(render.clicks.begin(), render.clicks.end(), [](const ScheduledClick& a, const ScheduledClick& b) { return a.samplePosition < b.samplePosition; });
+}
@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    LoopCache.h
+    Created: 19 Oct 2026 11:12:37pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Utilities.h"
+#include "RhythmConfig.h"
+#include "RhythmEngine.h"
+#include "StepPattern.h"
+
+//everything a loop depends on, a loop is only played while the settings it was rendered with are still the current ones
+struct LoopKey
+{
+    bool operator==(const LoopKey& other) const
+    {
+        return std::tie(mode, numerator, subdivisions, bpm, swing, rotate1, rotate2, patternsSerial, kitSerial, clickDelay, numChannels, isDouble)
+            == std::tie(other.mode, other.numerator, other.subdivisions, other.bpm, other.swing, other.rotate1, other.rotate2, other.patternsSerial, other.kitSerial, other.clickDelay, other.numChannels, other.isDouble);
+    }
+    bool operator!=(const LoopKey& other) const { return !(*this == other); }
+
+    //true while the params the engines read themselves still hold what the key was made from
+    bool matchesParameters(juce::AudioProcessorValueTreeState& apvts) const;
+
+    int mode = -1;
+    int numerator = 0;
+    int subdivisions = 0;
+    float bpm = 0;
+    float swing = 0;
+    float rotate1 = 0;
+    float rotate2 = 0;
+    juce::uint32 patternsSerial = 0; //counts the step patterns the audio thread picked up
+    juce::uint32 kitSerial = 0; //counts the click kits the audio thread swapped in
+    int clickDelay = 0;
+    int numChannels = 0; //main bus
+    bool isDouble = false; //host precision
+};
+
+//one cycle of an engine's output (a bar, or the cycle after which both polymeter rhythms line up again), rendered ahead on the worker thread
+struct LoopRender
+{
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType>& getLoop()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+        {
+            return doubleLoop;
+        }
+        else
+        {
+            return floatLoop;
+        }
+    }
+
+    struct MidiEvent
+    {
+        int position = 0; //in the cycle
+        juce::MidiMessage message;
+    };
+
+    struct DisplayChange
+    {
+        int position = 0; //in the cycle, the counters the editor shows from here on
+        int counter1 = 0;
+        int counter2 = 0;
+    };
+
+    LoopKey key;
+    int generation = 0; //LoopCache::restart count the snapshot was taken in
+    bool isPlayable = false; //false when the output doesn't repeat (probability lanes) or the cycle is too long, kept so it isn't asked for again
+    juce::int64 loopStart = 0; //processor sample position the loop's first sample lines up with, every cycle after it is the same
+    int cycleLength = 0;
+    int captureInterval = 0; //captures are taken every this many samples from the cycle start
+
+    juce::AudioBuffer<float> floatLoop; //only the host's precision is rendered
+    juce::AudioBuffer<double> doubleLoop;
+    std::vector<MidiEvent> midi; //sorted by position
+    std::vector<ScheduledClick> clicks; //samplePosition is the position in the cycle
+    std::vector<DisplayChange> display; //sorted by position, the first is at 0
+    std::vector<std::unique_ptr<RhythmEngine>> captures; //the engine's state at each capture point, for handing the output back to the live engine
+};
+
+//plays a pre-rendered cycle instead of running the engine while tempo, meter, steps and samples stay the same
+//when the settings settle the audio thread copies the live engine's state into a spare engine, the worker runs that copy on
+//until its output repeats and keeps one cycle of audio, MIDI, scheduled clicks and display counters, plus the engine's state at a few points in it
+//the live engine plays until the loop is ready and then stops, from there each block is a wrapped vector add out of the loop at the current phase
+//when anything changes the loop plays on to its next capture point, the live engine gets the state from there and carries on, so neither handover is heard
+//only for the engine's own clock, a playing host or the tempo follower drive the engines by position and always render live
+class LoopCache : private juce::Thread
+{
+public:
+    LoopCache(juce::AudioProcessorValueTreeState& _apvts, RhythmConfigExchange& _rhythmConfigs, StepPatternExchange& _stepPatterns, EngineDisplayState& _displayState, ScheduledClickQueue& _scheduledClicks);
+    ~LoopCache() override;
+
+    //message thread, while audio is stopped, (re)starts the worker
+    void prepare(double _sampleRate, int _blockSize);
+
+    //audio thread, the live engine was reset or skipped a block, a loop rendered from an earlier snapshot no longer lines up with it
+    void restart()
+    {
+        generation++;
+        isPlayingLoop = false;
+    }
+
+    //audio thread, renders the block from the loop where it can and from the engine otherwise
+    //isCacheable is false while the engine isn't on its own clock, a config is waiting for its boundary or a sound has its own aux bus
+    //blockStart is in the same count as the scheduled clicks, kit is the one the live engine plays, instantiated for float and double in the .cpp
+    template <typename SampleType>
+    void process(RhythmEngine& engine, const ClickKit& kit, OutputRouting<SampleType>& routing, juce::MidiBuffer& midiMessages, const LoopKey& key, bool isCacheable, juce::int64 blockStart, bool isAnalyzing);
+
+private:
+    void run() override;
+    std::unique_ptr<LoopRender> renderRequest();
+    template <typename SampleType>
+    void renderLoop(RhythmEngine& engine, LoopRender& render, juce::int64 warmUp);
+    void takeSnapshot(RhythmEngine& engine, const LoopKey& key, juce::int64 blockStart);
+    template <typename SampleType>
+    void playLoop(OutputRouting<SampleType>& routing, juce::MidiBuffer& midiMessages, int startSample, int numSamples, juce::int64 phase, juce::int64 blockStart, bool isAnalyzing);
+
+    static constexpr int maxCaptures = 64;
+
+    juce::AudioProcessorValueTreeState& apvts;
+    RhythmConfigExchange& rhythmConfigs; //the processor's, only their active values are read (audio thread)
+    StepPatternExchange& stepPatterns;
+    EngineDisplayState& displayState;
+    ScheduledClickQueue& scheduledClicks;
+    double sampleRate = 44100;
+    int blockSize = 512;
+
+    //the snapshot the audio thread hands the worker, written by the audio thread while requestState is idle and by nobody while it's requested
+    enum RequestState { idle, requested };
+    std::atomic<int> requestState{ idle };
+    struct Request
+    {
+        LoopKey key;
+        int generation = 0;
+        juce::int64 snapshotTime = 0;
+        RhythmConfig config;
+        StepPatterns patterns;
+    };
+    Request request;
+    std::array<std::unique_ptr<RhythmEngine>, 3> snapshotEngines; //one per mode, built with the worker's own exchanges below
+
+    //worker thread only, what the snapshot engines and captures read and write instead of the processor's
+    RhythmConfigExchange loopConfigs;
+    StepPatternExchange loopPatterns;
+    EngineDisplayState loopDisplay;
+    ScheduledClickQueue loopClicks;
+
+    //finished loops come and go like the processor's engines, the worker deletes the retired ones
+    std::unique_ptr<LoopRender> activeRender; //audio thread
+    std::atomic<LoopRender*> pendingRender{ nullptr };
+    std::atomic<LoopRender*> retiredRender{ nullptr };
+
+    //audio thread
+    int generation = 0;
+    bool isPlayingLoop = false;
+    juce::MidiBuffer pieceMidi; //MIDI of the live part of a block that is split
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoopCache)
+};
@@ -11,149 +11,142 @@
 #include "Metronome.h"
 #include <JuceHeader.h>
 
-Metronome::Metronome()
+Metronome::Metronome(juce::AudioProcessorValueTreeState* _apvts, RhythmConfigExchange* _rhythmConfigs, StepPatternExchange* _stepPatterns, EngineDisplayState* _displayState, ScheduledClickQueue* _scheduledClicks)
+    : RhythmEngine(_apvts, _rhythmConfigs, _stepPatterns, _displayState, _scheduledClicks)
 {
-}
-
-
-Metronome::Metronome(juce::AudioProcessorValueTreeState* _apvts)
-{
-    apvts = _apvts;  
+    useRenderLoopsOf<Metronome>();
     resetAll();
-    formatManager.registerBasicFormats();
-
-    juce::MemoryInputStream* inputStream = new juce::MemoryInputStream(BinaryData::rimshot_low_wav, BinaryData::rimshot_low_wavSize, false);
-    juce::WavAudioFormat wavFormat;
-    juce::AudioFormatReader* formatReader = wavFormat.createReaderFor(inputStream, false);
-    rimShotLow.reset(new juce::AudioFormatReaderSource(formatReader, true));
-
-    juce::MemoryInputStream* inputStream2 = new juce::MemoryInputStream(BinaryData::rimshot_high_wav, BinaryData::rimshot_high_wavSize, false);
-    juce::WavAudioFormat wavFormat2;
-    juce::AudioFormatReader* formatReader2 = wavFormat2.createReaderFor(inputStream2, false);
-    rimShotHigh.reset(new juce::AudioFormatReaderSource(formatReader2, true));
-    
-    juce::MemoryInputStream* inputStream3 = new juce::MemoryInputStream(BinaryData::rimshot_sub_wav, BinaryData::rimshot_sub_wavSize, false);
-    juce::WavAudioFormat wavFormat3;
-    juce::AudioFormatReader* formatReader3 = wavFormat3.createReaderFor(inputStream3, false);
-    rimShotSub.reset(new juce::AudioFormatReaderSource(formatReader3, true));
-    
 }
 
 
 void Metronome::prepareToPlay(double _sampleRate, int samplesPerBlock)
 {
 //preparetoplay should call every time we start (right before)
-
-    resetParams();
+//params are read by resetParams once the engine is running on the audio thread
 
     if (sampleRate != _sampleRate)
     {
         //if the audioprocessors samplerate hasn't changed, nothing else needs to be done
         sampleRate = _sampleRate;
-        if (rimShotLow != nullptr)
-        {
-            rimShotLow->prepareToPlay(samplesPerBlock, sampleRate);
-        }
-        if (rimShotHigh != nullptr)
-        {
-            rimShotHigh->prepareToPlay(samplesPerBlock, sampleRate);
-        }
-        if (rimShotSub != nullptr)
-        {
-            rimShotSub->prepareToPlay(samplesPerBlock, sampleRate);
-        }
+        //the clicks are decoded once per sample rate and shared by every engine in the process
+        rimShotLow.setSample(sampleCache->getSample(ClickSampleId::rimShotLow, sampleRate));
+        rimShotHigh.setSample(sampleCache->getSample(ClickSampleId::rimShotHigh, sampleRate));
+        rimShotSub.setSample(sampleCache->getSample(ClickSampleId::rimShotSub, sampleRate));
     }
 
 }
 
 
 
-void Metronome::getNextAudioBlock(juce::AudioBuffer<float>& buffer)
+void Metronome::processEvents(int bufferSize)
 {
- //TODO cache calculations for less processing?
-   
+    auto quantization = (ConfigQuantization)(int)apvts->getRawParameterValue("QUANTIZE")->load();
+    if (quantization == ConfigQuantization::immediate)
+    {
+        rhythmConfigs->acquire();
+    }
     resetParams();
-    bool isDawConnected = apvts->getRawParameterValue("DAW_CONNECTED")->load();
     bool isDawPlaying = apvts->getRawParameterValue("DAW_PLAYING")->load();
 
-    //TODO: fix bug instead of this bandaid for sync issues (maybe this has been fixed with commit 1957bb6)
-    if (subdivisionCounter > subdivisions)
-        subdivisionCounter = subdivisions;
-
-    //temp wrapper because <juce::AudioFormatReaderSource>->getNextAudioBlock expects an AudioSourceChannelInfoObject
-    auto audiosourcechannelinfo = juce::AudioSourceChannelInfo(buffer);
-    auto bufferSize = buffer.getNumSamples();
-    if (!isDawConnected && !isDawPlaying) {
-        totalSamples += bufferSize;
-    }
-    else {
-        totalSamples = ((int)apvts->getRawParameterValue("DAW_SAMPLES_ELAPSED")->load() % (int)samplesPerBar) + (int)bufferSize;
+    juce::int64 blockStart = totalSamples;
+    if (isDawPlaying)
+    {
+        //the host (or a song section, or the leader) places the block, the counts are worked out from its position
+        //so a seek or a loop lands on the beat it would have reached by playing there
+        blockStart = (juce::int64)apvts->getRawParameterValue("DAW_SAMPLES_ELAPSED")->load();
+        const juce::int64 beatsBefore = (blockStart + beatInterval - 1) / beatInterval;
+        beatCounter = beatsBefore == 0 ? 0 : (int)((beatsBefore - 1) % numerator) + 1;
+        barCounter = (juce::uint32)((beatsBefore + numerator - 1) / numerator);
     }
-    samplesProcessed = totalSamples % beatInterval;
-    subSamplesProcessed = totalSamples % subInterval;
-
-    
-     if (subdivisions > 1 && subSamplesProcessed + bufferSize >= subInterval && subdivisionCounter != subdivisions)
-     {// subdivision logic
-        const auto timeToStartPlaying = subInterval - subSamplesProcessed;
-        rimShotSub->setNextReadPosition(0); //reset sample to beginning
-        for (auto samplenum = 0; samplenum < bufferSize + 1; samplenum++)
-        { 
-            if (samplenum == timeToStartPlaying)
-            {
-                rimShotSub->getNextAudioBlock(audiosourcechannelinfo);
-            }
+    const juce::int64 blockEnd = blockStart + bufferSize;
+
+    //every beat and subdivision starting in [blockStart, blockEnd) plays at its own sample, from the beat that was already running
+    //when the block started, its subdivisions and tuplet events can still fall in this block, a beat with a tuplet tree has no subdivisions of its own
+    const auto& tuplets = stepPatterns->getActive().tuplets;
+    for (juce::int64 beat = (blockStart + beatInterval - 1) / beatInterval - 1; beat * beatInterval < blockEnd; beat++)
+    {
+        const juce::int64 beatStart = beat * beatInterval;
+        if (beatStart >= blockStart)
+        {
+            playBeat((int)(beatStart - blockStart), quantization);
         }
-        subdivisionCounter += 1;
-     }
-     else if (samplesProcessed + bufferSize >= beatInterval)
-     { 
-        const auto timeToStartPlaying = beatInterval - samplesProcessed;
-        if (beatCounter >= numerator) //check if its the first beat of the bar
+        else if (beatCounter == 0)
         {
-            rimShotHigh->setNextReadPosition(0); //reset sample to beginning
-            for (auto samplenum = 0; samplenum < bufferSize + 1; samplenum++)
-            {
-                if (samplenum == timeToStartPlaying)
-                {
-                    rimShotHigh->getNextAudioBlock(audiosourcechannelinfo);
-                }
-            }
-            beatCounter = 1; 
+            continue; //nothing is running before the first beat
+        }
+
+        const int runningBeat = beatCounter - 1;
+        if (tuplets.hasTree(runningBeat))
+        {
+            playTupletEvents(tuplets, runningBeat, (int)(beatStart - blockStart), bufferSize);
+            continue;
         }
-        else 
+        for (int subdivision = 1; subdivision < subdivisions; subdivision++)
         {
-            //regular beat logic
-            rimShotLow->setNextReadPosition(0); //reset sample to beginning
-            for (auto samplenum = 0; samplenum < bufferSize + 1; samplenum++)
+            const juce::int64 subdivisionStart = beatStart + (juce::int64)subdivision * subInterval;
+            if (subdivisionStart >= blockStart && subdivisionStart < blockEnd)
             {
-                if (samplenum == timeToStartPlaying)
-                {
-                    rimShotLow->getNextAudioBlock(audiosourcechannelinfo);
-                }
+                playSubdivision(subdivision, (int)(subdivisionStart - blockStart));
             }
-            beatCounter += 1;
-            //non-one main beat
         }
-        subdivisionCounter = 1;
     }
 
+    if (!isDawPlaying)
+    {
+        //samplesPerBar is whole beats, wrapping never moves the grid
+        totalSamples = (int)(blockEnd % samplesPerBar);
+    }
+
+    displayState->counter1.store(beatCounter, std::memory_order_relaxed);
+    displayState->counter2.store(subdivisionCounter, std::memory_order_relaxed);
+}
 
- /* if the read pointer is not 0, reading was interupted for some reason
- 
- if (rimShotHigh->getNextReadPosition() != 0)
- {
-     rimShotHigh->getNextAudioBlock(temp);
+void Metronome::playBeat(int timeToStartPlaying, ConfigQuantization quantization)
+{
+    const bool isFirstBeat = beatCounter == 0 || beatCounter >= numerator;
+    if (rhythmConfigs->hasPending() && (quantization == ConfigQuantization::nextBeat || (quantization == ConfigQuantization::nextBar && isFirstBeat)))
+    {   //this beat is the quantized boundary, the pending config takes over from here
+        rhythmConfigs->acquire();
+        resetParams();
+    }
+    if (isFirstBeat) //check if its the first beat of the bar
+    {
+        barCounter += 1;
+        //rhythm1's steps are the beats of the bar, step 0 is the first beat
+        float level = getLaneLevel(0, 0, numerator, barCounter);
+        if (level > 0)
+        {
+            playClick(rimShotHigh, timeToStartPlaying + getGrooveOffset(0, 0), level);
+            reportClick(timeToStartPlaying + getGrooveOffset(0, 0), 0, 0);
+        }
+        beatCounter = 1;
+    }
+    else
+    {
+        //regular beat logic
+        float level = getLaneLevel(0, beatCounter, numerator, barCounter);
+        if (level > 0)
+        {
+            playClick(rimShotLow, timeToStartPlaying + getGrooveOffset(0, beatCounter), level);
+            reportClick(timeToStartPlaying + getGrooveOffset(0, beatCounter), 0, beatCounter);
+        }
+        beatCounter += 1;
+    }
+    subdivisionCounter = 1;
+}
 
- }
- else if (rimShotLow->getNextReadPosition() != 0)          
+void Metronome::playSubdivision(int subdivision, int timeToStartPlaying)
+{
+    //the groove moves the click off the grid, the counting stays on it
+    //rhythm2's steps are the subdivisions of a beat
+    const auto time = timeToStartPlaying + getGrooveOffset(1, subdivision);
+    float level = getLaneLevel(1, subdivision, subdivisions, barCounter);
+    if (level > 0)
     {
-        rimShotLow->getNextAudioBlock(temp);
+        playClick(rimShotSub, time, level);
+        reportClick(time, 1, subdivision);
     }
-    */
-     if (totalSamples >= samplesPerBar && !isDawPlaying) {
-         totalSamples = totalSamples - samplesPerBar;
-     }
+    subdivisionCounter = subdivision + 1;
 }
 
 
@@ -161,19 +154,77 @@ void Metronome::getNextAudioBlock(juce::AudioBuffer<float>& buffer)
 void Metronome::resetAll() 
 {   //this should be called whenever the metronome is stopped
     totalSamples = 0;
+    barCounter = 0;
     beatCounter = 0;
     subdivisionCounter = subdivisions;
-    samplesProcessed = 0;
-    subSamplesProcessed = 0;
 }
 
 
 void Metronome::resetParams()
 {  //this should be called whenever the processor changes a parameter (which should only happen when the user interacts with the GUI)
-    numerator = apvts->getRawParameterValue("NUMERATOR")->load();
-    subdivisions = apvts->getRawParameterValue("SUBDIVISION")->load();
+   //numerator and subdivisions come from the active config, they only change when the audio thread swaps a pending config in
+    const auto& config = rhythmConfigs->getActive();
+    numerator = config.numerator;
+    subdivisions = config.subdivisions;
+    displayState->length1.store(numerator, std::memory_order_relaxed);
+    displayState->length2.store(subdivisions, std::memory_order_relaxed);
     bpm = apvts->getRawParameterValue("BPM")->load();
-    beatInterval = (60.0 / bpm) * sampleRate;
+    const int previousBeatInterval = beatInterval;
+    beatInterval = juce::jmax(1, (int)((60.0 / bpm) * sampleRate));
+    if (beatInterval != previousBeatInterval)
+    {
+        //a new tempo keeps the own clock at the same point of the bar, a beat that was due stays due
+        totalSamples = (int)((juce::int64)totalSamples * beatInterval / previousBeatInterval);
+    }
     subInterval = beatInterval / subdivisions;
-    samplesPerBar = 4 * ((60.0 / bpm) * sampleRate);    //4 * because we have 4 beats in a bar
-}
\ No newline at end of file
+    samplesPerBar = 4 * beatInterval;    //4 * because we have 4 beats in a bar, whole beats so wrapping the bar never shifts the beat grid
+
+    //beats are whole intervals apart already, the subdivisions' table also evens out what subInterval rounds off
+    updateGroove(0, (double)numerator * beatInterval, numerator, beatInterval, false);
+    updateGroove(1, beatInterval, subdivisions, subInterval, true);
+    tupletOffsets.update(stepPatterns->getActive().tuplets, beatInterval);
+}
+
+void Metronome::playTupletEvents(const TupletPattern& tuplets, int beat, int beatStart, int bufferSize)
+{
+    for (int event = tuplets.getFirstEvent(beat); event < tuplets.getEndEvent(beat); event++)
+    {
+        const int timeToStartPlaying = beatStart + tupletOffsets.getOffset(event);
+        const auto& tupletEvent = tuplets.events[(size_t)event];
+        if (timeToStartPlaying < 0 || timeToStartPlaying >= bufferSize || tupletEvent.velocity <= 0)
+        {
+            continue;
+        }
+        auto& voice = tupletEvent.sound == (int)ClickSampleId::rimShotHigh ? rimShotHigh : tupletEvent.sound == (int)ClickSampleId::rimShotLow ? rimShotLow : rimShotSub;
+        playClick(voice, timeToStartPlaying, tupletEvent.velocity);
+        //the events of a beat count as rhythm2's steps for the timing analysis
+        reportClick(timeToStartPlaying, 1, event - tuplets.getFirstEvent(beat));
+    }
+}
+
+juce::int64 Metronome::getCycleLength() const
+{
+    //the accent and both lanes repeat every numerator beats, the count doesn't depend on where samplesPerBar wraps the clock
+    return (juce::int64)numerator * beatInterval;
+}
+
+void Metronome::copyStateFrom(const RhythmEngine& other)
+{
+    const auto& source = static_cast<const Metronome&>(other);
+    copyBaseStateFrom(source);
+    numerator = source.numerator;
+    subdivisions = source.subdivisions;
+    samplesPerBar = source.samplesPerBar;
+    bpm = source.bpm;
+    totalSamples = source.totalSamples;
+    sampleRate = source.sampleRate;
+    beatInterval = source.beatInterval;
+    beatCounter = source.beatCounter;
+    barCounter = source.barCounter;
+    subInterval = source.subInterval;
+    subdivisionCounter = source.subdivisionCounter;
+    tupletOffsets = source.tupletOffsets;
+    rimShotHigh = source.rimShotHigh;
+    rimShotLow = source.rimShotLow;
+    rimShotSub = source.rimShotSub;
+}
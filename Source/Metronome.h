@@ -11,26 +11,52 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "RhythmEngine.h"
+#include "ClickSampleCache.h"
 
-class Metronome 
+//Default mode engine
+class Metronome final : public RhythmEngine
 {
     public:
-        Metronome();
-        Metronome(juce::AudioProcessorValueTreeState* _apvts);
+        Metronome(juce::AudioProcessorValueTreeState* _apvts, RhythmConfigExchange* _rhythmConfigs, StepPatternExchange* _stepPatterns, EngineDisplayState* _displayState, ScheduledClickQueue* _scheduledClicks);
+
+        void prepareToPlay(double _sampleRate, int samplesPerBlock) override;
+        void resetAll() override;
+        void resetParams() override;
+        int getMode() const override { return 0; }
+        double getSampleRate() const override { return sampleRate; }
+        juce::int64 getCycleLength() const override;
+        double getSamplesPerBeat() const override { return (double)beatInterval; }
+        void copyStateFrom(const RhythmEngine& other) override;
+        int getNumActiveVoices() const override { return (int)rimShotHigh.isActive() + (int)rimShotLow.isActive() + (int)rimShotSub.isActive(); }
+        void useKit(const ClickKit& kit) override
+        {
+            rimShotHigh.switchSample(kit.getSample(ClickSampleId::rimShotHigh));
+            rimShotLow.switchSample(kit.getSample(ClickSampleId::rimShotLow));
+            rimShotSub.switchSample(kit.getSample(ClickSampleId::rimShotSub));
+        }
+
+        template <int NumChannels, typename SampleType>
+        void renderBlock(OutputRouting<SampleType>& routing, juce::MidiBuffer& midiBuffer)
+        {
+            processEvents(routing.main.getNumSamples());
+            //clicks that were triggered this block or are still ringing from earlier ones
+            routing.renderVoice<NumChannels>(rimShotHigh, ClickSampleId::rimShotHigh);
+            routing.renderVoice<NumChannels>(rimShotLow, ClickSampleId::rimShotLow);
+            routing.renderVoice<NumChannels>(rimShotSub, ClickSampleId::rimShotSub);
+        }
 
-        void prepareToPlay(double _sampleRate, int samplesPerBlock);
-        void getNextAudioBlock(juce::AudioBuffer<float>& buffer);
-        void resetAll();
-        void resetParams();
         int getNumerator() {return numerator;}
         int getSubdivisions() {return subdivisions;}
         int getBPM() { return bpm;}
         int getBeatCounter() { return beatCounter;}
         int getSubdivisionCounter() {return subdivisionCounter;}
-        float getSamplesProcessed() { return samplesProcessed; }
-        float getSubSamplesProcessed() { return subSamplesProcessed; }
 
     private:
+        void processEvents(int bufferSize);
+        void playBeat(int timeToStartPlaying, ConfigQuantization quantization);
+        void playSubdivision(int subdivision, int timeToStartPlaying);
+        void playTupletEvents(const TupletPattern& tuplets, int beat, int beatStart, int bufferSize);
 
         /*
        sampleRate gives us the amount of samples (in our incoming audio buffers) per second
@@ -38,14 +64,10 @@ class Metronome
        beatInterval = (60.0 / bpm) * sampleRate;
        we can then calculate the amount of samples representing a subdivision of that beat
        subInterval = beatInterval / #subdivisions;
-       every time we process an audio block we increment totalSamples by the amount of samples incoming
-       totalSamples += bufferSize;
-       samplesProcessed = totalSamples % beatInterval;
-       if we have processed more samples than the amount of samples representing one beat (or one subdivision if subdivisions are turned on,
-       we play a sound depending on what triggered the sound event
-       based on subdivisionCounter, beatCounter
-       //subdivisionCounter keeps count of which subdivision we're on, +=1 when subdivision click is played, reset to 1 when main beat is finished
-       //beatCounter signals a first beat of bar when beatCounter = numerator, +=1 every main beat, reset to 1 after a bar
+       totalSamples is where the next block starts, beat k starts at k * beatInterval and its subdivisions every subInterval after that,
+       every beat and subdivision that starts inside the block is played at its own sample, however the host cuts the blocks
+       //subdivisionCounter is the subdivision that played last, 1 for the beat itself
+       //beatCounter is the beat of the bar that played last, from 1 to numerator, 0 before the first one
        */
 
        //User params, which change when the sliders are moved
@@ -55,28 +77,27 @@ class Metronome
         double bpm = 60;
 
         //overall logic variables
-        int totalSamples = 0; //total samples since start time
+        int totalSamples = 0; //where the next block starts on the engine's own clock, wraps every samplesPerBar
         double sampleRate = 0; //sampleRate from app, usually 44100
 
         //beat logic variables
         int beatInterval = 1; //interval representing one beat click = (60.0 / bpm) * sampleRate
-        int samplesProcessed = 1; // samples processed before beat = totalSamples % interval
-        int beatCounter = numerator;  //beatCounter signals a first beat of bar when beatCounter = numerator, +=1 every main beat, reset to 1 after a bar
+        int beatCounter = 0;  //beat of the bar that played last, the next beat is the first of a bar when beatCounter is 0 or numerator
+
+        juce::uint32 barCounter = 0; //bars played since start, seeds the probability rolls
 
         //subdivision logic variables
         int subInterval = 0; //subInterval is beatInterval/subdivisions 
-        int subSamplesProcessed = 0; /// samples processed before subbeat= totalSamples % subInterval;
-        int subdivisionCounter = subdivisions; //subdivisionCounter keeps count of which subdivision we're on, +=1 when subdivision click is played, reset to 1 when main beat is finished
+        int subdivisionCounter = subdivisions; //subdivision of the running beat that played last, 1 for the beat itself
 
-        //apvts of caller that created this instance of metronome
-        juce::AudioProcessorValueTreeState* apvts;
+        //beats with a tuplet tree play its compiled events instead of the subdivisions, converted to samples for the current beatInterval
+        TupletOffsetTable tupletOffsets;
 
-        //file processing stuff
-        juce::AudioFormatManager formatManager;
-        std::unique_ptr <juce::AudioFormatReaderSource> rimShotHigh = nullptr;
-        std::unique_ptr <juce::AudioFormatReaderSource> rimShotLow = nullptr;
-        std::unique_ptr <juce::AudioFormatReaderSource> rimShotSub = nullptr;
+        //click playback, the decoded samples live in the process wide cache
+        juce::SharedResourcePointer<ClickSampleCache> sampleCache;
+        ClickVoice rimShotHigh;
+        ClickVoice rimShotLow;
+        ClickVoice rimShotSub;
 
 
 };
-
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    OnsetDetector.cpp
+    Created: 19 Oct 2026 7:35:02pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "OnsetDetector.h"
+
+namespace
+{
+    const double statsSeconds = 1.0; //smoothing of the onset strength mean and deviation
+    const float energyCompression = 1000.0f; //log(1 + c * energy), keeps quiet and loud hits on a similar scale
+    const float onsetThreshold = 1.5f; //deviations above the running mean an onset strength peak has to reach
+    const float minimumOnsetStrength = 0.05f; //ignores peaks in near silence
+    const double attackSeconds = 0.0005;
+    const double releaseSeconds = 0.02;
+    const double minimumSecondsBetweenOnsets = 0.05; //no player hits the same drum faster than this
+}
+
+void OnsetDetector::prepare(double sampleRate, double hopSeconds)
+{
+    hopSize = juce::jmax(32, juce::roundToInt(sampleRate * hopSeconds));
+    statsSmoothing = (float)std::exp(-1.0 / (statsSeconds * sampleRate / hopSize));
+    attackCoefficient = 1.0f - (float)std::exp(-1.0 / (attackSeconds * sampleRate));
+    releaseCoefficient = 1.0f - (float)std::exp(-1.0 / (releaseSeconds * sampleRate));
+    minimumHopsBetweenOnsets = juce::jmax(1, juce::roundToInt(minimumSecondsBetweenOnsets * sampleRate / hopSize));
+
+    //each drum gets its own band so a hit in one isn't masked by sustain in another
+    bandFilters[0].setCoefficients(juce::IIRCoefficients::makeLowPass(sampleRate, 150.0));
+    bandFilters[1].setCoefficients(juce::IIRCoefficients::makeBandPass(sampleRate, 400.0, 1.0));
+    bandFilters[2].setCoefficients(juce::IIRCoefficients::makeBandPass(sampleRate, 1600.0, 1.0));
+    bandFilters[3].setCoefficients(juce::IIRCoefficients::makeHighPass(sampleRate, 5000.0));
+
+    reset();
+}
+
+void OnsetDetector::reset()
+{
+    for (auto& filter : bandFilters)
+    {
+        filter.reset();
+    }
+    bandEnvelopes.fill(0.0f);
+    previousLogEnergy.fill(0.0f);
+    recentStrengths.fill(0.0f);
+    strengthMean = 0;
+    strengthDeviation = 0;
+    hopPosition = 0;
+    hopsSinceOnset = minimumHopsBetweenOnsets;
+    onset = false;
+}
+
+void OnsetDetector::finishHop()
+{
+    //falls in level are ignored, only hits count
+    float strength = 0;
+    for (int band = 0; band < numBands; band++)
+    {
+        const float logEnergy = std::log1p(energyCompression * bandEnvelopes[(size_t)band]);
+        strength += juce::jmax(0.0f, logEnergy - previousLogEnergy[(size_t)band]);
+        previousLogEnergy[(size_t)band] = logEnergy;
+    }
+    hopPosition = 0;
+
+    strengthMean = statsSmoothing * strengthMean + (1.0f - statsSmoothing) * strength;
+    strengthDeviation = statsSmoothing * strengthDeviation + (1.0f - statsSmoothing) * std::abs(strength - strengthMean);
+
+    recentStrengths[0] = recentStrengths[1];
+    recentStrengths[1] = recentStrengths[2];
+    recentStrengths[2] = strength;
+    const float peak = recentStrengths[1];
+    onset = peak > recentStrengths[0] && peak >= recentStrengths[2]
+        && peak > strengthMean + onsetThreshold * strengthDeviation && peak > minimumOnsetStrength
+        && hopsSinceOnset >= minimumHopsBetweenOnsets;
+    hopsSinceOnset = onset ? 0 : hopsSinceOnset + 1;
+}
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    OnsetDetector.h
+    Created: 19 Oct 2026 7:35:02pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//finds the hits in a mono drum signal, shared by the tempo follower and the timing analysis
+//the signal is cut into hops, each hop gives one onset strength value: the summed rise in the log envelopes of 4 bands (kick, snare body, snare crack, cymbals)
+//a hop is an onset when its strength peaks above a threshold that adapts to the running mean and deviation and the last onset is long enough ago,
+//which can only be seen once the next hop has fallen again, so onsets are reported one hop late
+//fixed work per sample (4 biquads), nothing is allocated after prepare
+class OnsetDetector
+{
+public:
+    OnsetDetector() = default;
+
+    void prepare(double sampleRate, double hopSeconds);
+    void reset();
+
+    //feeds one sample, returns true when it completes a hop, the getters below then describe that hop
+    bool pushSample(float sample)
+    {
+        for (int band = 0; band < numBands; band++)
+        {
+            //the envelope rises almost at once but falls slowly, so a low drum's own waveform doesn't ripple through the hops as fake hits
+            const float filtered = bandFilters[(size_t)band].processSingleSampleRaw(sample);
+            const float power = filtered * filtered;
+            auto& envelope = bandEnvelopes[(size_t)band];
+            envelope += (power > envelope ? attackCoefficient : releaseCoefficient) * (power - envelope);
+        }
+        if (++hopPosition < hopSize)
+        {
+            return false;
+        }
+        finishHop();
+        return true;
+    }
+
+    int getHopSize() const { return hopSize; }
+    int getHopPosition() const { return hopPosition; } //samples gathered into the hop in progress
+    float getOnsetStrength() const { return recentStrengths[2]; }
+    float getMeanStrength() const { return strengthMean; }
+    //true when the hop before the one just completed was an onset
+    bool isOnset() const { return onset; }
+    //how far the onset lies before the end of the hop just completed, the middle of the peak hop
+    double getOnsetDelay() const { return 1.5 * hopSize; }
+
+private:
+    void finishHop();
+
+    static constexpr int numBands = 4;
+
+    int hopSize = 256;
+    int hopPosition = 0;
+    int minimumHopsBetweenOnsets = 1; //a drum's ring and rattle after a hit aren't hits of their own
+    int hopsSinceOnset = 0;
+    float statsSmoothing = 0; //one pole coefficient per hop for the running mean and deviation
+    float attackCoefficient = 1; //per sample envelope coefficients
+    float releaseCoefficient = 1;
+
+    std::array<juce::IIRFilter, numBands> bandFilters;
+    std::array<float, numBands> bandEnvelopes{};
+    std::array<float, numBands> previousLogEnergy{};
+    std::array<float, 3> recentStrengths{}; //last three hops, the middle one is a peak when it beats both neighbours
+    float strengthMean = 0;
+    float strengthDeviation = 0;
+    bool onset = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OnsetDetector)
+};
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    OutputDelay.cpp
+    Created: 19 Oct 2026 9:12:40pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "OutputDelay.h"
+
+void MidiDelay::process(juce::MidiBuffer& midiBuffer, int numSamples, int delaySamples)
+{
+    for (const auto metadata : midiBuffer)
+    {
+        //a full list drops the event, same as a full click queue
+        if (numPending < capacity && metadata.numBytes <= maxEventSize)
+        {
+            auto& event = pending[(size_t)numPending++];
+            event.samplePosition = metadata.samplePosition + delaySamples;
+            event.size = metadata.numBytes;
+            std::copy(metadata.data, metadata.data + metadata.numBytes, event.data.begin());
+        }
+        else
+        {
+            numDropped++;
+        }
+    }
+    midiBuffer.clear();
+
+    //addEvent keeps the buffer sorted, so the list itself doesn't need to be
+    int numWaiting = 0;
+    for (int i = 0; i < numPending; i++)
+    {
+        auto event = pending[(size_t)i];
+        if (event.samplePosition < numSamples)
+        {
+            midiBuffer.addEvent(event.data.data(), event.size, juce::jmax(0, event.samplePosition));
+        }
+        else
+        {
+            event.samplePosition -= numSamples;
+            pending[(size_t)numWaiting++] = event;
+        }
+    }
+    numPending = numWaiting;
+}
+
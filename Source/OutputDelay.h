@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    OutputDelay.h
+    Created: 19 Oct 2026 9:12:40pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//the MIDI the engine wrote this block, held back by the MIDI offset
+//events that land past the end of the block (delayed ones, or note offs after a click near the end) wait in a fixed size list for the block they fall in
+class MidiDelay
+{
+public:
+    void reset() { numPending = 0; }
+
+    //audio thread, moves every event in midiBuffer delaySamples later and puts back the ones that fall in this block of numSamples
+    void process(juce::MidiBuffer& midiBuffer, int numSamples, int delaySamples);
+
+    //audio thread, events dropped because the list was full since the last call
+    int takeNumDropped() { return std::exchange(numDropped, 0); }
+
+private:
+    static constexpr int capacity = 256;
+    static constexpr int maxEventSize = 3; //the engines only send note ons and offs, anything longer is dropped
+
+    struct PendingEvent
+    {
+        int samplePosition = 0; //from the start of the next block
+        int size = 0;
+        std::array<juce::uint8, maxEventSize> data{};
+    };
+
+    std::array<PendingEvent, capacity> pending;
+    int numPending = 0;
+    int numDropped = 0;
+};
+
+//delays audio in place through a ring allocated by prepare, used to hold the input passthrough back by the lookahead
+//so it stays lined up with the rest of the host's tracks once the host compensates for the reported latency
+template <typename SampleType>
+class AudioDelayLine
+{
+public:
+    //message thread, while audio is stopped
+    void prepare(int numChannels, int _maxDelaySamples, int maxBlockSize)
+    {
+        maxDelaySamples = _maxDelaySamples;
+        ring.setSize(numChannels, maxDelaySamples + juce::jmax(1, maxBlockSize));
+        reset();
+    }
+
+    void reset()
+    {
+        ring.clear();
+        writePosition = 0;
+    }
+
+    //audio thread, delaySamples is clamped to the maxDelaySamples the line was prepared with
+    void process(juce::AudioBuffer<SampleType>& buffer, int delaySamples)
+    {
+        const int ringSize = ring.getNumSamples();
+        const int numChannels = juce::jmin(buffer.getNumChannels(), ring.getNumChannels());
+        if (numChannels == 0)
+        {
+            return;
+        }
+        const int delay = juce::jlimit(0, maxDelaySamples, delaySamples);
+        //each chunk is written before it's read back, so it can be no longer than the part of the ring the delay doesn't need
+        const int maxChunk = ringSize - maxDelaySamples;
+
+        for (int chunkStart = 0; chunkStart < buffer.getNumSamples(); chunkStart += maxChunk)
+        {
+            const int chunkSize = juce::jmin(maxChunk, buffer.getNumSamples() - chunkStart);
+            const int readPosition = (writePosition - delay + ringSize) % ringSize;
+            for (int channel = 0; channel < numChannels; channel++)
+            {
+                SampleType* samples = buffer.getWritePointer(channel, chunkStart);
+                SampleType* delayed = ring.getWritePointer(channel);
+
+                const int writeSize1 = juce::jmin(chunkSize, ringSize - writePosition);
+                juce::FloatVectorOperations::copy(delayed + writePosition, samples, writeSize1);
+                juce::FloatVectorOperations::copy(delayed, samples + writeSize1, chunkSize - writeSize1);
+
+                const int readSize1 = juce::jmin(chunkSize, ringSize - readPosition);
+                juce::FloatVectorOperations::copy(samples, delayed + readPosition, readSize1);
+                juce::FloatVectorOperations::copy(samples + readSize1, delayed, chunkSize - readSize1);
+            }
+            writePosition = (writePosition + chunkSize) % ringSize;
+        }
+    }
+
+private:
+    juce::AudioBuffer<SampleType> ring;
+    int maxDelaySamples = 0;
+    int writePosition = 0;
+};
@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    PhaseClock.cpp
+    Created: 20 Oct 2026 6:07:41am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "PhaseClock.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+//the segment's layout, every process maps the same bytes so every field is an address free lock free atomic
+//a new segment is all zeros, which is a valid empty clock with no leader
+struct PhaseClock::Shared
+{
+    std::atomic<juce::uint32> sequence; //odd while the leader is writing
+    std::atomic<juce::uint32> leaderId; //0 while nobody leads
+    std::atomic<double> sampleRate;
+    std::atomic<double> bpm;
+    std::atomic<double> beats;
+    std::atomic<juce::int64> sampleClock;
+    std::atomic<juce::int64> blockTicks;
+    std::atomic<juce::uint32> isPlaying;
+};
+
+static_assert(std::atomic<juce::uint32>::is_always_lock_free && std::atomic<juce::int64>::is_always_lock_free && std::atomic<double>::is_always_lock_free,
+    "the shared clock's atomics have to work between processes");
+
+namespace
+{
+    //the layout is part of the name, so builds with a different one never share a segment
+    constexpr const char* segmentName = "/MetroGnome-phase-clock-2";
+}
+
+PhaseClock::PhaseClock()
+{
+    do
+    {
+        id = (juce::uint32)juce::Random::getSystemRandom().nextInt();
+    } while (id == 0);
+}
+
+PhaseClock::~PhaseClock()
+{
+    auto* segment = shared.exchange(nullptr);
+    if (segment == nullptr)
+    {
+        return;
+    }
+    auto expected = id;
+    segment->leaderId.compare_exchange_strong(expected, 0);
+#if JUCE_LINUX || JUCE_MAC
+    munmap(segment, sizeof(Shared));
+    close(fileDescriptor);
+#endif
+}
+
+bool PhaseClock::open()
+{
+    if (isOpen())
+    {
+        return true;
+    }
+#if JUCE_LINUX || JUCE_MAC
+    //the segment outlives the processes, the next instance to open it finds the last leader stale and takes over
+    fileDescriptor = shm_open(segmentName, O_CREAT | O_RDWR, 0600);
+    if (fileDescriptor < 0)
+    {
+        return false;
+    }
+    if (ftruncate(fileDescriptor, (off_t)sizeof(Shared)) != 0)
+    {
+        close(fileDescriptor);
+        fileDescriptor = -1;
+        return false;
+    }
+    void* address = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (address == MAP_FAILED)
+    {
+        close(fileDescriptor);
+        fileDescriptor = -1;
+        return false;
+    }
+    shared.store(static_cast<Shared*>(address), std::memory_order_release);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PhaseClock::publish(const Frame& frame)
+{
+    auto* segment = shared.load(std::memory_order_acquire);
+    if (segment == nullptr)
+    {
+        return false;
+    }
+
+    auto leader = segment->leaderId.load(std::memory_order_relaxed);
+    bool isTakeover = false;
+    if (leader != id)
+    {
+        const auto staleTicks = juce::Time::secondsToHighResolutionTicks(staleSeconds);
+        bool isLeaderGone = leader == 0 || frame.blockTicks - segment->blockTicks.load(std::memory_order_relaxed) > staleTicks;
+        if (!isLeaderGone || !segment->leaderId.compare_exchange_strong(leader, id))
+        {
+            return false;
+        }
+        isTakeover = true;
+    }
+
+    //the write side is taken by moving the sequence from even to odd, so a stale leader that wakes up mid takeover
+    //and the one that took over can't both be writing, whoever finds it odd skips the block
+    auto sequence = segment->sequence.load(std::memory_order_relaxed);
+    if ((sequence & 1) != 0)
+    {
+        //left odd by a leader that died mid write (one stalled there for staleSeconds looks the same), the one taking over evens it
+        if (!isTakeover || !segment->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed))
+        {
+            return false;
+        }
+        sequence++;
+    }
+    if (!segment->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+    {
+        return false;
+    }
+    //a follower may have found this instance stale between the check above and taking the write side, nothing's been written yet
+    //so the sequence goes back to what it was and readers see the same frame
+    if (segment->leaderId.load(std::memory_order_relaxed) != id)
+    {
+        segment->sequence.store(sequence, std::memory_order_release);
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->sampleRate.store(frame.sampleRate, std::memory_order_relaxed);
+    segment->bpm.store(frame.bpm, std::memory_order_relaxed);
+    segment->beats.store(frame.beats, std::memory_order_relaxed);
+    segment->sampleClock.store(frame.sampleClock, std::memory_order_relaxed);
+    segment->blockTicks.store(frame.blockTicks, std::memory_order_relaxed);
+    segment->isPlaying.store(frame.isPlaying ? 1 : 0, std::memory_order_relaxed);
+    //a takeover while writing has to wait for this to even the sequence before it can write, the frame is whole either way
+    const bool isStillLeading = segment->leaderId.load(std::memory_order_relaxed) == id;
+    segment->sequence.store(sequence + 2, std::memory_order_release);
+    return isStillLeading;
+}
+
+void PhaseClock::resign()
+{
+    if (auto* segment = shared.load(std::memory_order_acquire))
+    {
+        auto expected = id;
+        segment->leaderId.compare_exchange_strong(expected, 0);
+    }
+}
+
+bool PhaseClock::read(Frame& frame) const
+{
+    auto* segment = shared.load(std::memory_order_acquire);
+    if (segment == nullptr || segment->leaderId.load(std::memory_order_relaxed) == 0)
+    {
+        return false;
+    }
+
+    //a write takes a few nanoseconds, so a handful of tries is plenty, the reader never waits any longer than this
+    for (int attempt = 0; attempt < 8; attempt++)
+    {
+        const auto before = segment->sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+        {
+            continue;
+        }
+        Frame copy;
+        copy.sampleRate = segment->sampleRate.load(std::memory_order_relaxed);
+        copy.bpm = segment->bpm.load(std::memory_order_relaxed);
+        copy.beats = segment->beats.load(std::memory_order_relaxed);
+        copy.sampleClock = segment->sampleClock.load(std::memory_order_relaxed);
+        copy.blockTicks = segment->blockTicks.load(std::memory_order_relaxed);
+        copy.isPlaying = segment->isPlaying.load(std::memory_order_relaxed) != 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment->sequence.load(std::memory_order_relaxed) == before)
+        {
+            frame = copy;
+            return true;
+        }
+    }
+    return false;
+}
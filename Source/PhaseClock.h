@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    PhaseClock.h
+    Created: 20 Oct 2026 6:07:41am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//LOCAL_SYNC, keeps several instances on one machine (standalones with no host to share) playing together
+//the leading instance publishes its tempo and engine position (in beats) every block into a POSIX shared memory segment,
+//followers read it and work out where the leader is at the start of their own block from the machine's monotonic clock
+//the segment is a seqlock: the leader never waits for anyone, a reader retries a few times if it lands on a write and
+//otherwise keeps its own clock for the block, nothing in here locks, allocates or makes a system call after open
+class PhaseClock
+{
+public:
+    //what the leader publishes at the start of each block
+    struct Frame
+    {
+        double sampleRate = 0;
+        double bpm = 0;
+        double beats = 0; //the leader engine's position in the rhythm, in beats so it means the same thing on either side of a tempo change
+        juce::int64 sampleClock = 0; //samples the leader has processed, only ever goes up
+        juce::int64 blockTicks = 0; //juce::Time::getHighResolutionTicks() at the start of the block, the clock every process on the machine shares
+        bool isPlaying = false;
+    };
+
+    PhaseClock();
+    ~PhaseClock();
+
+    //message thread, maps the machine's segment, false where there's no POSIX shared memory or it couldn't be opened
+    bool open();
+    bool isOpen() const { return shared.load(std::memory_order_acquire) != nullptr; }
+
+    //audio thread of the leading instance, false while another live instance leads
+    //a leader that hasn't published for staleSeconds (stopped or crashed) can be taken over
+    bool publish(const Frame& frame);
+    //audio thread, lets another instance lead, does nothing if this one wasn't
+    void resign();
+
+    //audio thread of a following instance, false while no instance leads or every try landed on a write
+    bool read(Frame& frame) const;
+
+    static constexpr double staleSeconds = 0.5;
+
+private:
+    struct Shared;
+
+    std::atomic<Shared*> shared{ nullptr };
+    juce::uint32 id = 0; //this instance's claim on leading, unique within the machine with near certainty
+#if JUCE_LINUX || JUCE_MAC
+    int fileDescriptor = -1;
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE(PhaseClock)
+};
@@ -34,19 +34,19 @@ MetroGnomeAudioProcessorEditor::MetroGnomeAudioProcessorEditor(MetroGnomeAudioPr
     };
 
     metronomeButton.onClick = [this]() {
-        audioProcessor.apvts.getRawParameterValue("MODE")->store(0);
+        setMode(0);
         changeMenuButtonColors(&metronomeButton);
         toggleAudioProcessorChildrenStates();
         togglePlayStateOff();
     };
     polyRhythmButton.onClick = [this]() {
-        audioProcessor.apvts.getRawParameterValue("MODE")->store(1);
+        setMode(1);
         changeMenuButtonColors(&polyRhythmButton);
         toggleAudioProcessorChildrenStates();
         togglePlayStateOff();
     };
     polyMeterButton.onClick = [this]() {
-        audioProcessor.apvts.getRawParameterValue("MODE")->store(2);
+        setMode(2);
         changeMenuButtonColors(&polyMeterButton);
         toggleAudioProcessorChildrenStates();
         togglePlayStateOff();
@@ -59,35 +59,46 @@ MetroGnomeAudioProcessorEditor::MetroGnomeAudioProcessorEditor(MetroGnomeAudioPr
     savePresetButton.onClick = [this]() {
         savePreset();
     };
+    loadKitButton.onClick = [this]() {
+        loadKit();
+    };
+    resetStatsButton.onClick = [this]() {
+        audioProcessor.timingAnalyzer.requestReset();
+    };
+    roundTripSlider.setTextValueSuffix(" ms");
+    diagnosticsButton.onClick = [this]() {
+        diagnosticsPanel.setVisible(diagnosticsButton.getToggleState());
+    };
 
 
     playButton.setColour(juce::TextButton::ColourIds::buttonColourId, juce::Colours::steelblue);
     metronomeButton.setColour(juce::TextButton::ColourIds::buttonColourId, juce::Colours::indigo);
     polyRhythmButton.setColour(juce::TextButton::ColourIds::buttonColourId, juce::Colours::steelblue);
     polyMeterButton.setColour(juce::TextButton::ColourIds::buttonColourId, juce::Colours::steelblue);
-   
 
-    //initialize the polyrhythm Metronome buttons
-    for (int i = 0; i < MAX_LENGTH; i++) {
-        Rhythm1Buttons[i].setToggleState(true, juce::NotificationType::sendNotification);
-        Rhythm1Buttons[i].onClick = [this, i]() {
-            if (audioProcessor.apvts.getRawParameterValue("RHYTHM1." + to_string(i) + "_TOGGLE")->load() == true) {
-                audioProcessor.apvts.getRawParameterValue("RHYTHM1." + to_string(i) + "_TOGGLE")->store(false);
-            }
-            else {
-                audioProcessor.apvts.getRawParameterValue("RHYTHM1." + to_string(i) + "_TOGGLE")->store(true);
-            }
-        };
-        Rhythm2Buttons[i].setToggleState(true, juce::NotificationType::sendNotification);
-        Rhythm2Buttons[i].onClick = [this, i]() {
-            if (audioProcessor.apvts.getRawParameterValue("RHYTHM2." + to_string(i) + "_TOGGLE")->load() == true) {
-                audioProcessor.apvts.getRawParameterValue("RHYTHM2." + to_string(i) + "_TOGGLE")->store(false);
-            }
-            else {
-                audioProcessor.apvts.getRawParameterValue("RHYTHM2." + to_string(i) + "_TOGGLE")->store(true);
-            }
-        };
+    //the items have to exist before the attachment is made so it can select the current choice
+    if (auto* quantizeParam = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter("QUANTIZE")))
+    {
+        quantizeBox.addItemList(quantizeParam->choices, 1);
+    }
+    quantizeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "QUANTIZE", quantizeBox);
+    if (auto* localSyncParam = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter("LOCAL_SYNC")))
+    {
+        localSyncBox.addItemList(localSyncParam->choices, 1);
     }
+    localSyncAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "LOCAL_SYNC", localSyncBox);
+   
+
+    //initialize the polyrhythm Metronome steps, the store publishes every edit to the audio thread without locking
+    stepGrid.onStepClicked = [this](int voice, int step) {
+        audioProcessor.stepPatterns.toggleStep(voice, step);
+    };
+
+    //the tabs only show the editors, the editor keeps them
+    stepEditors.addTab("lanes", juce::Colours::black, &laneEditor, false);
+    stepEditors.addTab("groove", juce::Colours::black, &grooveEditor, false);
+    stepEditors.addTab("tuplets", juce::Colours::black, &tupletEditor, false);
+    stepEditors.addTab("song", juce::Colours::black, &songEditor, false);
 
 
 
@@ -101,14 +112,15 @@ MetroGnomeAudioProcessorEditor::MetroGnomeAudioProcessorEditor(MetroGnomeAudioPr
 
 
     startTimerHz(144);
-    setSize(1000, 700);
+    setSize(1000, 700 + stepEditorsHeight);
 }
 
 
 void MetroGnomeAudioProcessorEditor::resized()
 {
 
-    juce::Rectangle<int> bounds = getLocalBounds();
+    stepEditors.setBounds(getLocalBounds().removeFromBottom(stepEditorsHeight));
+    juce::Rectangle<int> bounds = getMainArea();
     juce::Rectangle<int> playBounds(100, 100);
     playBounds.removeFromTop(50);
     playBounds.removeFromRight(50);
@@ -119,9 +131,13 @@ void MetroGnomeAudioProcessorEditor::resized()
     flexBox.items.add(juce::FlexItem(75, 50, metronomeButton));
     flexBox.items.add(juce::FlexItem(100, 50, polyRhythmButton));
     flexBox.items.add(juce::FlexItem(125, 50, polyMeterButton));
+    flexBox.items.add(juce::FlexItem(125, 50, quantizeBox));
+    flexBox.items.add(juce::FlexItem(75, 50, followButton));
+    flexBox.items.add(juce::FlexItem(100, 50, localSyncBox));
 
     flexBox.items.add(juce::FlexItem(175, 50, loadPresetButton));
     flexBox.items.add(juce::FlexItem(200, 50, savePresetButton));
+    flexBox.items.add(juce::FlexItem(100, 50, loadKitButton));
     flexBox.performLayout(playBounds);
 
 
@@ -139,6 +155,37 @@ void MetroGnomeAudioProcessorEditor::resized()
     bpmSlider.setBounds(leftArea);
     subdivisionSlider.setBounds(rightArea);
     numeratorSlider.setBounds(bounds);
+
+    //timing analysis controls along the top of its area, the statistics are painted below them
+    auto analysisArea = getAnalysisArea();
+    auto controlsRow = analysisArea.removeFromTop(25);
+    analyzeButton.setBounds(controlsRow.removeFromLeft(90));
+    resetStatsButton.setBounds(controlsRow.removeFromLeft(90));
+    diagnosticsButton.setBounds(controlsRow.removeFromLeft(100));
+    roundTripSlider.setBounds(analysisArea.removeFromTop(25));
+
+    stepGrid.setBounds(getVisualArea().expanded(StepGrid::cellSize));
+
+    //bottom of the left third of the top area, under the menu and the logo
+    auto diagnosticsArea = getMainArea();
+    diagnosticsArea = diagnosticsArea.removeFromTop(diagnosticsArea.getHeight() * 0.66);
+    diagnosticsPanel.setBounds(diagnosticsArea.removeFromLeft(diagnosticsArea.getWidth() * 0.33).removeFromBottom(110).reduced(10, 0));
+}
+
+void MetroGnomeAudioProcessorEditor::timerCallback()
+{
+    //the grid only lays its steps out again when a length changed, the lengths are the ones the engine applied,
+    //a NUMERATOR or SUBDIVISION edit waiting for its boundary would otherwise draw steps the counters haven't reached yet
+    auto mode = audioProcessor.apvts.getRawParameterValue("MODE")->load();
+    const int length1 = audioProcessor.displayState.length1.load();
+    const int length2 = audioProcessor.displayState.length2.load();
+    stepGrid.setVisible(mode == 1 || mode == 2);
+    stepGrid.setLengths(length1, length2);
+    laneEditor.setLengths(length1, length2);
+    grooveEditor.refresh();
+    tupletEditor.refresh();
+    songEditor.refresh();
+    repaint();
 }
 
 MetroGnomeAudioProcessorEditor::~MetroGnomeAudioProcessorEditor()
@@ -148,43 +195,61 @@ MetroGnomeAudioProcessorEditor::~MetroGnomeAudioProcessorEditor()
 //==============================================================================
 void MetroGnomeAudioProcessorEditor::paint(juce::Graphics& g)
 {
+    TRACE_SCOPE("editor paint");
     g.fillAll(juce::Colours::black);
     g.drawImageAt(logo, 0, 0);
 
 
-    if (audioProcessor.apvts.getRawParameterValue("DAW_CONNECTED")->load() == true){
-        DBG("TEST");
+    bool isDawConnected = audioProcessor.apvts.getRawParameterValue("DAW_CONNECTED")->load();
+    if (isDawConnected != wasDawConnected) {
+        //logged when it changes rather than on every paint
+        wasDawConnected = isDawConnected;
+        if (isDawConnected) {
+            RealtimeLog::write(LogMessage::hostConnected, audioProcessor.apvts.getRawParameterValue("BPM")->load());
+        }
+        else {
+            RealtimeLog::write(LogMessage::hostDisconnected);
+        }
+    }
+    if (isDawConnected){
+        bpmSlider.setEnabled(false);
+        bpmSlider.setValue(audioProcessor.apvts.getRawParameterValue("BPM")->load());
+    }
+    else if (audioProcessor.apvts.getRawParameterValue("FOLLOW")->load() == true || audioProcessor.apvts.getRawParameterValue("LOCAL_SYNC")->load() == 2) {
+        //the followed tempo is written to the raw value by the audio thread, the slider just shows it
         bpmSlider.setEnabled(false);
         bpmSlider.setValue(audioProcessor.apvts.getRawParameterValue("BPM")->load());
     }
+    else {
+        bpmSlider.setEnabled(true);
+    }
 
 
     auto mode = audioProcessor.apvts.getRawParameterValue("MODE")->load();
-    if (mode == 1) {
+    if (mode == 1 || mode == 2) {
+        //polymeter uses the same two circles, only the engine behind them differs
         paintPolyRhythmMetronomeMode(g);
     }
-    else {
-        //reset the hideable polyrhythm buttons
-        for (int i = 0; i < MAX_LENGTH; i++) {
-            Rhythm1Buttons[i].setVisible(false);
-            Rhythm2Buttons[i].setVisible(false);
-        }
-    }
     if (mode == 0) {
 
         paintMetronomeMode(g);
     }
-    if (mode == 2) {
 
-        ;
+    if (audioProcessor.apvts.getRawParameterValue("ANALYZE")->load() == true) {
+        paintTimingAnalysis(g);
     }
 
+}
 
+juce::Rectangle<int> MetroGnomeAudioProcessorEditor::getMainArea()
+{
+    //everything above the step editors, laid out as the whole window was before they were added
+    return getLocalBounds().withTrimmedBottom(stepEditorsHeight);
 }
 
 juce::Rectangle<int> MetroGnomeAudioProcessorEditor::getVisualArea()
 {
-    auto bounds = getLocalBounds();
+    auto bounds = getMainArea();
     //visual area consists of middle third of top third of area 
     auto visualArea = bounds.removeFromTop(bounds.getHeight() * 0.66);
     visualArea.removeFromLeft(visualArea.getWidth() * 0.33);
@@ -192,8 +257,63 @@ juce::Rectangle<int> MetroGnomeAudioProcessorEditor::getVisualArea()
     return visualArea;
 }
 
+juce::Rectangle<int> MetroGnomeAudioProcessorEditor::getAnalysisArea()
+{
+    auto bounds = getMainArea();
+    //analysis area is the right third of the top two thirds, next to the visual area
+    auto analysisArea = bounds.removeFromTop(bounds.getHeight() * 0.66);
+    return analysisArea.removeFromRight(analysisArea.getWidth() * 0.33).reduced(10);
+}
+
+void MetroGnomeAudioProcessorEditor::paintTimingAnalysis(juce::Graphics& g)
+{
+    //early/late statistics of the player's hits, then one histogram per step of each rhythm that is playing
+    const auto& stats = audioProcessor.timingAnalyzer.getStats();
+    auto area = getAnalysisArea();
+    area.removeFromTop(55); //controls
+
+    auto formatMs = [](double ms) { return (ms > 0 ? "+" : "") + juce::String(ms, 1) + " ms"; };
+
+    g.setColour(juce::Colours::lightgrey);
+    g.drawText("hits: " + juce::String(stats.all.count) + "   missed: " + juce::String(stats.unmatchedHits), area.removeFromTop(20), juce::Justification::centredLeft);
+    g.drawText("mean: " + formatMs(stats.all.mean) + "   sd: " + juce::String(stats.all.getStandardDeviation(), 1) + " ms", area.removeFromTop(20), juce::Justification::centredLeft);
+    g.drawText("last: " + formatMs(stats.lastDeviationMs), area.removeFromTop(20), juce::Justification::centredLeft);
+    area.removeFromTop(5);
 
+    int lengths[2] = { audioProcessor.displayState.length1.load(), audioProcessor.displayState.length2.load() };
+    int numRows = lengths[0] + (lengths[1] > 1 ? lengths[1] : 0);
+    int rowHeight = juce::jmin(20, area.getHeight() / juce::jmax(1, numRows));
 
+    for (int voice = 0; voice < 2; voice++)
+    {
+        if (voice == 1 && lengths[1] <= 1)
+        {
+            break;
+        }
+        for (int step = 0; step < lengths[voice]; step++)
+        {
+            const auto& stepStats = stats.steps[(size_t)voice][(size_t)step];
+            auto row = area.removeFromTop(rowHeight);
+            g.setColour(voice == 0 ? juce::Colours::lightgrey : juce::Colours::orange);
+            g.drawText(juce::String(voice + 1) + "." + juce::String(step + 1), row.removeFromLeft(35), juce::Justification::centredLeft);
+            g.drawText(stepStats.count > 0 ? formatMs(stepStats.mean) : "-", row.removeFromRight(70), juce::Justification::centredRight);
+
+            int maxCount = 1;
+            for (auto count : stepStats.histogram)
+            {
+                maxCount = juce::jmax(maxCount, count);
+            }
+            float binWidth = row.getWidth() / (float)TimingStats::numBins;
+            for (int bin = 0; bin < TimingStats::numBins; bin++)
+            {
+                //the middle bin is on time
+                float barHeight = (row.getHeight() - 2) * stepStats.histogram[(size_t)bin] / (float)maxCount;
+                g.setColour(bin == TimingStats::numBins / 2 ? juce::Colours::green : juce::Colours::steelblue);
+                g.fillRect(row.getX() + bin * binWidth, row.getBottom() - 1 - barHeight, binWidth - 1, barHeight);
+            }
+        }
+    }
+}
 
 
 void MetroGnomeAudioProcessorEditor::paintPolyRhythmMetronomeMode(juce::Graphics& g)
@@ -222,22 +342,6 @@ void MetroGnomeAudioProcessorEditor::paintPolyRhythmMetronomeMode(juce::Graphics
     {
         drawPolyRhythmCircle(g, radius, width, height, X, Y, rhythm2Value, 1.5, juce::Colours::orange, juce::Colours::lightgrey, 2);
     }
-    
-
-
-    //hide any components that no longer need to be shown
-    for (int i = rhythm1Value; i < MAX_LENGTH; i++) {
-        Rhythm1Buttons[i].setVisible(false);
-    }
-    for (int i = rhythm2Value; i < MAX_LENGTH; i++) {
-        Rhythm2Buttons[i].setVisible(false);
-    }
-    if (rhythm1Value == 1) {
-        Rhythm1Buttons[0].setVisible(false);
-    }
-    if (rhythm2Value == 1) {
-        Rhythm2Buttons[0].setVisible(false);
-    }
 
 }
 
@@ -256,48 +360,19 @@ void MetroGnomeAudioProcessorEditor::drawPolyRhythmCircle(juce::Graphics& g, int
     g.strokePath(rhythmCircle, juce::PathStrokeType(2.0f));
 
 
-    float rhythm1Length = rhythmCircle.getLength();
-    for (int i = 0; i < rhythmValue; i++)
-    {
-        //iterate through beats and draw toggle button on the edge of the main circle
-
-        float distanceOnPath = (float(i) / rhythmValue) * rhythm1Length;
-        auto point = rhythmCircle.getPointAlongPath(distanceOnPath);
-        juce::Rectangle<int> pointBounds(point.getX(), point.getY(), 22, 22); //TODO  why 22?
-        if (index == 1) {
-            Rhythm1Buttons[i].setBounds(pointBounds);
-            Rhythm1Buttons[i].setVisible(true);
-            if ((audioProcessor.apvts.getRawParameterValue("RHYTHM1." + to_string(i) + "_TOGGLE")->load() == true) && audioProcessor.polyRhythmMetronome.getRhythm1Counter() == i) {
-                Rhythm1Buttons[i].setColour(juce::ToggleButton::ColourIds::tickColourId, juce::Colours::green);
-            }
-            else {
-                 Rhythm1Buttons[i].setColour(juce::ToggleButton::ColourIds::tickColourId, juce::Colours::grey);
-            }
-        }
-        else if (index == 2) {
-            Rhythm2Buttons[i].setBounds(pointBounds);
-            Rhythm2Buttons[i].setVisible(true);
-
-            if ((audioProcessor.apvts.getRawParameterValue("RHYTHM2." + to_string(i) + "_TOGGLE")->load() == true) && audioProcessor.polyRhythmMetronome.getRhythm2Counter() == i){
-                Rhythm2Buttons[i].setColour(juce::ToggleButton::ColourIds::tickColourId, juce::Colours::green);
-            }
-            else {
-                Rhythm2Buttons[i].setColour(juce::ToggleButton::ColourIds::tickColourId, juce::Colours::grey);
-            }
-        }
+    //the step boxes on the circle are drawn by stepGrid
 
-    }
     //draw the clock hand
     g.setColour(handColour);
     float angle = 0;
     juce::Point<int> center;
     if (index == 1) {
         center.setXY(X + rhythmRadius / 2, Y + (height - Xoffset) / 2);
-        angle = juce::degreesToRadians(360 * (float(audioProcessor.polyRhythmMetronome.getRhythm1Counter()) / float(rhythmValue)) + 180);
+        angle = juce::degreesToRadians(360 * (float(audioProcessor.displayState.counter1.load()) / float(rhythmValue)) + 180);
     }
     else if (index == 2) {
         center.setXY(X + Xoffset + rhythmRadius / 2, Y + Yoffset + rhythmRadius / 2);
-        angle = juce::degreesToRadians(360 * (float(audioProcessor.polyRhythmMetronome.getRhythm2Counter()) / float(rhythmValue)) + 180);
+        angle = juce::degreesToRadians(360 * (float(audioProcessor.displayState.counter2.load()) / float(rhythmValue)) + 180);
     }
 
     juce::Path clockHand;
@@ -326,14 +401,14 @@ void MetroGnomeAudioProcessorEditor::paintMetronomeMode(juce::Graphics& g) {
     auto X = visualArea.getX();
     auto ON = audioProcessor.apvts.getRawParameterValue("ON/OFF")->load();
 
-    for (int i = 1; i <= audioProcessor.metronome.getNumerator(); i++) {
+    for (int i = 1; i <= audioProcessor.displayState.length1.load(); i++) {
         //loop to draw metronome circles
         auto circleX = X + i * (circleradius + 5);
 
-        if (audioProcessor.metronome.getBeatCounter() == i && ON)
+        if (audioProcessor.displayState.counter1.load() == i && ON)
         {
 
-            if (audioProcessor.metronome.getSubdivisionCounter() != 1)
+            if (audioProcessor.displayState.counter2.load() != 1)
             {
                 g.setColour(juce::Colours::steelblue);
             }
@@ -344,7 +419,7 @@ void MetroGnomeAudioProcessorEditor::paintMetronomeMode(juce::Graphics& g) {
 
             g.fillEllipse(circleX, Y, circleradius, circleradius);
             g.setColour(juce::Colours::orange);
-            g.drawText(juce::String(audioProcessor.metronome.getSubdivisionCounter()), circleX, Y, circleradius, circleradius, juce::Justification::centred);
+            g.drawText(juce::String(audioProcessor.displayState.counter2.load()), circleX, Y, circleradius, circleradius, juce::Justification::centred);
         }
         else
         {
@@ -357,7 +432,7 @@ void MetroGnomeAudioProcessorEditor::paintMetronomeMode(juce::Graphics& g) {
     Y += 100;
     circleradius = 10;
     X = visualArea.getX();
-    int subdivisions = audioProcessor.metronome.getSubdivisions();
+    int subdivisions = audioProcessor.displayState.length2.load();
     int linewidth = 2;
 
 
@@ -377,7 +452,7 @@ void MetroGnomeAudioProcessorEditor::paintMetronomeMode(juce::Graphics& g) {
             g.fillRect(X + circleradius - 3, Y - circleradius - 3, linewidth, circleradius * 2);
 
 
-            if (audioProcessor.metronome.getSubdivisionCounter() == i && ON)
+            if (audioProcessor.displayState.counter2.load() == i && ON)
             {
                 //fill in the note that is currently being played
                 g.setColour(juce::Colours::orange);
@@ -390,10 +465,17 @@ void MetroGnomeAudioProcessorEditor::paintMetronomeMode(juce::Graphics& g) {
 
 
 
+void MetroGnomeAudioProcessorEditor::setMode(int mode)
+{
+    //goes through the parameter rather than the raw value so the processor hears about it and builds the new engine
+    auto* modeParam = audioProcessor.apvts.getParameter("MODE");
+    modeParam->setValueNotifyingHost(modeParam->convertTo0to1((float)mode));
+}
+
 void MetroGnomeAudioProcessorEditor::toggleAudioProcessorChildrenStates()
 {
-    audioProcessor.metronome.resetAll();
-    audioProcessor.polyRhythmMetronome.resetAll();
+    //the engines belong to the audio thread, so the reset is handed over instead of done from here
+    audioProcessor.requestReset();
 }
 void MetroGnomeAudioProcessorEditor::togglePlayState() {
 
@@ -421,9 +503,17 @@ std::vector<juce::Component*> MetroGnomeAudioProcessorEditor::getVisibleComps()
     comps.push_back(&metronomeButton);
     comps.push_back(&polyRhythmButton);
     comps.push_back(&polyMeterButton);
+    comps.push_back(&quantizeBox);
+    comps.push_back(&followButton);
+    comps.push_back(&localSyncBox);
+    comps.push_back(&analyzeButton);
+    comps.push_back(&resetStatsButton);
+    comps.push_back(&diagnosticsButton);
+    comps.push_back(&roundTripSlider);
     comps.push_back(&bpmSlider);
     comps.push_back(&subdivisionSlider);
     comps.push_back(&numeratorSlider);
+    comps.push_back(&stepEditors);
 
 
     return{ comps };
@@ -434,10 +524,9 @@ std::vector<juce::Component*> MetroGnomeAudioProcessorEditor::getHiddenComps() {
     std::vector<juce::Component*> comps;
     comps.push_back(&loadPresetButton);
     comps.push_back(&savePresetButton);
-    for (int i = 0; i < MAX_LENGTH; i++) {
-        comps.push_back(&Rhythm1Buttons[i]);
-        comps.push_back(&Rhythm2Buttons[i]);
-    }
+    comps.push_back(&loadKitButton);
+    comps.push_back(&stepGrid);
+    comps.push_back(&diagnosticsPanel);
 
     return{ comps };
 }
@@ -463,12 +552,29 @@ void MetroGnomeAudioProcessorEditor::savePreset() {
             auto gnomeFile = chooser.getResult();
             if (gnomeFile != juce::File{} ) {
                 apvtsXML->writeTo(gnomeFile, juce::XmlElement::TextFormat());
-                DBG(apvtsXML->toString());
+                RealtimeLog::write(LogMessage::presetSaved, gnomeFile.getSize());
             }
         });
         
 }
 
+void MetroGnomeAudioProcessorEditor::loadKit() {
+
+        //a folder with accent, beat and subdivision sound files, the processor builds the kit in the background
+        fileChooser = std::make_unique<juce::FileChooser>("Select a click kit folder",
+            audioProcessor.getClickKitFolder().exists() ? audioProcessor.getClickKitFolder() : juce::File::getCurrentWorkingDirectory());
+
+        auto folderChooserFlags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories;
+
+        fileChooser->launchAsync(folderChooserFlags, [this](const juce::FileChooser& chooser)
+            {
+                auto kitFolder = chooser.getResult();
+                if (kitFolder.isDirectory()) {
+                    audioProcessor.loadClickKit(kitFolder);
+                }
+            });
+}
+
 void MetroGnomeAudioProcessorEditor::loadPreset() {
     
         fileChooser = std::make_unique<juce::FileChooser>("Select a .mgnome preset file",
@@ -481,8 +587,10 @@ void MetroGnomeAudioProcessorEditor::loadPreset() {
             {
                 auto gnomeFile = chooser.getResult();
                 if (gnomeFile != juce::File{}) {
-                    audioProcessor.apvts.replaceState(juce::ValueTree::fromXml(*juce::XmlDocument::parse(gnomeFile)));
-                    audioProcessor.apvts.getRawParameterValue("MODE")->store(3);
+                    if (auto gnomeXML = juce::XmlDocument::parse(gnomeFile)) {
+                        audioProcessor.restoreState(juce::ValueTree::fromXml(*gnomeXML));
+                        audioProcessor.apvts.getRawParameterValue("MODE")->store(3);
+                    }
                 }
             });
             
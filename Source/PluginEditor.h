@@ -12,6 +12,11 @@
 #include "PluginProcessor.h"
 #include "LookAndFeel.h"
 #include "Utilities.h"
+#include "StepGrid.h"
+#include "DiagnosticsPanel.h"
+#include "StepLaneEditor.h"
+#include "SongEditor.h"
+#include "TupletEditor.h"
 
 //==============================================================================
 /**
@@ -27,15 +32,17 @@ public:
     void paintMetronomeMode(juce::Graphics&);
     void paintPolyRhythmMetronomeMode(juce::Graphics&);
     void drawPolyRhythmCircle(juce::Graphics& g, int radius, int width, int height, int X, int Y, int rhythmValue, float radiusSkew, juce::Colour color1, juce::Colour color, int index);
+    void paintTimingAnalysis(juce::Graphics&);
     void changeMenuButtonColors(juce::TextButton *buttonOn);
 
+    juce::Rectangle<int> getMainArea();
     juce::Rectangle<int> getVisualArea();
+    juce::Rectangle<int> getAnalysisArea();
 
     void resized() override;
-    void timerCallback() override {
-        repaint();
-    };
+    void timerCallback() override;
 
+    void setMode(int mode);
     void toggleAudioProcessorChildrenStates();
     void togglePlayState();
     void togglePlayStateOff();
@@ -52,9 +59,11 @@ private:
     juce::TextButton polyMeterButton{ "PolyMeter" };
     juce::TextButton loadPresetButton{ "load preset" };
     juce::TextButton savePresetButton{ "save preset" };
+    juce::TextButton loadKitButton{ "load kit" };
 
     void loadPreset();
     void savePreset();
+    void loadKit();
     std::unique_ptr<juce::FileChooser> fileChooser;
 
     //Sliders
@@ -62,9 +71,41 @@ private:
     RotarySliderWithLabels    bpmSlider, subdivisionSlider, numeratorSlider;
     juce::AudioProcessorValueTreeState::SliderAttachment bpmAttachment, subdivisionAttachment, numeratorAttachment;
 
-    //polyrhythm metronome buttons
-    juce::ToggleButton Rhythm1Buttons[MAX_LENGTH];
-    juce::ToggleButton Rhythm2Buttons[MAX_LENGTH];
+    //picks where NUMERATOR/SUBDIVISION edits take effect while playing
+    juce::ComboBox quantizeBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> quantizeAttachment;
+
+    //tempo follow, the BPM slider shows the followed tempo while it's on
+    juce::ToggleButton followButton{ "follow" };
+    juce::AudioProcessorValueTreeState::ButtonAttachment followAttachment{ audioProcessor.apvts, "FOLLOW", followButton };
+
+    //local sync between instances on this machine, the BPM slider shows the leader's tempo while following
+    juce::ComboBox localSyncBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> localSyncAttachment;
+
+    //timing analysis, the statistics are painted under these in the analysis area
+    juce::ToggleButton analyzeButton{ "analyze" };
+    juce::AudioProcessorValueTreeState::ButtonAttachment analyzeAttachment{ audioProcessor.apvts, "ANALYZE", analyzeButton };
+    juce::TextButton resetStatsButton{ "reset stats" };
+    juce::Slider roundTripSlider{ juce::Slider::SliderStyle::LinearHorizontal, juce::Slider::TextEntryBoxPosition::TextBoxRight };
+    juce::AudioProcessorValueTreeState::SliderAttachment roundTripAttachment{ audioProcessor.apvts, "ROUNDTRIP_MS", roundTripSlider };
+
+    //DSP load, overruns and engine counters, hidden until the button turns it on
+    juce::ToggleButton diagnosticsButton{ "diagnostics" };
+    DiagnosticsPanel diagnosticsPanel{ audioProcessor.diagnostics };
+
+    bool wasDawConnected = false; //DAW_CONNECTED at the last paint, for logging when it changes
+
+    //polyrhythm metronome steps of both rhythms
+    StepGrid stepGrid{ audioProcessor.stepPatterns, audioProcessor.displayState };
+
+    //everything about the steps that isn't on/off, in tabs along the bottom under the sliders
+    static constexpr int stepEditorsHeight = 180;
+    StepLaneEditor laneEditor{ audioProcessor.stepPatterns };
+    GrooveEditor grooveEditor{ audioProcessor.stepPatterns };
+    TupletEditor tupletEditor{ audioProcessor.stepPatterns };
+    SongEditor songEditor{ audioProcessor.songStore, audioProcessor.stepPatterns };
+    juce::TabbedComponent stepEditors{ juce::TabbedButtonBar::TabsAtTop };
 
 
     std::vector<juce::Component*> getVisibleComps();
@@ -9,6 +9,7 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include <string>
+#include <numeric>
 
 using namespace std;
 //==============================================================================
@@ -20,14 +21,523 @@ MetroGnomeAudioProcessor::MetroGnomeAudioProcessor()
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
 #endif
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
+        //optional per sound outputs for monitor mixes, in ClickSampleId order, a sound goes to the main output while its bus is disabled
+        .withOutput("Accent", juce::AudioChannelSet::stereo(), false)
+        .withOutput("Beat", juce::AudioChannelSet::stereo(), false)
+        .withOutput("Subdivision", juce::AudioChannelSet::stereo(), false)
 #endif
     )
 #endif
 {
+    //no audio is running yet, so the initial config can be made active straight away
+    rhythmConfigs.publish(RhythmConfig::fromParameters(apvts));
+    rhythmConfigs.acquire();
+    engineMode = (int)apvts.getRawParameterValue("MODE")->load();
+    activeEngine = RhythmEngine::createForMode(engineMode, &apvts, &rhythmConfigs, &stepPatterns.getExchange(), &displayState, &scheduledClicks);
+    apvts.addParameterListener("NUMERATOR", this);
+    apvts.addParameterListener("SUBDIVISION", this);
+    apvts.addParameterListener("MODE", this);
+    apvts.addParameterListener("AUDIO_OFFSET_MS", this);
+    apvts.addParameterListener("MIDI_OFFSET_MS", this);
+    apvts.addParameterListener("LOCAL_SYNC", this);
+    kitLoader.onLoaded = [this](std::unique_ptr<ClickKit> kit)
+    {
+        //a kit the audio thread hasn't picked up yet was never played, so it can go straight away
+        delete pendingKit.exchange(kit.release());
+    };
+    songStore.onChange = [this]
+    {
+        isSongOutdated.store(true);
+        triggerAsyncUpdate();
+    };
+    //the sections share the store's lanes, grooves and tuplets
+    stepPatterns.onChange = songStore.onChange;
 }
 
 MetroGnomeAudioProcessor::~MetroGnomeAudioProcessor()
 {
+    kitLoader.stopLoading();
+    apvts.removeParameterListener("NUMERATOR", this);
+    apvts.removeParameterListener("SUBDIVISION", this);
+    apvts.removeParameterListener("MODE", this);
+    apvts.removeParameterListener("AUDIO_OFFSET_MS", this);
+    apvts.removeParameterListener("MIDI_OFFSET_MS", this);
+    apvts.removeParameterListener("LOCAL_SYNC", this);
+    cancelPendingUpdate();
+    delete pendingEngine.exchange(nullptr);
+    delete retiredEngine.exchange(nullptr);
+    delete pendingSong.exchange(nullptr);
+    delete retiredSong.exchange(nullptr);
+    delete pendingKit.exchange(nullptr);
+    delete retiredKit.exchange(nullptr);
+}
+
+void MetroGnomeAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    //can be called from the audio thread during automation, so building the pending config is deferred to the message thread
+    triggerAsyncUpdate();
+}
+
+void MetroGnomeAudioProcessor::handleAsyncUpdate()
+{
+    //an engine (or song) swapped out by the audio thread is deleted here, never on the audio thread
+    delete retiredEngine.exchange(nullptr);
+    delete retiredSong.exchange(nullptr);
+    freeRetiredKits();
+
+    //the message thread is the only writer of pending configs
+    rhythmConfigs.publish(RhythmConfig::fromParameters(apvts));
+
+    //read once, prepareToPlay can run on another thread in the middle of this
+    const double sampleRate = preparedSampleRate.load();
+    int mode = (int)apvts.getRawParameterValue("MODE")->load();
+    const bool isEngineStale = isEngineOutdated.exchange(false);
+    if ((mode != engineMode || isEngineStale) && mode >= 0 && mode <= 2)
+    {
+        engineMode = mode;
+        auto engine = RhythmEngine::createForMode(mode, &apvts, &rhythmConfigs, &stepPatterns.getExchange(), &displayState, &scheduledClicks);
+        if (sampleRate > 0)
+        {
+            engine->prepareToPlay(sampleRate, preparedBlockSize.load());
+        }
+        //an engine the audio thread hasn't picked up yet was never used, so it can go straight away
+        delete pendingEngine.exchange(engine.release());
+    }
+
+    if (sampleRate > 0 && isSongOutdated.exchange(false))
+    {
+        delete pendingSong.exchange(compileSong().release());
+    }
+
+    updateLookahead();
+
+    //the segment stays mapped once it is, LOCAL_SYNC just stops reading or writing it
+    if (apvts.getRawParameterValue("LOCAL_SYNC")->load() > 0)
+    {
+        phaseClock.open();
+    }
+}
+
+void MetroGnomeAudioProcessor::updateLookahead()
+{
+    //message thread, the earliest output decides how far ahead the engines have to run, nothing is added while every offset is positive
+    const double sampleRate = preparedSampleRate.load();
+    if (sampleRate <= 0)
+    {
+        return;
+    }
+    float earliestOffsetMs = juce::jmin(apvts.getRawParameterValue("AUDIO_OFFSET_MS")->load(), apvts.getRawParameterValue("MIDI_OFFSET_MS")->load());
+    int lookahead = earliestOffsetMs < 0 ? juce::roundToInt(-earliestOffsetMs * sampleRate / 1000.0) : 0;
+    if (lookahead != lookaheadSamples.load())
+    {
+        lookaheadSamples.store(lookahead);
+        setLatencySamples(lookahead);
+    }
+}
+
+void MetroGnomeAudioProcessor::restartActiveEngine()
+{
+    //audio thread, or while audio is stopped
+    activeEngine->resetParams();
+    activeEngine->resetAll();
+    loopCache.restart();
+    engineBeats = 0;
+    markBlockPath(engineRestarted);
+}
+
+void MetroGnomeAudioProcessor::swapInPendingEngine()
+{
+    //audio thread, waits until the message thread has deleted the previous retired engine
+    if (retiredEngine.load() != nullptr)
+    {
+        return;
+    }
+    if (auto* nextEngine = pendingEngine.exchange(nullptr))
+    {
+        if (nextEngine->getSampleRate() != preparedSampleRate.load(std::memory_order_relaxed))
+        {
+            //prepared for the sample rate before the last prepareToPlay, which asked for another one
+            retiredEngine.store(nextEngine);
+            isEngineOutdated.store(true);
+            triggerAsyncUpdate();
+            return;
+        }
+        retiredEngine.store(activeEngine.release());
+        activeEngine.reset(nextEngine);
+        activeEngine->useKit(*activeKit);
+        restartActiveEngine();
+        markBlockPath(engineSwapped);
+        triggerAsyncUpdate();
+    }
+}
+
+void MetroGnomeAudioProcessor::swapInPendingKit()
+{
+    //audio thread, same handover as swapInPendingEngine, every engine that can play switches its voices over before the old kit is handed back
+    if (retiredKit.load() != nullptr)
+    {
+        return;
+    }
+    if (auto* nextKit = pendingKit.exchange(nullptr))
+    {
+        if (nextKit->getSampleRate() != preparedSampleRate.load(std::memory_order_relaxed) || (isPreparedDouble.load(std::memory_order_relaxed) && !nextKit->hasDoubleData()))
+        {
+            //built for the sample rate or precision before the last prepareToPlay, which asked for another one
+            retiredKit.store(nextKit);
+            triggerAsyncUpdate();
+            return;
+        }
+        retiredKit.store(activeKit.release());
+        activeKit.reset(nextKit);
+        useActiveKit();
+        kitSerial++;
+        triggerAsyncUpdate();
+    }
+}
+
+void MetroGnomeAudioProcessor::useActiveKit()
+{
+    //audio thread, or while audio is stopped
+    activeEngine->useKit(*activeKit);
+    if (activeSong != nullptr)
+    {
+        for (auto& engine : activeSong->engines)
+        {
+            if (engine != nullptr)
+            {
+                engine->useKit(*activeKit);
+            }
+        }
+    }
+}
+
+void MetroGnomeAudioProcessor::freeRetiredKits()
+{
+    //message thread, a kit is only freed once no voice, loop cache snapshot or retired engine holds its samples any more,
+    //so the audio thread never lets go of the last reference to one
+    const juce::ScopedLock sl(retiredKitsLock);
+    if (auto* kit = retiredKit.exchange(nullptr))
+    {
+        retiredKits.emplace_back(kit);
+    }
+    retiredKits.erase(std::remove_if(retiredKits.begin(), retiredKits.end(), [](const std::unique_ptr<ClickKit>& kit) { return kit->isOnlyUser(); }), retiredKits.end());
+}
+
+void MetroGnomeAudioProcessor::loadClickKit(const juce::File& folder)
+{
+    //message thread, the kit is built at the prepared sample rate, or at the next prepareToPlay's
+    //the folder is kept in the state too, so a saved session or preset brings its kit back
+    apvts.state.setProperty(kitFolderId, folder.getFullPathName(), nullptr);
+    {
+        const juce::ScopedLock sl(kitFolderLock);
+        kitFolder = folder;
+    }
+    const double sampleRate = preparedSampleRate.load();
+    if (sampleRate <= 0)
+    {
+        return;
+    }
+    if (folder == juce::File())
+    {
+        //the built in clicks are already decoded for this rate, they go in the way a loaded kit does
+        delete pendingKit.exchange(ClickKit::createBuiltIn(*sampleCache, sampleRate, isPreparedDouble.load()).release());
+        return;
+    }
+    kitLoader.load(folder, sampleRate, isPreparedDouble.load());
+}
+
+juce::File MetroGnomeAudioProcessor::getClickKitFolder() const
+{
+    const juce::ScopedLock sl(kitFolderLock);
+    return kitFolder;
+}
+
+
+std::unique_ptr<CompiledSong> MetroGnomeAudioProcessor::compileSong()
+{
+    //message thread, every engine the song needs is built and prepared here so the audio thread only has to switch between them
+    auto song = std::make_unique<CompiledSong>();
+    const double sampleRate = preparedSampleRate.load();
+    const int blockSize = preparedBlockSize.load();
+    const auto& sections = songStore.getSections();
+    song->sampleRate = sampleRate;
+    song->timeline.compile(sections, sampleRate);
+    for (const auto& section : sections)
+    {
+        auto patterns = stepPatterns.getPatterns();
+        patterns.voices = section.patterns;
+        song->sectionPatterns.push_back(patterns);
+
+        auto& engine = song->engines[(size_t)section.mode];
+        if (engine == nullptr)
+        {
+            engine = RhythmEngine::createForMode(section.mode, &apvts, &song->configs, &song->patterns, &displayState, &scheduledClicks);
+            engine->prepareToPlay(sampleRate, blockSize);
+        }
+    }
+    return song;
+}
+
+void MetroGnomeAudioProcessor::swapInPendingSong()
+{
+    //audio thread, same handover as swapInPendingEngine
+    if (retiredSong.load() != nullptr)
+    {
+        return;
+    }
+    if (auto* nextSong = pendingSong.exchange(nullptr))
+    {
+        if (nextSong->sampleRate != preparedSampleRate.load(std::memory_order_relaxed))
+        {
+            //compiled for the sample rate before the last prepareToPlay, the message thread compiles it again
+            retiredSong.store(nextSong);
+            isSongOutdated.store(true);
+            triggerAsyncUpdate();
+            return;
+        }
+        retiredSong.store(activeSong.release());
+        activeSong.reset(nextSong);
+        useActiveKit();
+        songSection = -1;
+        markBlockPath(songSwapped);
+        triggerAsyncUpdate();
+    }
+}
+
+void MetroGnomeAudioProcessor::enterSongSection(int index)
+{
+    //audio thread, a section starts like a host starting to play: its settings go in and the engine counts from the position it's given
+    const auto& section = activeSong->timeline.getSection(index);
+    apvts.getRawParameterValue("BPM")->store((float)section.bpm);
+    apvts.getRawParameterValue("DAW_CONNECTED")->store(true);
+    apvts.getRawParameterValue("DAW_PLAYING")->store(true);
+
+    RhythmConfig config;
+    config.numerator = section.numerator;
+    config.subdivisions = section.subdivisions;
+    activeSong->configs.publish(config);
+    activeSong->configs.acquire();
+    activeSong->patterns.publish(activeSong->sectionPatterns[(size_t)index]);
+    activeSong->patterns.acquire();
+
+    auto& engine = *activeSong->engines[(size_t)section.mode];
+    engine.resetParams();
+    engine.resetAll();
+    songSection = index;
+}
+
+void MetroGnomeAudioProcessor::stopPlayingSong()
+{
+    //audio thread, hands the params back to the normal engine
+    if (isPlayingSong)
+    {
+        isPlayingSong = false;
+        songSection = -1;
+        expectedSongPosition = -1;
+        apvts.getRawParameterValue("DAW_CONNECTED")->store(false);
+        apvts.getRawParameterValue("DAW_PLAYING")->store(false);
+        restartActiveEngine();
+    }
+}
+
+template <typename SampleType>
+void MetroGnomeAudioProcessor::renderSong(OutputRouting<SampleType>& routing, juce::MidiBuffer& midiMessages, juce::int64 position, int clickDelay, bool isAnalyzing)
+{
+    const auto& timeline = activeSong->timeline;
+    const int numSamples = routing.main.getNumSamples();
+    if (position != expectedSongPosition)
+    {
+        //the host seeked, looped or jumped, the section is found again and its engine starts over from the new position
+        songSection = -1;
+    }
+    expectedSongPosition = position + numSamples;
+
+    //the block is rendered in pieces split at section boundaries, so a new section starts on its exact sample
+    int blockOffset = 0;
+    while (blockOffset < numSamples)
+    {
+        const juce::int64 now = position + blockOffset;
+        const int section = timeline.findSection(now);
+        if (section < 0)
+        {
+            //pre-roll before the song starts
+            blockOffset += (int)juce::jmin<juce::int64>(numSamples - blockOffset, timeline.getSectionStart(0) - now);
+            continue;
+        }
+        if (section >= timeline.getNumSections())
+        {
+            //the song is over
+            break;
+        }
+        if (section != songSection)
+        {
+            enterSongSection(section);
+        }
+
+        const int pieceSize = (int)juce::jmin<juce::int64>(numSamples - blockOffset, timeline.getSectionEnd(section) - now);
+        auto& engine = *activeSong->engines[(size_t)timeline.getSection(section).mode];
+        //wrapped by the engine's cycle like followLeader does, the param is a float and a long section would lose whole samples
+        apvts.getRawParameterValue("DAW_SAMPLES_ELAPSED")->store((float)((now - timeline.getSectionStart(section)) % juce::jmax<juce::int64>(1, engine.getCycleLength())));
+
+        OutputRouting<SampleType> piece;
+        piece.referToPartOf(routing, blockOffset, pieceSize);
+        sectionMidi.clear();
+        scheduledClicks.beginBlock(processedSamples + blockOffset, isAnalyzing);
+
+        engine.setClickDelay(clickDelay);
+        engine.getNextAudioBlock(piece, sectionMidi);
+        midiMessages.addEvents(sectionMidi, 0, -1, blockOffset);
+
+        blockOffset += pieceSize;
+    }
+}
+
+
+LoopKey MetroGnomeAudioProcessor::makeLoopKey(int clickDelay, int numChannels, bool isDouble)
+{
+    //audio thread, the settings the active engine is playing with
+    LoopKey key;
+    const auto& config = rhythmConfigs.getActive();
+    key.mode = activeEngine->getMode();
+    key.numerator = config.numerator;
+    key.subdivisions = config.subdivisions;
+    key.bpm = apvts.getRawParameterValue("BPM")->load();
+    key.swing = apvts.getRawParameterValue("SWING")->load();
+    key.rotate1 = apvts.getRawParameterValue("RHYTHM1_ROTATE")->load();
+    key.rotate2 = apvts.getRawParameterValue("RHYTHM2_ROTATE")->load();
+    key.patternsSerial = stepPatternsSerial;
+    key.kitSerial = kitSerial;
+    key.clickDelay = clickDelay;
+    key.numChannels = numChannels;
+    key.isDouble = isDouble;
+    return key;
+}
+
+
+void MetroGnomeAudioProcessor::followInputTempo()
+{
+    //audio thread, the host tempo and position are ignored while following
+    apvts.getRawParameterValue("DAW_CONNECTED")->store(false);
+
+    if (!tempoFollower.isLocked())
+    {
+        //nothing to follow yet (or any more), the engine keeps its own clock at the last tempo
+        stopFollowingInput();
+        return;
+    }
+
+    //BPM only moves in whole steps of its slider, the engines work out their intervals again without restarting
+    double bpm = juce::jlimit(1.0, 300.0, std::round(tempoFollower.getBpm() * 10.0) / 10.0);
+    if (std::abs(apvts.getRawParameterValue("BPM")->load() - bpm) >= 0.1)
+    {
+        apvts.getRawParameterValue("BPM")->store((float)bpm);
+        activeEngine->resetParams();
+    }
+
+    //the followed position is wrapped after a whole number of bars and polymeter cycles so it stays exact as a float,
+    //the engines see the same steps on either side of the wrap
+    const auto& config = rhythmConfigs.getActive();
+    juce::int64 beatsPerCycle = std::lcm(4, std::lcm(config.numerator, config.subdivisions));
+    double beatInterval = (60.0 / bpm) * getSampleRate();
+    //the engines run the lookahead ahead of the player, so what they output after the delay lands on the player's beat
+    double samplesElapsed = ((double)(tempoFollower.getBeatCount() % beatsPerCycle) + tempoFollower.getBeatPhase()) * beatInterval + lookaheadSamples.load(std::memory_order_relaxed);
+    apvts.getRawParameterValue("DAW_SAMPLES_ELAPSED")->store((float)juce::roundToInt(samplesElapsed));
+
+    if (!isFollowingInput)
+    {
+        //the engines start counting from the followed position, same as when a host starts playing
+        isFollowingInput = true;
+        apvts.getRawParameterValue("DAW_PLAYING")->store(true);
+        restartActiveEngine();
+    }
+}
+
+void MetroGnomeAudioProcessor::stopFollowingInput()
+{
+    //audio thread, hands the engines back their own clock
+    if (isFollowingInput)
+    {
+        isFollowingInput = false;
+        apvts.getRawParameterValue("DAW_PLAYING")->store(false);
+        restartActiveEngine();
+    }
+}
+
+
+void MetroGnomeAudioProcessor::followLeader(juce::int64 blockTicks, int numSamples)
+{
+    //audio thread, the host tempo and position are ignored while following
+    apvts.getRawParameterValue("DAW_CONNECTED")->store(false);
+
+    //a read that kept landing on the leader's writes leaves the last frame, which is carried forward the same way and goes stale the same way
+    phaseClock.read(leaderFrame);
+    const auto& frame = leaderFrame;
+    //the leader's block can start after this one, so this can be negative
+    const double secondsSincePublished = juce::Time::highResolutionTicksToSeconds(blockTicks - frame.blockTicks);
+    if (!frame.isPlaying || frame.sampleRate <= 0 || secondsSincePublished > PhaseClock::staleSeconds)
+    {
+        //the leader stopped or went away, the engines keep their own clock at the last tempo
+        stopFollowingLeader();
+        return;
+    }
+
+    double bpm = juce::jlimit(1.0, 300.0, frame.bpm);
+    if (apvts.getRawParameterValue("BPM")->load() != (float)bpm)
+    {
+        apvts.getRawParameterValue("BPM")->store((float)bpm);
+        activeEngine->resetParams();
+    }
+
+    //where the leader is at the start of this block, to the sample rather than the block, counted in beats so a tempo change on
+    //the leader moves both instances' grids together instead of putting a position from the old tempo on the new one
+    const double target = frame.beats + secondsSincePublished * frame.bpm / 60.0;
+    bool isStarting = !isFollowingLeader;
+    if (isStarting)
+    {
+        isFollowingLeader = true;
+        leaderBeats = target;
+    }
+    else
+    {
+        //the processes' callbacks jitter against each other by a fraction of a block, so small errors are eased out over a few blocks
+        //rather than moving each click by the jitter, anything over 20ms is the leader seeking or restarting and is jumped to
+        const double error = target - leaderBeats;
+        leaderBeats += std::abs(error) > 0.02 * bpm / 60.0 ? error : error * 0.125;
+    }
+
+    //wrapped after a whole cycle of the engine so it stays exact as a float, the engines see the same steps on either side of the wrap
+    const double samplesPerBeat = activeEngine->getSamplesPerBeat();
+    const juce::int64 cycleLength = activeEngine->getCycleLength();
+    double beats = juce::jmax(0.0, leaderBeats);
+    if (cycleLength > 0)
+    {
+        beats = std::fmod(beats, (double)cycleLength / samplesPerBeat);
+    }
+    juce::int64 position = std::llround(beats * samplesPerBeat);
+    if (cycleLength > 0)
+    {
+        position %= cycleLength;
+    }
+    apvts.getRawParameterValue("DAW_SAMPLES_ELAPSED")->store((float)position);
+    leaderBeats += numSamples / samplesPerBeat;
+
+    if (isStarting)
+    {
+        //the engines start counting from the leader's position, same as when a host starts playing
+        apvts.getRawParameterValue("DAW_PLAYING")->store(true);
+        restartActiveEngine();
+    }
+}
+
+void MetroGnomeAudioProcessor::stopFollowingLeader()
+{
+    //audio thread, hands the engines back their own clock
+    if (isFollowingLeader)
+    {
+        isFollowingLeader = false;
+        apvts.getRawParameterValue("DAW_PLAYING")->store(false);
+        restartActiveEngine();
+    }
 }
 
 
@@ -35,8 +545,65 @@ void MetroGnomeAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBl
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    metronome.prepareToPlay(sampleRate, samplesPerBlock);
-    polyRhythmMetronome.prepareToPlay(sampleRate, samplesPerBlock);
+    preparedBlockSize.store(samplesPerBlock);
+    preparedSampleRate.store(sampleRate);
+    //the host sets the precision before preparing, only a double precision one needs the clicks' double copies
+    const bool isDouble = isUsingDoublePrecision();
+    isPreparedDouble.store(isDouble);
+
+    //the audio thread isn't running, so a waiting engine can be made active directly
+    if (auto* nextEngine = pendingEngine.exchange(nullptr))
+    {
+        activeEngine.reset(nextEngine);
+    }
+    activeEngine->prepareToPlay(sampleRate, samplesPerBlock);
+    //the voices are back on the built in clicks at the new rate, a user kit is built again for it in the background
+    if (activeKit == nullptr || activeKit->getSampleRate() != sampleRate || (isDouble && !activeKit->hasDoubleData()))
+    {
+        if (activeKit != nullptr)
+        {
+            const juce::ScopedLock sl(retiredKitsLock);
+            retiredKits.emplace_back(activeKit.release());
+        }
+        activeKit = ClickKit::createBuiltIn(*sampleCache, sampleRate, isDouble);
+        kitSerial++;
+        const auto folder = getClickKitFolder();
+        if (folder != juce::File())
+        {
+            kitLoader.load(folder, sampleRate, isDouble);
+        }
+    }
+    activeEngine->useKit(*activeKit);
+    restartActiveEngine();
+    tempoFollower.prepare(sampleRate, samplesPerBlock);
+    timingAnalyzer.prepare(sampleRate); //also empties scheduledClicks, processedSamples starts over below
+    loopCache.prepare(sampleRate, samplesPerBlock);
+    processedSamples = 0;
+    diagnostics.loadMeasurer.reset(sampleRate, samplesPerBlock);
+    lastCallbackMs = 0;
+    lastBlockMs = 0;
+    expectedHostTime = -1;
+
+    //the song reads the stores the message thread edits, so it's compiled again there for the new sample rate,
+    //one compiled at the old rate is dropped now, nothing is playing
+    delete pendingSong.exchange(nullptr);
+    if (activeSong != nullptr && activeSong->sampleRate != sampleRate)
+    {
+        activeSong.reset();
+    }
+    isSongOutdated.store(true);
+    triggerAsyncUpdate();
+    useActiveKit();
+    songSection = -1;
+    songPosition = 0;
+    expectedSongPosition = -1;
+    sectionMidi.ensureSize(2048);
+
+    midiDelay.reset();
+    const int maxLookahead = (int)std::ceil(maxOutputOffsetMs * sampleRate / 1000.0);
+    floatState.inputDelay.prepare(getTotalNumInputChannels(), maxLookahead, samplesPerBlock);
+    doubleState.inputDelay.prepare(getTotalNumInputChannels(), maxLookahead, samplesPerBlock);
+    updateLookahead();
 }
 
 void MetroGnomeAudioProcessor::releaseResources()
@@ -48,29 +615,110 @@ void MetroGnomeAudioProcessor::releaseResources()
 
 void MetroGnomeAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    processSamples(buffer, midiMessages);
+}
+
+void MetroGnomeAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+template <typename SampleType>
+void MetroGnomeAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
+{
+    TRACE_SCOPE("processBlock");
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(diagnostics.loadMeasurer, buffer.getNumSamples());
+    auto& precisionState = getPrecisionState<SampleType>();
+#if METROGNOME_BLOCK_PATHS
+    blockPath = 0;
+#endif
+    swapInPendingEngine();
+    swapInPendingSong();
+    swapInPendingKit();
+    //step edits apply straight away, they don't wait for a quantized boundary like NUMERATOR/SUBDIVISION
+    if (stepPatterns.getExchange().acquire())
+    {
+        stepPatternsSerial++;
+        markBlockPath(patternsAcquired);
+    }
+
+    if (resetRequested.exchange(false))
+    {
+        //the user restarted or switched modes, pending edits don't need to wait for a boundary
+        rhythmConfigs.acquire();
+        restartActiveEngine();
+        songPosition = 0;
+        songSection = -1;
+        markBlockPath(resetHandled);
+    }
    
     auto positionInfo = getPlayHead()->getPosition();
-    if (positionInfo) {
+    //the monotonic clock every instance on the machine shares, LOCAL_SYNC places blocks against each other with it
+    const auto blockTicks = juce::Time::getHighResolutionTicks();
+
+    //a playing host always wins over the follower, the input is only analysed while it's the one in charge
+    //a song sets its own tempo and meter, so it wins over both, the host only tells it where to play from
+    //following a leader through LOCAL_SYNC stands in for a host, so it wins over the input
+    bool isHostPlaying = positionInfo && positionInfo->getIsPlaying();
+    bool isSongMode = apvts.getRawParameterValue("SONG")->load() && activeSong != nullptr && activeSong->timeline.getNumSections() > 0;
+    const int localSync = (int)apvts.getRawParameterValue("LOCAL_SYNC")->load();
+    bool isSyncFollowing = localSync == 2 && !isHostPlaying && !isSongMode;
+    bool isFollowingTempo = apvts.getRawParameterValue("FOLLOW")->load() && !isHostPlaying && !isSongMode && !isSyncFollowing;
+    if (isFollowingTempo)
+    {
+        if (!isAnalysingInput)
+        {
+            //the grid from the last time following was on is stale, start listening from scratch
+            tempoFollower.reset();
+            isAnalysingInput = true;
+        }
+        //the click is added to the same buffer afterwards, so the input is read before anything is rendered
+        if (getBusCount(true) > 0)
+        {
+            tempoFollower.process(getBusBuffer(buffer, true, 0));
+        }
+        followInputTempo();
+        markBlockPath(followingTempo);
+    }
+    else
+    {
+        isAnalysingInput = false;
+        stopFollowingInput();
+    }
+
+    if (isSyncFollowing)
+    {
+        followLeader(blockTicks, buffer.getNumSamples());
+        markBlockPath(followingLeader);
+    }
+    else
+    {
+        stopFollowingLeader();
+    }
+
+    if (!isSongMode)
+    {
+        stopPlayingSong();
+    }
+
+    if (positionInfo && !isFollowingTempo && !isSongMode && !isSyncFollowing) {
 
         auto bpmInfo = (*positionInfo).getBpm();
         auto timeInfo = (*positionInfo).getTimeInSamples();
         auto isPlayingInfo = (*positionInfo).getIsPlaying();
         if (bpmInfo) {
             apvts.getRawParameterValue("DAW_CONNECTED")->store(true);
+            markBlockPath(hostConnected);
             if (apvts.getRawParameterValue("BPM")->load() != *bpmInfo) {
                 apvts.getRawParameterValue("BPM")->store(*bpmInfo);
-                metronome.resetParams();
-                metronome.resetAll();
-                polyRhythmMetronome.resetAll();
+                restartActiveEngine();
             }
             if (timeInfo && isPlayingInfo) {
                 apvts.getRawParameterValue("DAW_SAMPLES_ELAPSED")->store(*timeInfo);
                 bool isDawPlaying = apvts.getRawParameterValue("DAW_PLAYING")->load();
                 if (isDawPlaying != isPlayingInfo) {
                     apvts.getRawParameterValue("DAW_PLAYING")->store(isPlayingInfo);
-                    metronome.resetParams();
-                    metronome.resetAll();
-                    polyRhythmMetronome.resetAll();
+                    restartActiveEngine();
                 }
             }
         }
@@ -79,18 +727,172 @@ void MetroGnomeAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, ju
         }
     }
 
-   
+    //timing analysis, the input goes to the worker thread before the click is added to the same buffer
+    bool isAnalyzing = apvts.getRawParameterValue("ANALYZE")->load();
+    if (isAnalyzing && getBusCount(true) > 0)
+    {
+        timingAnalyzer.setRoundTripLatency(juce::roundToInt(apvts.getRawParameterValue("ROUNDTRIP_MS")->load() * getSampleRate() / 1000.0));
+        timingAnalyzer.pushInput(getBusBuffer(buffer, true, 0), processedSamples);
+    }
+    scheduledClicks.beginBlock(processedSamples, isAnalyzing);
+    if (isAnalyzing)
+    {
+        markBlockPath(analyzing);
+    }
+
+    //the passthrough is held back by the lookahead, as the host moves the whole output earlier by that much
+    const int lookahead = lookaheadSamples.load(std::memory_order_relaxed);
+    if (getBusCount(true) > 0)
+    {
+        auto input = getBusBuffer(buffer, true, 0);
+        precisionState.inputDelay.process(input, lookahead);
+    }
+
     midiMessages.clear();
-    auto mode = apvts.getRawParameterValue("MODE")->load();
 
-    if (apvts.getRawParameterValue("ON/OFF")->load() == true && mode == 0)
+    //outputs without a matching input hold garbage, the aux buses are output only
+    for (auto i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
+        buffer.clear(i, 0, buffer.getNumSamples());
+
+    //views onto the host's channel pointers, a disabled bus has no channels so its sound falls back to the main bus
+    auto& outputRouting = precisionState.outputRouting;
+    outputRouting.main = getBusBuffer(buffer, false, 0);
+    for (int slot = 0; slot < OutputRouting<SampleType>::numSoundSlots; slot++)
+    {
+        int busIndex = slot + 1;
+        outputRouting.auxBuses[(size_t)slot] = busIndex < getBusCount(false) ? getBusBuffer(buffer, false, busIndex) : juce::AudioBuffer<SampleType>();
+    }
+
+    bool isOn = apvts.getRawParameterValue("ON/OFF")->load();
+
+    if (!isOn && rhythmConfigs.acquire())
+    {
+        //nothing is playing so there is no boundary to wait for
+        activeEngine->resetParams();
+    }
+
+    const double samplesPerMs = getSampleRate() / 1000.0;
+    const int clickDelay = juce::jmax(0, lookahead + juce::roundToInt(apvts.getRawParameterValue("AUDIO_OFFSET_MS")->load() * samplesPerMs));
+    if (isOn && isSongMode)
+    {
+        //a playing host places the song, otherwise it runs on from wherever it was
+        juce::int64 position = songPosition;
+        if (isHostPlaying && positionInfo->getTimeInSamples())
+        {
+            position = *positionInfo->getTimeInSamples();
+        }
+        isPlayingSong = true;
+        renderSong(outputRouting, midiMessages, position, clickDelay, isAnalyzing);
+        markBlockPath(renderedSong);
+        songPosition = position + buffer.getNumSamples();
+    }
+    else if (isOn && apvts.getRawParameterValue("LOOP_CACHE")->load())
+    {
+        //the loop only stands in for the engine on its own clock with every sound on the main output, it hands back to the engine otherwise
+        activeEngine->setClickDelay(clickDelay);
+        bool hasAuxOutput = std::any_of(outputRouting.auxBuses.begin(), outputRouting.auxBuses.end(), [](const auto& aux) { return aux.getNumChannels() > 0; });
+        bool isCacheable = !apvts.getRawParameterValue("DAW_CONNECTED")->load() && !apvts.getRawParameterValue("DAW_PLAYING")->load()
+            && !rhythmConfigs.hasPending() && !hasAuxOutput;
+        loopCache.process(*activeEngine, *activeKit, outputRouting, midiMessages, makeLoopKey(clickDelay, outputRouting.main.getNumChannels(), std::is_same_v<SampleType, double>), isCacheable, processedSamples, isAnalyzing);
+        markBlockPath(renderedLoopCache);
+    }
+    else if (isOn)
+    {
+        //the engine already knows its mode and picks its channel specialized render loop itself
+        activeEngine->setClickDelay(clickDelay);
+        activeEngine->getNextAudioBlock(outputRouting, midiMessages);
+        markBlockPath(renderedEngine);
+    }
+    if (!isOn || isSongMode || !apvts.getRawParameterValue("LOOP_CACHE")->load())
+    {
+        //the engine didn't go through the loop cache this block, so a loop can't line up with it any more
+        loopCache.restart();
+    }
+    //runs while off too, so notes already waiting still get out
+    {
+        TRACE_SCOPE("MIDI delay");
+        midiDelay.process(midiMessages, buffer.getNumSamples(), juce::jmax(0, lookahead + juce::roundToInt(apvts.getRawParameterValue("MIDI_OFFSET_MS")->load() * samplesPerMs)));
+    }
+
+    //what the leader publishes is where its engine started this block, while a host or a follower drives the engine that's their position,
+    //in beats at the tempo the engine played the block at, so it carries on from the same beat after a tempo change
+    const double samplesPerBeat = activeEngine->getSamplesPerBeat();
+    const double blockBeats = apvts.getRawParameterValue("DAW_PLAYING")->load() ? apvts.getRawParameterValue("DAW_SAMPLES_ELAPSED")->load() / samplesPerBeat : engineBeats;
+    engineBeats = blockBeats + buffer.getNumSamples() / samplesPerBeat;
+    if (localSync == 1)
     {
-        metronome.getNextAudioBlock(buffer);
+        PhaseClock::Frame frame;
+        frame.sampleRate = getSampleRate();
+        frame.bpm = apvts.getRawParameterValue("BPM")->load();
+        frame.beats = blockBeats;
+        frame.sampleClock = processedSamples;
+        frame.blockTicks = blockTicks;
+        frame.isPlaying = isOn && !isSongMode;
+        if (phaseClock.publish(frame))
+        {
+            markBlockPath(leading);
+        }
     }
-    else if (apvts.getRawParameterValue("ON/OFF")->load() == true && mode == 1)
+    else
     {
-        polyRhythmMetronome.getNextAudioBlock(buffer, midiMessages);
+        phaseClock.resign();
     }
+
+    scheduledClicks.endBlock(buffer.getNumSamples());
+    updateDiagnostics(buffer.getNumSamples(), positionInfo, midiMessages);
+    processedSamples += buffer.getNumSamples();
+}
+
+void MetroGnomeAudioProcessor::updateDiagnostics(int numSamples, const juce::Optional<juce::AudioPlayHead::PositionInfo>& positionInfo, const juce::MidiBuffer& midiMessages)
+{
+    //audio thread, at the end of every block
+    DiagnosticCounters::add(diagnostics.blocks, 1);
+
+    //a callback that comes more than twice the last block's length after it means the host or driver stalled, whatever processBlock itself took
+    //the gap is the time the last block took to play, this one's length says nothing about it when the host varies its block sizes
+    const double nowMs = juce::Time::getMillisecondCounterHiRes();
+    if (lastCallbackMs > 0 && nowMs - lastCallbackMs > 2.0 * juce::jmax(lastBlockMs, 1.0))
+    {
+        DiagnosticCounters::add(diagnostics.callbackGaps, 1);
+    }
+    lastCallbackMs = nowMs;
+    lastBlockMs = numSamples * 1000.0 / getSampleRate();
+
+    const bool isHostPlaying = positionInfo && positionInfo->getIsPlaying() && positionInfo->getTimeInSamples();
+    if (isHostPlaying)
+    {
+        const juce::int64 hostTime = *positionInfo->getTimeInSamples();
+        if (expectedHostTime >= 0 && hostTime != expectedHostTime)
+        {
+            DiagnosticCounters::add(diagnostics.hostTimeJumps, 1);
+        }
+        expectedHostTime = hostTime + numSamples;
+    }
+    else
+    {
+        expectedHostTime = -1;
+    }
+
+    DiagnosticCounters::add(diagnostics.clicks, (juce::uint64)scheduledClicks.takeNumPushed());
+    DiagnosticCounters::add(diagnostics.midiEvents, (juce::uint64)midiMessages.getNumEvents());
+
+    //the song's engines drop MIDI and clicks the same way, only the live engine's voices are counted
+    int droppedMidi = midiDelay.takeNumDropped() + activeEngine->takeDroppedMidiEvents();
+    int droppedClicks = activeEngine->takeDroppedClicks();
+    if (activeSong != nullptr)
+    {
+        for (auto& engine : activeSong->engines)
+        {
+            if (engine != nullptr)
+            {
+                droppedMidi += engine->takeDroppedMidiEvents();
+                droppedClicks += engine->takeDroppedClicks();
+            }
+        }
+    }
+    DiagnosticCounters::add(diagnostics.droppedMidiEvents, (juce::uint64)droppedMidi);
+    DiagnosticCounters::add(diagnostics.droppedClicks, (juce::uint64)droppedClicks);
+    diagnostics.activeVoices.store(activeEngine->getNumActiveVoices(), std::memory_order_relaxed);
 }
 
 
@@ -118,11 +920,47 @@ juce::AudioProcessorValueTreeState::ParameterLayout MetroGnomeAudioProcessor::cr
 
     layout.add(std::make_unique<juce::AudioParameterChoice>("MODE", "Mode", stringArray, 0));
 
-    for (int i = 0; i < MAX_LENGTH; i++) {
-        //Parameters for Polyrhythm Metronome RHYTHM<1,2>.<0-MAX_LENGTH>_TOGGLE
-        layout.add(std::make_unique<juce::AudioParameterBool>("RHYTHM1."+ to_string(i) + "_TOGGLE", "Rhythm1." + to_string(i) + " Toggle", true));
-        layout.add(std::make_unique<juce::AudioParameterBool>("RHYTHM2." + to_string(i) + "_TOGGLE", "Rhythm2." + to_string(i) + " Toggle", true));
-    }
+    //where edits to NUMERATOR and SUBDIVISION take effect while playing, see ConfigQuantization
+    juce::StringArray quantizeArray;
+    quantizeArray.add("Immediate");
+    quantizeArray.add("Next Beat");
+    quantizeArray.add("Next Bar");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("QUANTIZE", "Quantize", quantizeArray, 2));
+
+    //the steps themselves live in the StepPatternStore, the host only gets these macros to rotate each pattern
+    layout.add(std::make_unique<juce::AudioParameterInt>("RHYTHM1_ROTATE", "Rhythm1 Rotate", 0, MAX_STEPS - 1, 0));
+    layout.add(std::make_unique<juce::AudioParameterInt>("RHYTHM2_ROTATE", "Rhythm2 Rotate", 0, MAX_STEPS - 1, 0));
+
+    //delays every second step in Default (subdivisions) and Polyrhythm mode, 50% is straight and 66.7% triplet swing
+    //the per step groove templates live in the StepPatternStore next to the patterns
+    layout.add(std::make_unique<juce::AudioParameterFloat>("SWING", "Swing", juce::NormalisableRange<float>(50.f, 75.f, 0.1f), 50.f));
+
+    //plays a pre-rendered cycle instead of running the engine while nothing changes, see LoopCache
+    layout.add(std::make_unique<juce::AudioParameterBool>("LOOP_CACHE", "Loop Cache", false));
+
+    //plays the SongStore's sections in order instead of the settings above, see SongTimeline
+    layout.add(std::make_unique<juce::AudioParameterBool>("SONG", "Song Mode", false));
+
+    //follows the tempo and beat of whoever is playing into the input while the host isn't playing, see TempoFollower
+    layout.add(std::make_unique<juce::AudioParameterBool>("FOLLOW", "Tempo Follow", false));
+
+    //keeps instances on the same machine together without a host, one leads and the others follow its tempo and position, see PhaseClock
+    juce::StringArray localSyncArray;
+    localSyncArray.add("Sync Off");
+    localSyncArray.add("Lead");
+    localSyncArray.add("Follow");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("LOCAL_SYNC", "Local Sync", localSyncArray, 0));
+
+    //scores the player's hits on the input against the click, see TimingAnalyzer
+    layout.add(std::make_unique<juce::AudioParameterBool>("ANALYZE", "Timing Analysis", false));
+    //time from a click leaving the plugin to the player's hit on it coming back in, taken off every hit before it's scored
+    layout.add(std::make_unique<juce::AudioParameterFloat>("ROUNDTRIP_MS", "Round Trip Latency", juce::NormalisableRange<float>(0.f, 250.f, 0.1f), 0.f));
+
+    //moves the click earlier (negative) or later on each output, to line up MIDI drum modules and wireless monitors with everything else
+    layout.add(std::make_unique<juce::AudioParameterFloat>("AUDIO_OFFSET_MS", "Audio Offset", juce::NormalisableRange<float>(-maxOutputOffsetMs, maxOutputOffsetMs, 0.1f), 0.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("MIDI_OFFSET_MS", "MIDI Offset", juce::NormalisableRange<float>(-maxOutputOffsetMs, maxOutputOffsetMs, 0.1f), 0.f));
 
     return layout;
 
@@ -146,8 +984,11 @@ void MetroGnomeAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
 
+    //the step edits only keep the properties they changed up to date, a saved state gets all of them, lanes a session never touched included
+    auto state = apvts.copyState();
+    stepPatterns.writeTo(state);
     juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
+    state.writeToStream(mos);
 
 }
 void MetroGnomeAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
@@ -155,13 +996,26 @@ void MetroGnomeAudioProcessor::setStateInformation(const void* data, int sizeInB
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
 
-    /*
-    auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if (tree.isValid()) {
-        apvts.replaceState(tree);
+    restoreState(juce::ValueTree::readFromData(data, (size_t)sizeInBytes));
+}
+
+void MetroGnomeAudioProcessor::restoreState(const juce::ValueTree& tree)
+{
+    //the steps, lanes, grooves, tuplets and song sections aren't params, so replacing the state alone wouldn't bring them back
+    if (!tree.isValid() || !tree.hasType(apvts.state.getType()))
+    {
+        return;
+    }
+    apvts.replaceState(tree);
+    stepPatterns.loadFromState();
+    songStore.loadFromState();
+    //a state without a folder plays the built in clicks, the same kit isn't built again
+    const auto path = apvts.state.getProperty(kitFolderId).toString();
+    const auto folder = path.isNotEmpty() ? juce::File(path) : juce::File();
+    if (folder != getClickKitFolder())
+    {
+        loadClickKit(folder);
     }
-    */
-    
 }
 
 
@@ -248,13 +1102,18 @@ bool MetroGnomeAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts
     return true;
 #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // The main output can be any layout (mono, stereo or multichannel for monitor rigs),
+    // the click is written to every channel of it.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
+    // The per sound aux outputs are optional, anything up to stereo is fine
+    for (int busIndex = 1; busIndex < layouts.outputBuses.size(); busIndex++)
+    {
+        if (layouts.getChannelSet(false, busIndex).size() > 2)
+            return false;
+    }
+
     // This checks if the input layout matches the output layout
 #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
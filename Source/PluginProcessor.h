@@ -9,15 +9,31 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "Metronome.h"
-#include "PolyRhythmMetronome.h"
 #include "Utilities.h"
+#include "RhythmConfig.h"
+#include "RhythmEngine.h"
+#include "StepPattern.h"
+#include "TempoFollower.h"
+#include "TimingAnalyzer.h"
+#include "OutputDelay.h"
+#include "SongTimeline.h"
+#include "LoopCache.h"
+#include "Trace.h"
+#include "Diagnostics.h"
+#include "PhaseClock.h"
 
+//which path each processBlock took, for StressHarness, off unless METROGNOME_BLOCK_PATHS=1 is added to the exporter's
+//preprocessor definitions (MetroGnomeTests has it), the plugin's blocks then don't do the bookkeeping at all
+#ifndef METROGNOME_BLOCK_PATHS
+ #define METROGNOME_BLOCK_PATHS 0
+#endif
 
 //==============================================================================
 /**
 */
-class MetroGnomeAudioProcessor  : public juce::AudioProcessor
+class MetroGnomeAudioProcessor  : public juce::AudioProcessor,
+                                  public juce::AudioProcessorValueTreeState::Listener,
+                                  private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -33,6 +49,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -65,11 +83,189 @@ public:
  
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Parameters", createParameterLayout() };
-    Metronome metronome{ &apvts };
-    PolyRhythmMetronome polyRhythmMetronome{ &apvts };
+    RhythmConfigExchange rhythmConfigs;
+    EngineDisplayState displayState;
+    StepPatternStore stepPatterns{ apvts };
+    ScheduledClickQueue scheduledClicks;
+    TimingAnalyzer timingAnalyzer{ scheduledClicks };
+    SongStore songStore{ apvts };
+    DiagnosticCounters diagnostics;
+
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void requestReset() { resetRequested.store(true); } //safe to call from any thread, the engines are reset at the start of the next block
+    //what a processBlock call ended up doing, for finding out which path a slow block took
+    enum BlockPath : juce::uint32
+    {
+        engineSwapped = 1 << 0, //a new engine from a MODE change went in
+        songSwapped = 1 << 1,
+        patternsAcquired = 1 << 2, //step edits were picked up
+        resetHandled = 1 << 3, //requestReset
+        engineRestarted = 1 << 4, //restartActiveEngine, by a reset, a host tempo or transport change, the follower or the song stopping
+        hostConnected = 1 << 5,
+        followingTempo = 1 << 6,
+        renderedSong = 1 << 7,
+        renderedLoopCache = 1 << 8,
+        renderedEngine = 1 << 9,
+        analyzing = 1 << 10,
+        followingLeader = 1 << 11, //LOCAL_SYNC
+        leading = 1 << 12
+    };
+    //audio thread, BlockPath flags of the last block, always 0 when METROGNOME_BLOCK_PATHS is off
+#if METROGNOME_BLOCK_PATHS
+    juce::uint32 getLastBlockPath() const { return blockPath; }
+#else
+    juce::uint32 getLastBlockPath() const { return 0; }
+#endif
+
+    //does the message thread's share of a param change (new engine, pending config, lookahead) straight away,
+    //for drivers like HostSimulator that call processBlock without a message loop running
+    void runMessageThreadUpdates() { handleUpdateNowIfNeeded(); }
+
+    //message thread, swaps in a saved session or preset, then reloads the patterns and the song kept in the state with it
+    void restoreState(const juce::ValueTree& tree);
+
+    //message thread, plays the kit in folder (see ClickKitLoader) once it's been built in the background, a folder without sounds goes back to the built in clicks
+    void loadClickKit(const juce::File& folder);
+    //any thread, the folder of the last loadClickKit, juce::File() for the built in clicks
+    juce::File getClickKitFolder() const;
 
 
 private:
+    void handleAsyncUpdate() override;
+
+    //both processBlock overloads, the host's precision goes all the way down to the click voices
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+
+    void restartActiveEngine();
+    void markBlockPath(juce::uint32 flag) noexcept
+    {
+#if METROGNOME_BLOCK_PATHS
+        blockPath |= flag;
+#else
+        juce::ignoreUnused(flag);
+#endif
+    }
+    void swapInPendingEngine();
+    void swapInPendingKit();
+    void useActiveKit();
+    void freeRetiredKits();
+    std::unique_ptr<CompiledSong> compileSong();
+    void swapInPendingSong();
+    void enterSongSection(int index);
+    void stopPlayingSong();
+    template <typename SampleType>
+    void renderSong(OutputRouting<SampleType>& routing, juce::MidiBuffer& midiMessages, juce::int64 position, int clickDelay, bool isAnalyzing);
+    LoopKey makeLoopKey(int clickDelay, int numChannels, bool isDouble);
+    void followInputTempo();
+    void stopFollowingInput();
+    void followLeader(juce::int64 blockTicks, int numSamples);
+    void stopFollowingLeader();
+    void updateLookahead();
+    void updateDiagnostics(int numSamples, const juce::Optional<juce::AudioPlayHead::PositionInfo>& positionInfo, const juce::MidiBuffer& midiMessages);
+
+    std::atomic<bool> resetRequested{ false };
+
+    //audio thread state that holds the host's sample type, one set per precision, only the host's is used
+    template <typename SampleType>
+    struct PrecisionState
+    {
+        OutputRouting<SampleType> outputRouting; //rebuilt from the bus layout every block
+        AudioDelayLine<SampleType> inputDelay;
+    };
+    PrecisionState<float> floatState;
+    PrecisionState<double> doubleState;
+
+    template <typename SampleType>
+    PrecisionState<SampleType>& getPrecisionState()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+        {
+            return doubleState;
+        }
+        else
+        {
+            return floatState;
+        }
+    }
+
+    //tempo follow, the beat grid tracked from the input drives the engines through the same params as a playing host
+    TempoFollower tempoFollower; //audio thread
+    bool isAnalysingInput = false; //audio thread, FOLLOW is on and the host isn't playing
+    bool isFollowingInput = false; //audio thread, true while the follower owns DAW_PLAYING and DAW_SAMPLES_ELAPSED
+
+    //LOCAL_SYNC, the leader publishes where its engine is every block, a follower drives its engines from that the way a playing host would
+    PhaseClock phaseClock; //mapped by the message thread the first time LOCAL_SYNC is turned on
+    double engineBeats = 0; //audio thread, where the live engine is in the rhythm at the start of the next block, in beats
+    PhaseClock::Frame leaderFrame; //audio thread, the last one read
+    double leaderBeats = 0; //audio thread, where the leader is at the start of the next block, in beats
+    bool isFollowingLeader = false; //audio thread, true while the leader owns DAW_PLAYING and DAW_SAMPLES_ELAPSED
+
+    //output offsets, AUDIO_OFFSET_MS and MIDI_OFFSET_MS can be negative, the engines then run lookaheadSamples ahead of what they output
+    //and the same amount is reported to the host as latency, every output (and the input passthrough) is held back by lookaheadSamples plus its own offset
+    static constexpr float maxOutputOffsetMs = 100.0f;
+    std::atomic<int> lookaheadSamples{ 0 }; //written by the message thread
+    MidiDelay midiDelay; //audio thread
+
+    //audio thread, for spotting late callbacks and host time jumps
+    double lastCallbackMs = 0;
+    double lastBlockMs = 0; //length of the block lastCallbackMs was taken at
+    juce::int64 expectedHostTime = -1;
+
+#if METROGNOME_BLOCK_PATHS
+    juce::uint32 blockPath = 0; //audio thread, BlockPath flags of the block being processed
+#endif
+    juce::int64 processedSamples = 0; //audio thread, samples since prepareToPlay, the clock the timing analysis matches hits to clicks with
+
+    //only the engine for the current MODE exists, a new one is built and prepared on the message thread
+    //and handed to the audio thread through pendingEngine, the old one comes back through retiredEngine to be deleted
+    std::unique_ptr<RhythmEngine> activeEngine; //audio thread
+    std::atomic<RhythmEngine*> pendingEngine{ nullptr };
+    std::atomic<RhythmEngine*> retiredEngine{ nullptr };
+    std::atomic<bool> isEngineOutdated{ false }; //the audio thread turned down a pending engine prepared for another sample rate, the message thread builds it again
+    int engineMode = 0; //message thread, MODE of the last engine that was built
+
+    //LOOP_CACHE, a cycle of the active engine's output rendered ahead on a worker thread
+    LoopCache loopCache{ apvts, rhythmConfigs, stepPatterns.getExchange(), displayState, scheduledClicks };
+    juce::uint32 stepPatternsSerial = 0; //audio thread, step patterns picked up so far, part of the loop's key
+
+    //click kits, the active one is what every engine's voices play, a new one is built by the kitLoader and handed over through pendingKit
+    //the old one comes back through retiredKit and waits in retiredKits until nothing holds its samples any more
+    juce::SharedResourcePointer<ClickSampleCache> sampleCache;
+    std::unique_ptr<ClickKit> activeKit; //audio thread
+    std::atomic<ClickKit*> pendingKit{ nullptr };
+    std::atomic<ClickKit*> retiredKit{ nullptr };
+    std::vector<std::unique_ptr<ClickKit>> retiredKits;
+    juce::CriticalSection retiredKitsLock; //prepareToPlay retires a kit too, and not every host calls it on the message thread
+    juce::uint32 kitSerial = 0; //audio thread, kits swapped in so far, part of the loop's key
+    //written by the message thread, read by prepareToPlay, which not every host calls on the message thread
+    juce::File kitFolder;
+    juce::CriticalSection kitFolderLock;
+    static constexpr const char* kitFolderId = "CLICK_KIT_FOLDER"; //state property with the folder's full path
+    ClickKitLoader kitLoader{ *sampleCache };
+
+    //song mode, the compiled song comes and goes the same way as an engine and plays instead of activeEngine while SONG is on
+    std::unique_ptr<CompiledSong> activeSong; //audio thread
+    std::atomic<CompiledSong*> pendingSong{ nullptr };
+    std::atomic<CompiledSong*> retiredSong{ nullptr };
+    std::atomic<bool> isSongOutdated{ false }; //set by every SongStore and StepPatternStore edit, the message thread compiles the song again
+    //audio thread
+    bool isPlayingSong = false;
+    int songSection = -1; //section the song engines are set up for, -1 makes the next block look it up
+    juce::int64 songPosition = 0; //where the song is when the host isn't playing it
+    juce::int64 expectedSongPosition = -1; //where the next block starts unless the host seeks, loops or jumps
+    juce::MidiBuffer sectionMidi; //MIDI of one section's part of the block, moved into the block's own buffer afterwards
+    //written by prepareToPlay, which not every host calls on the message thread, and read by the message thread's updates and the audio thread
+    std::atomic<double> preparedSampleRate{ 0 };
+    std::atomic<int> preparedBlockSize{ 0 };
+    std::atomic<bool> isPreparedDouble{ false }; //kits for a double precision host carry their samples' double copies
+
+    juce::SharedResourcePointer<RealtimeLogWriter> logWriter; //one per process, writes everything RealtimeLog::write was given to a file
+
+#if METROGNOME_TRACING
+    juce::SharedResourcePointer<TraceWriter> traceWriter; //one per process, drains every thread's markers to a file
+#endif
+
     juce::AudioPlayHead *playHead;
     juce::PluginHostType pluginHostType;
     juce::PluginHostType::HostType pluginHostType2;
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    PolyMeterMetronome.cpp
+    Created: 19 Oct 2026 2:25:48pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PolyMeterMetronome.h"
+#include <numeric>
+
+const int RHYTHM_1_MIDI_VALUE = 36;
+const int RHYTHM_2_MIDI_VALUE = 37;
+
+
+PolyMeterMetronome::PolyMeterMetronome(juce::AudioProcessorValueTreeState* _apvts, RhythmConfigExchange* _rhythmConfigs, StepPatternExchange* _stepPatterns, EngineDisplayState* _displayState, ScheduledClickQueue* _scheduledClicks)
+    : RhythmEngine(_apvts, _rhythmConfigs, _stepPatterns, _displayState, _scheduledClicks)
+{
+    useRenderLoopsOf<PolyMeterMetronome>();
+    resetAll();
+}
+
+
+void PolyMeterMetronome::prepareToPlay(double _sampleRate, int samplesPerBlock)
+{
+    //params are read by resetParams once the engine is running on the audio thread
+    if (sampleRate != _sampleRate)
+    {
+        sampleRate = _sampleRate;
+        //the clicks are decoded once per sample rate and shared by every engine in the process
+        rimShotLow.setSample(sampleCache->getSample(ClickSampleId::rimShotLow, sampleRate));
+        rimShotHigh.setSample(sampleCache->getSample(ClickSampleId::rimShotHigh, sampleRate));
+        rimShotSub.setSample(sampleCache->getSample(ClickSampleId::rimShotSub, sampleRate));
+    }
+}
+
+
+void PolyMeterMetronome::processEvents(int bufferSize, juce::MidiBuffer& midiBuffer)
+{
+    bool isDawPlaying = apvts->getRawParameterValue("DAW_PLAYING")->load();
+
+    auto quantization = (ConfigQuantization)(int)apvts->getRawParameterValue("QUANTIZE")->load();
+    if (quantization == ConfigQuantization::immediate)
+    {
+        rhythmConfigs->acquire();
+    }
+    resetParams();
+
+    if (isDawPlaying)
+    {   //follow the host's position instead of our own count
+        int samplesElapsed = (int)apvts->getRawParameterValue("DAW_SAMPLES_ELAPSED")->load();
+        int beatsElapsed = samplesElapsed / beatInterval;
+        int samplesIntoBeat = samplesElapsed % beatInterval;
+        if (samplesIntoBeat != 0)
+        {
+            beatsElapsed += 1;
+        }
+        samplesToNextBeat = samplesIntoBeat == 0 ? 0 : beatInterval - samplesIntoBeat;
+        rhythm1Counter = beatsElapsed % rhythm1Value;
+        rhythm2Counter = beatsElapsed % rhythm2Value;
+        barCounter = (juce::uint32)(beatsElapsed / rhythm1Value);
+    }
+
+    while (samplesToNextBeat < bufferSize)
+    {
+        //rhythm1's cycle counts as the bar for quantization
+        bool isFirstBeat = rhythm1Counter == 0;
+        if (rhythmConfigs->hasPending() && (quantization == ConfigQuantization::nextBeat || (quantization == ConfigQuantization::nextBar && isFirstBeat)))
+        {   //this beat is the quantized boundary, the pending config takes over from here
+            rhythmConfigs->acquire();
+            resetParams();
+        }
+
+        playBeat(samplesToNextBeat, midiBuffer);
+        rhythm1Counter = (rhythm1Counter + 1) % rhythm1Value;
+        if (rhythm1Counter == 0)
+        {
+            barCounter += 1;
+        }
+        rhythm2Counter = (rhythm2Counter + 1) % rhythm2Value;
+        samplesToNextBeat += beatInterval;
+    }
+    samplesToNextBeat -= bufferSize;
+
+    //the editor shows the step that played last
+    displayState->counter1.store((rhythm1Counter + rhythm1Value - 1) % rhythm1Value, std::memory_order_relaxed);
+    displayState->counter2.store((rhythm2Counter + rhythm2Value - 1) % rhythm2Value, std::memory_order_relaxed);
+}
+
+void PolyMeterMetronome::playBeat(int timeToStartPlaying, juce::MidiBuffer& midiBuffer)
+{
+    //a rhythm with a value of 1 is turned off, same as in polyrhythm mode
+    float level1 = rhythm1Value > 1 ? getStepLevel(0, rhythm1Counter, rhythm1Value, barCounter) : 0.0f;
+    float level2 = rhythm2Value > 1 ? getStepLevel(1, rhythm2Counter, rhythm2Value, barCounter) : 0.0f;
+
+    if (level1 > 0)
+    {
+        //rhythm1 accents the start of its cycle
+        if (rhythm1Counter == 0)
+        {
+            playClick(rimShotHigh, timeToStartPlaying, level1);
+        }
+        else
+        {
+            playClick(rimShotLow, timeToStartPlaying, level1);
+        }
+        reportClick(timeToStartPlaying, 0, rhythm1Counter);
+        handleNoteTrigger(midiBuffer, RHYTHM_1_MIDI_VALUE, timeToStartPlaying, level1);
+    }
+    if (level2 > 0)
+    {
+        playClick(rimShotSub, timeToStartPlaying, level2);
+        reportClick(timeToStartPlaying, 1, rhythm2Counter);
+        handleNoteTrigger(midiBuffer, RHYTHM_2_MIDI_VALUE, timeToStartPlaying, level2);
+    }
+}
+
+void PolyMeterMetronome::handleNoteTrigger(juce::MidiBuffer& midiBuffer, int noteNumber, int samplePosition, float level)
+{
+    TRACE_SCOPE("MIDI note");
+    //the step's velocity lane sets the MIDI velocity as well as the click gain
+    auto message = juce::MidiMessage::noteOn(1, noteNumber, (juce::uint8)juce::jlimit(1, 127, juce::roundToInt(level * 127.0f)));
+    auto messageOff = juce::MidiMessage::noteOff(message.getChannel(), message.getNoteNumber());
+
+    if (!midiBuffer.addEvent(message, samplePosition) || !midiBuffer.addEvent(messageOff, samplePosition + 100))
+    {
+        RealtimeLog::write(LogMessage::midiNoteDropped, noteNumber, samplePosition, midiBuffer.getNumEvents());
+        droppedMidiEvents++;
+    }
+}
+
+void PolyMeterMetronome::resetAll()
+{   //this should be called whenever the metronome is stopped
+    samplesToNextBeat = 0;
+    barCounter = 0;
+    rhythm1Counter = 0;
+    rhythm2Counter = 0;
+}
+
+void PolyMeterMetronome::resetParams()
+{   //rhythm values come from the active config, they only change when the audio thread swaps a pending config in
+    //unlike polyrhythm mode a new value doesn't restart the cycles, each rhythm just wraps to its new length
+    const auto& config = rhythmConfigs->getActive();
+    rhythm1Value = config.numerator;
+    rhythm2Value = config.subdivisions;
+    rhythm1Counter %= rhythm1Value;
+    rhythm2Counter %= rhythm2Value;
+    displayState->length1.store(rhythm1Value, std::memory_order_relaxed);
+    displayState->length2.store(rhythm2Value, std::memory_order_relaxed);
+
+    bpm = apvts->getRawParameterValue("BPM")->load();
+    const int previousBeatInterval = beatInterval;
+    beatInterval = juce::jmax(1, (int)((60.0 / bpm) * sampleRate));
+    if (beatInterval != previousBeatInterval)
+    {
+        //a new tempo keeps the own clock at the same point of the beat, same as the other engines
+        samplesToNextBeat = (int)((juce::int64)samplesToNextBeat * beatInterval / previousBeatInterval);
+    }
+}
+
+juce::int64 PolyMeterMetronome::getCycleLength() const
+{
+    //both rhythms start together again after the least common multiple of their beats
+    return (juce::int64)std::lcm(rhythm1Value, rhythm2Value) * beatInterval;
+}
+
+void PolyMeterMetronome::copyStateFrom(const RhythmEngine& other)
+{
+    const auto& source = static_cast<const PolyMeterMetronome&>(other);
+    copyBaseStateFrom(source);
+    rhythm1Value = source.rhythm1Value;
+    rhythm2Value = source.rhythm2Value;
+    bpm = source.bpm;
+    sampleRate = source.sampleRate;
+    beatInterval = source.beatInterval;
+    samplesToNextBeat = source.samplesToNextBeat;
+    rhythm1Counter = source.rhythm1Counter;
+    rhythm2Counter = source.rhythm2Counter;
+    barCounter = source.barCounter;
+    rimShotHigh = source.rimShotHigh;
+    rimShotLow = source.rimShotLow;
+    rimShotSub = source.rimShotSub;
+}
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    PolyMeterMetronome.h
+    Created: 19 Oct 2026 2:25:48pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RhythmEngine.h"
+#include "ClickSampleCache.h"
+
+//==============================================================================
+/*
+    Polymeter mode engine
+    both rhythms click on the same beat, but rhythm1 cycles every NUMERATOR beats and rhythm2 every SUBDIVISION beats,
+    so their first beats only line up again after lcm(NUMERATOR, SUBDIVISION) beats
+*/
+class PolyMeterMetronome final : public RhythmEngine
+{
+public:
+    PolyMeterMetronome(juce::AudioProcessorValueTreeState* _apvts, RhythmConfigExchange* _rhythmConfigs, StepPatternExchange* _stepPatterns, EngineDisplayState* _displayState, ScheduledClickQueue* _scheduledClicks);
+
+    void prepareToPlay(double _sampleRate, int samplesPerBlock) override;
+    void resetAll() override;
+    void resetParams() override;
+    int getMode() const override { return 2; }
+    double getSampleRate() const override { return sampleRate; }
+    juce::int64 getCycleLength() const override;
+    double getSamplesPerBeat() const override { return (double)beatInterval; }
+    void copyStateFrom(const RhythmEngine& other) override;
+    int getNumActiveVoices() const override { return (int)rimShotHigh.isActive() + (int)rimShotLow.isActive() + (int)rimShotSub.isActive(); }
+    void useKit(const ClickKit& kit) override
+    {
+        rimShotHigh.switchSample(kit.getSample(ClickSampleId::rimShotHigh));
+        rimShotLow.switchSample(kit.getSample(ClickSampleId::rimShotLow));
+        rimShotSub.switchSample(kit.getSample(ClickSampleId::rimShotSub));
+    }
+
+    template <int NumChannels, typename SampleType>
+    void renderBlock(OutputRouting<SampleType>& routing, juce::MidiBuffer& midiBuffer)
+    {
+        processEvents(routing.main.getNumSamples(), midiBuffer);
+        //clicks that were triggered this block or are still ringing from earlier ones
+        routing.renderVoice<NumChannels>(rimShotHigh, ClickSampleId::rimShotHigh);
+        routing.renderVoice<NumChannels>(rimShotLow, ClickSampleId::rimShotLow);
+        routing.renderVoice<NumChannels>(rimShotSub, ClickSampleId::rimShotSub);
+    }
+
+private:
+    void processEvents(int bufferSize, juce::MidiBuffer& midiBuffer);
+    void playBeat(int timeToStartPlaying, juce::MidiBuffer& midiBuffer);
+    void handleNoteTrigger(juce::MidiBuffer&, int noteNumber, int samplePosition, float level);
+
+    int rhythm1Value = 4; //represented as NUMERATOR in apvts, beats in rhythm1's cycle
+    int rhythm2Value = 1; //represented as SUBDIVISION in apvts, beats in rhythm2's cycle
+    double bpm = 60;
+    double sampleRate = 0; //sampleRate from app, usually 44100
+
+    //beat logic variables
+    int beatInterval = 1; //interval representing one beat click = (60.0 / bpm) * sampleRate
+    int samplesToNextBeat = 0; //offset of the next beat from the start of the next block
+    int rhythm1Counter = 0; //step of rhythm1 that plays on the next beat
+    int rhythm2Counter = 0; //step of rhythm2 that plays on the next beat
+    juce::uint32 barCounter = 0; //rhythm1 cycles played since start, seeds the probability rolls
+
+    //click playback, the decoded samples live in the process wide cache
+    juce::SharedResourcePointer<ClickSampleCache> sampleCache;
+    ClickVoice rimShotHigh;
+    ClickVoice rimShotLow;
+    ClickVoice rimShotSub;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyMeterMetronome)
+};
@@ -16,36 +16,11 @@ const int RHYTHM_2_MIDI_VALUE = 37;
 
 
 //==============================================================================
-PolyRhythmMetronome::PolyRhythmMetronome()
+PolyRhythmMetronome::PolyRhythmMetronome(juce::AudioProcessorValueTreeState* _apvts, RhythmConfigExchange* _rhythmConfigs, StepPatternExchange* _stepPatterns, EngineDisplayState* _displayState, ScheduledClickQueue* _scheduledClicks)
+    : RhythmEngine(_apvts, _rhythmConfigs, _stepPatterns, _displayState, _scheduledClicks)
 {
-    // In your constructor, you should add any child components, and
-    // initialise any special settings that your component needs.
-
-}
-
-
-
-PolyRhythmMetronome::PolyRhythmMetronome(juce::AudioProcessorValueTreeState* _apvts)
-{
-    apvts = _apvts;
+    useRenderLoopsOf<PolyRhythmMetronome>();
     resetAll();
-    formatManager.registerBasicFormats();
-   
-    juce::MemoryInputStream* inputStream = new juce::MemoryInputStream(BinaryData::rimshot_low_wav, BinaryData::rimshot_low_wavSize, false);
-    juce::WavAudioFormat wavFormat;
-    juce::AudioFormatReader* formatReader = wavFormat.createReaderFor(inputStream, false);
-    rimShotLow.reset(new juce::AudioFormatReaderSource(formatReader, true));
-
-    juce::MemoryInputStream* inputStream2 = new juce::MemoryInputStream(BinaryData::rimshot_high_wav, BinaryData::rimshot_high_wavSize, false);
-    juce::WavAudioFormat wavFormat2;
-    juce::AudioFormatReader* formatReader2 = wavFormat2.createReaderFor(inputStream2, false);
-    rimShotHigh.reset(new juce::AudioFormatReaderSource(formatReader2, true));
-
-    juce::MemoryInputStream* inputStream3 = new juce::MemoryInputStream(BinaryData::rimshot_sub_wav, BinaryData::rimshot_sub_wavSize, false);
-    juce::WavAudioFormat wavFormat3;
-    juce::AudioFormatReader* formatReader3 = wavFormat3.createReaderFor(inputStream3, false);
-    rimShotSub.reset(new juce::AudioFormatReaderSource(formatReader3, true));
-    
 }
 
 PolyRhythmMetronome::~PolyRhythmMetronome()
@@ -56,211 +31,245 @@ PolyRhythmMetronome::~PolyRhythmMetronome()
 void PolyRhythmMetronome::prepareToPlay(double _sampleRate, int samplesPerBlock)
 {
     //preparetoplay should call every time we start (right before)
-
-    resetParams();
+    //params are read by resetParams once the engine is running on the audio thread
 
     if (sampleRate != _sampleRate)
     {
         //if the audioprocessors samplerate hasn't changed, nothing else needs to be done
         sampleRate = _sampleRate;
-        if (rimShotLow != nullptr)
-        {
-            rimShotLow->prepareToPlay(samplesPerBlock, sampleRate);
-        }
-        if (rimShotHigh != nullptr)
-        {
-            rimShotHigh->prepareToPlay(samplesPerBlock, sampleRate);
-        }
-        if (rimShotSub != nullptr)
-        {
-            rimShotSub->prepareToPlay(samplesPerBlock, sampleRate);
-        }
+        //the clicks are decoded once per sample rate and shared by every engine in the process
+        rimShotLow.setSample(sampleCache->getSample(ClickSampleId::rimShotLow, sampleRate));
+        rimShotHigh.setSample(sampleCache->getSample(ClickSampleId::rimShotHigh, sampleRate));
+        rimShotSub.setSample(sampleCache->getSample(ClickSampleId::rimShotSub, sampleRate));
     }
 
 }
-void PolyRhythmMetronome::getNextAudioBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiBuffer)
+void PolyRhythmMetronome::processEvents(int bufferSize, juce::MidiBuffer& midiBuffer)
 {   
-
-    bool isDawConnected = apvts->getRawParameterValue("DAW_CONNECTED")->load();
     bool isDawPlaying = apvts->getRawParameterValue("DAW_PLAYING")->load();
 
-    resetParams();
-    auto audioSourceChannelInfo = juce::AudioSourceChannelInfo(buffer);
-    auto bufferSize = buffer.getNumSamples(); //usually 16, 32, 64... 1024...
-    if (!isDawConnected && !isDawPlaying) {
-        totalSamples += bufferSize;
-    }
-    else {
-        totalSamples = ((int)apvts->getRawParameterValue("DAW_SAMPLES_ELAPSED")->load() % (int)samplesPerBar) + (int)bufferSize;
-    }
-
-    rhythm1SamplesProcessed = totalSamples % rhythm1Interval;
-    rhythm2SamplesProcessed = totalSamples % rhythm2Interval;
-
-
-    bool rhythm1Flag = (rhythm1SamplesProcessed + bufferSize >= rhythm1Interval && rhythm1Value > 1);
-    bool rhythm2Flag = (rhythm2SamplesProcessed + bufferSize >= rhythm2Interval && rhythm2Value > 1);
-   
-
-    if (rhythm1Counter >= rhythm1Value )
+    auto quantization = (ConfigQuantization)(int)apvts->getRawParameterValue("QUANTIZE")->load();
+    if (quantization == ConfigQuantization::immediate)
     {
-        rhythm1Counter = 0;
+        rhythmConfigs->acquire();
     }
-    if (rhythm2Counter >= rhythm2Value )
+    resetParams();
+
+    juce::int64 barPosition = totalSamples;
+    if (isDawPlaying)
     {
-        rhythm2Counter = 0;
+        //the host (or a song section, or the leader) places the block, both rhythms only depend on where it is in the bar
+        int samplesElapsed = (int)apvts->getRawParameterValue("DAW_SAMPLES_ELAPSED")->load();
+        barPosition = samplesElapsed % (int)samplesPerBar;
+        barCounter = (juce::uint32)(samplesElapsed / (int)samplesPerBar);
     }
 
-
-
-    //TODO make this block cleaner
-    if ( ((rhythm1Flag && rhythm2Flag )) )
-    { // both beats hit at the same time , play a unique tick for that 
-
-        const auto timeToStartPlaying = rhythm1Interval - rhythm1SamplesProcessed;
-        rhythm1Counter += 1;
-        rhythm2Counter += 1;
-        int ID1 = rhythm1Counter;
-        int ID2 = rhythm2Counter;
-        if (rhythm1Counter == rhythm1Value){
-            ID1 = 0;
-        }
-        if (rhythm2Counter == rhythm2Value) {
-            ID2 = 0;
+    //every step of either rhythm starting in the block plays at its own sample, however the host cuts the blocks,
+    //step s is at s * interval from the start of the bar, a rhythm of value 1 is off and only ever reaches the end of the bar
+    int blockOffset = 0; //sample of the block barPosition is at
+    while (true)
+    {
+        int step1, step2;
+        const juce::int64 hit1 = getNextStep(barPosition, rhythm1Value, rhythm1Interval, step1);
+        const juce::int64 hit2 = getNextStep(barPosition, rhythm2Value, rhythm2Interval, step2);
+        const juce::int64 hit = juce::jmin(hit1, hit2);
+        if (hit - barPosition >= bufferSize - blockOffset)
+        {
+            barPosition += bufferSize - blockOffset;
+            break;
         }
+        blockOffset += (int)(hit - barPosition);
+        barPosition = hit;
 
-
-        if (apvts->getRawParameterValue("RHYTHM1." + to_string(ID1) + "_TOGGLE")->load() == true && apvts->getRawParameterValue("RHYTHM2." + to_string(ID2) + "_TOGGLE")->load() == true) {
-            handleNoteTrigger(midiBuffer, RHYTHM_1_MIDI_VALUE);
-            handleNoteTrigger(midiBuffer, RHYTHM_2_MIDI_VALUE);
-            rimShotHigh->setNextReadPosition(0); //reset sample to beginning
-            for (auto samplenum = 0; samplenum < bufferSize + 1; samplenum++)
-            {
-                if (samplenum == timeToStartPlaying)
-                {
-                    rimShotHigh->getNextAudioBlock(audioSourceChannelInfo);
-
-                }
+        if (hit == (juce::int64)samplesPerBar)
+        {
+            //the bar is over, the next one starts here
+            barPosition = 0;
+            barCounter += 1;
+            if (quantization == ConfigQuantization::nextBar && rhythmConfigs->hasPending())
+            {   //this bar is the quantized boundary, the pending config takes over from here
+                swapInPendingConfig();
             }
-
+            continue;
+        }
+        if (hit1 == hit && quantization == ConfigQuantization::nextBeat && rhythmConfigs->hasPending())
+        {   //rhythm1's step is the quantized boundary, the steps from here are the new rhythms'
+            swapInPendingConfig();
+            continue;
         }
-        else if (apvts->getRawParameterValue("RHYTHM1." + to_string(ID1) + "_TOGGLE")->load() == true) {
-
-            handleNoteTrigger(midiBuffer, RHYTHM_1_MIDI_VALUE);
-            rimShotLow->setNextReadPosition(0); //reset sample to beginning
-            for (auto samplenum = 0; samplenum < bufferSize + 1; samplenum++)
-            {
-                if (samplenum == timeToStartPlaying)
-                {
-                    rimShotLow->getNextAudioBlock(audioSourceChannelInfo);
 
-                }
-            }
+        playSteps(hit1 == hit ? step1 : -1, hit2 == hit ? step2 : -1, blockOffset, midiBuffer);
+        barPosition += 1;
+        blockOffset += 1;
+    }
 
-        }
-        else if (apvts->getRawParameterValue("RHYTHM2." + to_string(ID2) + "_TOGGLE")->load() == true) {
+    if (!isDawPlaying)
+    {
+        totalSamples = (int)barPosition;
+    }
 
-            handleNoteTrigger(midiBuffer, RHYTHM_2_MIDI_VALUE);
-            rimShotSub->setNextReadPosition(0); //reset sample to beginning
-            for (auto samplenum = 0; samplenum < bufferSize + 1; samplenum++)
-            { 
-                if (samplenum == timeToStartPlaying)
-                {
-                    rimShotSub->getNextAudioBlock(audioSourceChannelInfo);
+    displayState->counter1.store(rhythm1Counter, std::memory_order_relaxed);
+    displayState->counter2.store(rhythm2Counter, std::memory_order_relaxed);
+}
 
-                }
-            }
-        }
+juce::int64 PolyRhythmMetronome::getNextStep(juce::int64 barPosition, int value, int interval, int& step) const
+{
+    //the first step at or after barPosition, or the end of the bar once the rhythm has played all of its steps
+    step = (int)((barPosition + interval - 1) / interval);
+    return value > 1 && step < value ? (juce::int64)step * interval : (juce::int64)samplesPerBar;
+}
 
+void PolyRhythmMetronome::playSteps(int step1, int step2, int timeToStartPlaying, juce::MidiBuffer& midiBuffer)
+{
+    //each rhythm's own grid position plus its groove, -1 for a rhythm that has no step here
+    const auto timeToStartPlaying1 = timeToStartPlaying + (step1 >= 0 ? getGrooveOffset(0, step1) : 0);
+    const auto timeToStartPlaying2 = timeToStartPlaying + (step2 >= 0 ? getGrooveOffset(1, step2) : 0);
+    float level1 = 0;
+    float level2 = 0;
+    if (step1 >= 0)
+    {
+        rhythm1Counter = step1;
+        level1 = getStepLevel(0, step1, rhythm1Value, barCounter);
     }
-    else if (rhythm1Flag)
+    if (step2 >= 0)
     {
-        rhythm1Counter += 1;
-        if (apvts->getRawParameterValue("RHYTHM1." + to_string(rhythm1Counter) + "_TOGGLE")->load() == true) {
-
-            const auto timeToStartPlaying = rhythm1Interval - rhythm1SamplesProcessed;
-            rimShotLow->setNextReadPosition(0); //reset sample to beginning
-            for (auto samplenum = 0; samplenum < bufferSize + 1; samplenum++)
-            {
-                if (samplenum == timeToStartPlaying)
-                {
-                    rimShotLow->getNextAudioBlock(audioSourceChannelInfo);
-                    handleNoteTrigger(midiBuffer, RHYTHM_1_MIDI_VALUE);
-                }
-            }
+        rhythm2Counter = step2;
+        level2 = getStepLevel(1, step2, rhythm2Value, barCounter);
+    }
+
+    if (level1 > 0 && level2 > 0)
+    { // both beats hit at the same time , play a unique tick for that, the shared click follows rhythm1
+        handleNoteTrigger(midiBuffer, RHYTHM_1_MIDI_VALUE, timeToStartPlaying1, level1);
+        handleNoteTrigger(midiBuffer, RHYTHM_2_MIDI_VALUE, timeToStartPlaying2, level2);
+        playClick(rimShotHigh, timeToStartPlaying1, juce::jmax(level1, level2));
+        //with the accent on a bus of its own, the Beat and Subdivision outputs still get every hit of their rhythm
+        if (isRhythm1ApartFromAccent)
+        {
+            playClick(rimShotLow, timeToStartPlaying1, level1);
+        }
+        if (isRhythm2ApartFromAccent)
+        {
+            playClick(rimShotSub, timeToStartPlaying2, level2);
         }
+        reportClick(timeToStartPlaying1, 0, step1);
+        reportClick(timeToStartPlaying2, 1, step2);
     }
-    else if (rhythm2Flag )
+    else if (level1 > 0)
     {
-        rhythm2Counter += 1;
-        if (apvts->getRawParameterValue("RHYTHM2." + to_string(rhythm2Counter) + "_TOGGLE")->load() == true) {
-
-            const auto timeToStartPlaying = rhythm2Interval - rhythm2SamplesProcessed ;
-            rimShotSub->setNextReadPosition(0); //reset sample to beginning
-            for (auto samplenum = 0; samplenum < bufferSize + 1; samplenum++)
-            { 
-                if (samplenum == timeToStartPlaying)
-                {
-                    rimShotSub->getNextAudioBlock(audioSourceChannelInfo);
-                    handleNoteTrigger(midiBuffer, RHYTHM_2_MIDI_VALUE);
-                }
-            }
-        }
+        handleNoteTrigger(midiBuffer, RHYTHM_1_MIDI_VALUE, timeToStartPlaying1, level1);
+        playClick(rimShotLow, timeToStartPlaying1, level1);
+        reportClick(timeToStartPlaying1, 0, step1);
     }
-
-    if (totalSamples >= samplesPerBar && !isDawPlaying) {
-        totalSamples = totalSamples - samplesPerBar;
+    else if (level2 > 0)
+    {
+        handleNoteTrigger(midiBuffer, RHYTHM_2_MIDI_VALUE, timeToStartPlaying2, level2);
+        playClick(rimShotSub, timeToStartPlaying2, level2);
+        reportClick(timeToStartPlaying2, 1, step2);
     }
-
 }
 
-void PolyRhythmMetronome::handleNoteTrigger(juce::MidiBuffer& midiBuffer, int noteNumber)
+void PolyRhythmMetronome::handleNoteTrigger(juce::MidiBuffer& midiBuffer, int noteNumber, int samplePosition, float level)
 {
+    TRACE_SCOPE("MIDI note");
     auto noteDuration = sampleRate;
-    auto message = juce::MidiMessage::noteOn(1, noteNumber, (juce::uint8)100);
+    //the step's velocity lane sets the MIDI velocity as well as the click gain
+    auto message = juce::MidiMessage::noteOn(1, noteNumber, (juce::uint8)juce::jlimit(1, 127, juce::roundToInt(level * 127.0f)));
     //message.setTimeStamp(noteDuration);
 
     auto messageOff = juce::MidiMessage::noteOff(message.getChannel(), message.getNoteNumber());
     //messageOff.setTimeStamp((noteDuration));
 
-    if (! midiBuffer.addEvent(message, 0)  || ! midiBuffer.addEvent(messageOff, 100) )
+    //notes go at the click's own sample, the processor carries any that land past this block into the next ones
+    if (! midiBuffer.addEvent(message, samplePosition)  || ! midiBuffer.addEvent(messageOff, samplePosition + 100) )
     {
-        DBG("error adding messages to midiBuffer");
+        RealtimeLog::write(LogMessage::midiNoteDropped, noteNumber, samplePosition, midiBuffer.getNumEvents());
+        droppedMidiEvents++;
     }
 }
 void PolyRhythmMetronome::resetAll()
 {   //this should be called whenever the metronome is stopped
    // resetParams();
     totalSamples = 0;
+    barCounter = 0;
     rhythm1Counter = 0;
     rhythm2Counter = 0;
-    rhythm1SamplesProcessed = 0;
-    rhythm2SamplesProcessed = 0;
 }
 
 
 void PolyRhythmMetronome::resetParams()
 {  //this should be called when params change in UI to reflect changes in logic
    //the variables keeping track of time should be reset to reflect the new rhythm
+   //rhythm values come from the active config, they only change when the audio thread swaps a pending config in
 
-    int tempR1Value = apvts->getRawParameterValue("NUMERATOR")->load();
-    if (rhythm1Value != tempR1Value)
+    const auto& config = rhythmConfigs->getActive();
+    if (rhythm1Value != config.numerator)
     {
-        rhythm1Value = tempR1Value;
+        rhythm1Value = config.numerator;
         resetAll();
     }
-    int tempR2Value = apvts->getRawParameterValue("SUBDIVISION")->load();
-    if (rhythm2Value != tempR2Value)
+    if (rhythm2Value != config.subdivisions)
     {
-        rhythm2Value = tempR2Value;
+        rhythm2Value = config.subdivisions;
         resetAll();
     }
 
 
+    displayState->length1.store(rhythm1Value, std::memory_order_relaxed);
+    displayState->length2.store(rhythm2Value, std::memory_order_relaxed);
+
     bpm = apvts->getRawParameterValue("BPM")->load();
-    samplesPerBar = 4 * ((60.0 / bpm) * sampleRate);    //4 * because we have 4 beats in a bar
-    rhythm1Interval = samplesPerBar / rhythm1Value;
-    rhythm2Interval = samplesPerBar / rhythm2Value;
+    //4 * because we have 4 beats in a bar, whole samples so the bar wraps by exactly its length
+    const double previousSamplesPerBar = samplesPerBar;
+    samplesPerBar = juce::jmax(1.0, std::floor(4 * ((60.0 / bpm) * sampleRate)));
+    if (samplesPerBar != previousSamplesPerBar && previousSamplesPerBar > 0)
+    {
+        //a new tempo keeps the own clock at the same point of the bar, a step that was due stays due
+        totalSamples = (int)((juce::int64)totalSamples * (juce::int64)samplesPerBar / (juce::int64)previousSamplesPerBar);
+    }
+    rhythm1Interval = juce::jmax(1, (int)samplesPerBar / rhythm1Value);
+    rhythm2Interval = juce::jmax(1, (int)samplesPerBar / rhythm2Value);
+    //the groove tables also put back what the whole sample intervals round off, so each rhythm divides the bar exactly
+    updateGroove(0, samplesPerBar, rhythm1Value, rhythm1Interval, true);
+    updateGroove(1, samplesPerBar, rhythm2Value, rhythm2Interval, true);
     ///TODO  assumes 4/4 time, a time signature parameter could be interesting
 
 }
+
+void PolyRhythmMetronome::swapInPendingConfig()
+{   //called at a quantized boundary, unlike resetAll the new rhythms pick up from the current position in the bar instead of restarting it,
+    //the steps are worked out from the position so nothing else has to follow
+    if (!rhythmConfigs->acquire())
+    {
+        return;
+    }
+    const auto& config = rhythmConfigs->getActive();
+    rhythm1Value = config.numerator;
+    rhythm2Value = config.subdivisions;
+    resetParams();
+}
+
+juce::int64 PolyRhythmMetronome::getCycleLength() const
+{
+    //both rhythms divide the bar
+    return (juce::int64)samplesPerBar;
+}
+
+void PolyRhythmMetronome::copyStateFrom(const RhythmEngine& other)
+{
+    const auto& source = static_cast<const PolyRhythmMetronome&>(other);
+    copyBaseStateFrom(source);
+    rhythm1Value = source.rhythm1Value;
+    rhythm2Value = source.rhythm2Value;
+    bpm = source.bpm;
+    totalSamples = source.totalSamples;
+    sampleRate = source.sampleRate;
+    samplesPerBar = source.samplesPerBar;
+    barCounter = source.barCounter;
+    rhythm1Interval = source.rhythm1Interval;
+    rhythm1Counter = source.rhythm1Counter;
+    rhythm2Interval = source.rhythm2Interval;
+    rhythm2Counter = source.rhythm2Counter;
+    rimShotHigh = source.rimShotHigh;
+    rimShotLow = source.rimShotLow;
+    rimShotSub = source.rimShotSub;
+}
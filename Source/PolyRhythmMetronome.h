@@ -11,22 +11,49 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "RhythmEngine.h"
+#include "ClickSampleCache.h"
 
 using namespace std;
 //==============================================================================
 /*
+    Polyrhythm mode engine
 */
-class PolyRhythmMetronome  : public juce::Component
+class PolyRhythmMetronome final : public RhythmEngine
 {
 public:
-    PolyRhythmMetronome();
-    PolyRhythmMetronome(juce::AudioProcessorValueTreeState* _apvts);
+    PolyRhythmMetronome(juce::AudioProcessorValueTreeState* _apvts, RhythmConfigExchange* _rhythmConfigs, StepPatternExchange* _stepPatterns, EngineDisplayState* _displayState, ScheduledClickQueue* _scheduledClicks);
     ~PolyRhythmMetronome() override;
 
-    void prepareToPlay(double _sampleRate, int samplesPerBlock);
-    void getNextAudioBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiBuffer);// override; //no override?
-    void resetAll() ;
-    void resetParams();
+    void prepareToPlay(double _sampleRate, int samplesPerBlock) override;
+    void resetAll() override;
+    void resetParams() override;
+    int getMode() const override { return 1; }
+    double getSampleRate() const override { return sampleRate; }
+    juce::int64 getCycleLength() const override;
+    double getSamplesPerBeat() const override { return samplesPerBar / 4; }
+    void copyStateFrom(const RhythmEngine& other) override;
+    int getNumActiveVoices() const override { return (int)rimShotHigh.isActive() + (int)rimShotLow.isActive() + (int)rimShotSub.isActive(); }
+    void useKit(const ClickKit& kit) override
+    {
+        rimShotHigh.switchSample(kit.getSample(ClickSampleId::rimShotHigh));
+        rimShotLow.switchSample(kit.getSample(ClickSampleId::rimShotLow));
+        rimShotSub.switchSample(kit.getSample(ClickSampleId::rimShotSub));
+    }
+
+    template <int NumChannels, typename SampleType>
+    void renderBlock(OutputRouting<SampleType>& routing, juce::MidiBuffer& midiBuffer)
+    {
+        //a rhythm whose click isn't heard where the accent is would lose the hits it shares with the other one
+        isRhythm1ApartFromAccent = routing.hasOwnBus(ClickSampleId::rimShotHigh) || routing.hasOwnBus(ClickSampleId::rimShotLow);
+        isRhythm2ApartFromAccent = routing.hasOwnBus(ClickSampleId::rimShotHigh) || routing.hasOwnBus(ClickSampleId::rimShotSub);
+        processEvents(routing.main.getNumSamples(), midiBuffer);
+        //clicks that were triggered this block or are still ringing from earlier ones
+        routing.renderVoice<NumChannels>(rimShotHigh, ClickSampleId::rimShotHigh);
+        routing.renderVoice<NumChannels>(rimShotLow, ClickSampleId::rimShotLow);
+        routing.renderVoice<NumChannels>(rimShotSub, ClickSampleId::rimShotSub);
+    }
+
     int getRhythm1Counter() { return rhythm1Counter; }
     int getRhythm2Counter() { return rhythm2Counter; }
     int getTotalSamples() { return totalSamples; }
@@ -37,7 +64,11 @@ public:
 
 private:
 
-    void PolyRhythmMetronome::handleNoteTrigger(juce::MidiBuffer&, int noteNumber);
+    void processEvents(int bufferSize, juce::MidiBuffer& midiBuffer);
+    juce::int64 getNextStep(juce::int64 barPosition, int value, int interval, int& step) const;
+    void playSteps(int step1, int step2, int timeToStartPlaying, juce::MidiBuffer& midiBuffer);
+    void handleNoteTrigger(juce::MidiBuffer&, int noteNumber, int samplePosition, float level);
+    void swapInPendingConfig();
 
     //TODO make value more descriptive... subdivisions?
     int rhythm1Value = 4; //represented as NUMERATOR in apvts
@@ -45,27 +76,26 @@ private:
     double bpm = 60;
 
     //overall logic variables
-    int totalSamples = 0; //total samples since start time
+    int totalSamples = 0; //where the next block starts in the bar on the engine's own clock
     double sampleRate = 0; //sampleRate from app, usually 44100
-    double samplesPerBar;  //= 4 * (60.0 / bpm) * sampleRate;
+    double samplesPerBar = 0;  //= 4 * (60.0 / bpm) * sampleRate;
+    juce::uint32 barCounter = 0; //bars played since start, seeds the probability rolls
 
     //rhythm1 logic variables
-    int rhythm1Interval = 0;
-    int rhythm1SamplesProcessed = 0; // samples processed before beat = totalSamples % interval
-    int rhythm1Counter = 0;
+    int rhythm1Interval = 1;
+    int rhythm1Counter = 0; //step of rhythm1 that played last
     //rhythm2 logic variables
-    int rhythm2Interval = 0;
-    int rhythm2SamplesProcessed = 0; /// samples processed before beat= totalSamples % rhythm2Interval;
-    int rhythm2Counter = 0;
-
-    //apvts of caller that created this instance of polyrhythmmetronome
-    juce::AudioProcessorValueTreeState* apvts;
-
-    //file processing stuff
-    juce::AudioFormatManager formatManager;
-    std::unique_ptr <juce::AudioFormatReaderSource> rimShotHigh = nullptr;
-    std::unique_ptr <juce::AudioFormatReaderSource> rimShotLow = nullptr;
-    std::unique_ptr <juce::AudioFormatReaderSource> rimShotSub = nullptr;
+    int rhythm2Interval = 1;
+    int rhythm2Counter = 0; //step of rhythm2 that played last
+    //set every block from the routing, a shared hit also plays the rhythm's own click when it goes to another bus than the accent
+    bool isRhythm1ApartFromAccent = false;
+    bool isRhythm2ApartFromAccent = false;
+
+    //click playback, the decoded samples live in the process wide cache
+    juce::SharedResourcePointer<ClickSampleCache> sampleCache;
+    ClickVoice rimShotHigh;
+    ClickVoice rimShotLow;
+    ClickVoice rimShotSub;
 
    const double startTime = juce::Time::getMillisecondCounterHiRes();
 
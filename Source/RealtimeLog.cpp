@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    RealtimeLog.cpp
+    Created: 20 Oct 2026 6:52:18am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "RealtimeLog.h"
+
+namespace
+{
+    //in LogMessage order
+    const char* const messageTexts[] = {
+        "couldn't add MIDI note {} at sample {} to the block, it already had {} events",
+        "host connected at {} bpm",
+        "host disconnected",
+        "preset saved, {} bytes",
+        "click kit loaded, {} sounds from files ({} from the disk cache), at {} Hz",
+        "couldn't read the click kit's file for slot {}, it keeps the built in click"
+    };
+    static_assert(juce::numElementsInArray(messageTexts) == (int)LogMessage::numMessages, "every LogMessage needs a text");
+}
+
+juce::String RealtimeLog::format(const LogRecord& record)
+{
+    if ((int)record.message >= (int)LogMessage::numMessages)
+    {
+        return "unknown message " + juce::String((int)record.message);
+    }
+    juce::String text;
+    int arg = 0;
+    for (auto* character = messageTexts[(size_t)record.message]; *character != 0; character++)
+    {
+        if (character[0] == '{' && character[1] == '}' && arg < record.numArgs)
+        {
+            const double value = record.args[(size_t)arg++];
+            text << (value == std::floor(value) && std::abs(value) < 1.0e15 ? juce::String((juce::int64)value) : juce::String(value, 2));
+            character++;
+        }
+        else
+        {
+            text << *character;
+        }
+    }
+    return text;
+}
+
+
+RealtimeLogWriter::RealtimeLogWriter()
+    : juce::Thread("log writer")
+{
+    originTime = juce::Time::getCurrentTime();
+    originTicks = juce::Time::getHighResolutionTicks();
+    pending.reserve(LogRing::capacity);
+    openFile();
+    if (stream == nullptr)
+    {
+        return;
+    }
+    startThread(juce::Thread::Priority::low);
+}
+
+RealtimeLogWriter::~RealtimeLogWriter()
+{
+    stopThread(1000);
+    if (stream != nullptr)
+    {
+        flush();
+    }
+}
+
+void RealtimeLogWriter::openFile()
+{
+    //every process that's logging gets a file of its own, a few standalones can run side by side
+    auto folder = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("MetroGnome").getChildFile("Logs");
+    folder.createDirectory();
+    for (int index = 0; index < 8; index++)
+    {
+        auto lock = std::make_unique<juce::InterProcessLock>("MetroGnome-log-" + juce::String(index));
+        if (lock->enter(0))
+        {
+            processLock = std::move(lock);
+            file = folder.getChildFile(index == 0 ? "MetroGnome.log" : "MetroGnome-" + juce::String(index) + ".log");
+            break;
+        }
+    }
+    if (processLock == nullptr)
+    {
+        return;
+    }
+    if (file.getSize() > maxFileSize)
+    {
+        rotate();
+        return;
+    }
+    stream = std::make_unique<juce::FileOutputStream>(file);
+    if (stream->failedToOpen())
+    {
+        stream.reset();
+    }
+}
+
+void RealtimeLogWriter::rotate()
+{
+    //MetroGnome.log becomes MetroGnome.1.log, MetroGnome.1.log becomes MetroGnome.2.log and so on, the oldest goes
+    stream.reset();
+    auto oldFile = [this](int age) { return file.getSiblingFile(file.getFileNameWithoutExtension() + "." + juce::String(age) + file.getFileExtension()); };
+    oldFile(numOldFiles).deleteFile();
+    for (int age = numOldFiles - 1; age >= 1; age--)
+    {
+        oldFile(age).moveFileTo(oldFile(age + 1));
+    }
+    file.moveFileTo(oldFile(1));
+
+    stream = std::make_unique<juce::FileOutputStream>(file);
+    if (stream->failedToOpen())
+    {
+        stream.reset();
+    }
+}
+
+void RealtimeLogWriter::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(250);
+        flush();
+    }
+}
+
+void RealtimeLogWriter::flush()
+{
+    if (stream == nullptr)
+    {
+        return;
+    }
+
+    //records from different threads are put back in the order they were logged
+    pending.clear();
+    juce::StringArray droppedLines;
+    LogRings::forEachRing([&](int index, const LogRings::Owner& owner, LogRing& ring)
+    {
+        ring.drain([&](const LogRecord& record) { pending.push_back({ owner, record }); });
+        if (ring.getDropped() != lastDropped[(size_t)index])
+        {
+            droppedLines.add(juce::String((int)(ring.getDropped() - lastDropped[(size_t)index])) + " records dropped by " + LogRings::getThreadName(owner));
+            lastDropped[(size_t)index] = ring.getDropped();
+        }
+    });
+    std::stable_sort(pending.begin(), pending.end(), [](const ThreadRecord& a, const ThreadRecord& b) { return a.record.ticks < b.record.ticks; });
+
+    for (const auto& entry : pending)
+    {
+        auto time = originTime + juce::RelativeTime(juce::Time::highResolutionTicksToSeconds(entry.record.ticks - originTicks));
+        *stream << time.formatted("%Y-%m-%d %H:%M:%S.") << juce::String(time.getMilliseconds()).paddedLeft('0', 3)
+                << " " << LogRings::getThreadName(entry.owner) << ": " << RealtimeLog::format(entry.record) << "\n";
+    }
+    for (const auto& line : droppedLines)
+    {
+        *stream << juce::Time::getCurrentTime().formatted("%Y-%m-%d %H:%M:%S") << " " << line << "\n";
+    }
+    stream->flush();
+
+    if (stream->getPosition() > maxFileSize)
+    {
+        rotate();
+    }
+}
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    RealtimeLog.h
+    Created: 20 Oct 2026 6:52:18am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ThreadRings.h"
+
+//a log that can be written from the audio thread and stays on in release builds, where DBG is compiled out
+//a call stores a fixed size record (which message, when, and up to four numbers) into the calling thread's own ring,
+//with no locks, allocation, formatting or system calls, the RealtimeLogWriter turns the records into text on its own thread
+//MetroGnomeTests cost measures what a call costs
+
+//every message that can be logged, the text for each is in RealtimeLog.cpp with a {} where each number goes
+enum class LogMessage : juce::uint16
+{
+    midiNoteDropped, //an engine's MIDI note didn't fit in the block's buffer
+    hostConnected,
+    hostDisconnected,
+    presetSaved,
+    clickKitLoaded,
+    clickKitSlotFailed,
+    numMessages
+};
+
+struct LogRecord
+{
+    static constexpr int maxArgs = 4;
+
+    juce::int64 ticks = 0; //juce::Time::getHighResolutionTicks() when it was logged
+    LogMessage message = LogMessage::numMessages;
+    juce::uint16 numArgs = 0;
+    std::array<double, maxArgs> args{}; //whole numbers are written without decimals
+};
+
+//every thread that logs gets a ring of its own, shared by all instances of the plugin in the process, RealtimeLogWriter is the only reader
+using LogRings = ThreadRings<LogRecord, 1024>;
+using LogRing = LogRings::Ring;
+
+namespace RealtimeLog
+{
+    template <typename... Args>
+    void writeTo(LogRing& ring, LogMessage message, Args... args) noexcept
+    {
+        static_assert(sizeof...(Args) <= LogRecord::maxArgs, "a record holds up to four numbers");
+        ring.push({ juce::Time::getHighResolutionTicks(), message, (juce::uint16)sizeof...(Args), { { (double)args... } } });
+    }
+
+    //safe from any thread, the numbers go where the message's {} are
+    template <typename... Args>
+    void write(LogMessage message, Args... args) noexcept
+    {
+        if (auto* ring = LogRings::getForThisThread())
+        {
+            writeTo(*ring, message, args...);
+        }
+    }
+
+    //the text a record stands for, without the time and thread
+    juce::String format(const LogRecord& record);
+}
+
+//empties every ring into a log file a few times a second, one per process, held through a juce::SharedResourcePointer
+//by each instance of the plugin so the rings only ever have one reader
+//the file is MetroGnome.log in the user's application data folder (another process that's logging gets MetroGnome-1.log and so on),
+//once it grows past maxFileSize it becomes MetroGnome.1.log and the oldest of numOldFiles is deleted
+class RealtimeLogWriter : private juce::Thread
+{
+public:
+    static constexpr juce::int64 maxFileSize = 1024 * 1024;
+    static constexpr int numOldFiles = 3;
+
+    RealtimeLogWriter();
+    ~RealtimeLogWriter() override;
+
+    const juce::File& getFile() const { return file; }
+
+private:
+    void run() override;
+    void flush();
+    void openFile();
+    void rotate();
+
+    struct ThreadRecord
+    {
+        LogRings::Owner owner; //copied when drained, a ring given back can be claimed by another thread before the record is written
+        LogRecord record;
+    };
+
+    std::unique_ptr<juce::InterProcessLock> processLock; //keeps other processes off this file
+    juce::File file;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::Time originTime;
+    juce::int64 originTicks = 0;
+    std::array<juce::uint32, LogRings::numRings> lastDropped{};
+    std::vector<ThreadRecord> pending; //records of every ring, sorted by time before they're written
+};
@@ -0,0 +1,19 @@
+/*
+  ==============================================================================
+
+    RhythmConfig.cpp
+    Created: 19 Oct 2026 10:12:41am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "RhythmConfig.h"
+
+RhythmConfig RhythmConfig::fromParameters(juce::AudioProcessorValueTreeState& apvts)
+{   //message thread only, builds the config that will be published as pending
+    RhythmConfig config;
+    config.numerator = (int)apvts.getRawParameterValue("NUMERATOR")->load();
+    config.subdivisions = (int)apvts.getRawParameterValue("SUBDIVISION")->load();
+    return config;
+}
@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+
+    RhythmConfig.h
+    Created: 19 Oct 2026 10:12:41am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Utilities.h"
+
+//snapshot of the rhythm settings the engines play from
+//the message thread builds a pending config whenever the user edits NUMERATOR or SUBDIVISION,
+//the audio thread keeps playing its active config until it reaches the boundary selected by QUANTIZE and then swaps the pending one in
+struct RhythmConfig
+{
+    static RhythmConfig fromParameters(juce::AudioProcessorValueTreeState& apvts);
+
+    int numerator = 4; //NUMERATOR in apvts, rhythm1 value in polyrhythm mode
+    int subdivisions = 1; //SUBDIVISION in apvts, rhythm2 value in polyrhythm mode
+};
+
+//choices of the QUANTIZE param, where a pending config is allowed to replace the active one
+enum class ConfigQuantization
+{
+    immediate = 0,
+    nextBeat,
+    nextBar
+};
+
+using RhythmConfigExchange = TripleBuffer<RhythmConfig>;
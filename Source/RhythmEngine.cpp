@@ -0,0 +1,27 @@
+/*
+  ==============================================================================
+
+    RhythmEngine.cpp
+    Created: 19 Oct 2026 1:40:05pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "RhythmEngine.h"
+#include "Metronome.h"
+#include "PolyRhythmMetronome.h"
+#include "PolyMeterMetronome.h"
+
+std::unique_ptr<RhythmEngine> RhythmEngine::createForMode(int mode, juce::AudioProcessorValueTreeState* apvts, RhythmConfigExchange* rhythmConfigs, StepPatternExchange* stepPatterns, EngineDisplayState* displayState, ScheduledClickQueue* scheduledClicks)
+{
+    if (mode == 1)
+    {
+        return std::make_unique<PolyRhythmMetronome>(apvts, rhythmConfigs, stepPatterns, displayState, scheduledClicks);
+    }
+    if (mode == 2)
+    {
+        return std::make_unique<PolyMeterMetronome>(apvts, rhythmConfigs, stepPatterns, displayState, scheduledClicks);
+    }
+    return std::make_unique<Metronome>(apvts, rhythmConfigs, stepPatterns, displayState, scheduledClicks);
+}
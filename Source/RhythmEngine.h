@@ -0,0 +1,309 @@
+/*
+  ==============================================================================
+
+    RhythmEngine.h
+    Created: 19 Oct 2026 1:40:05pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RhythmConfig.h"
+#include "StepPattern.h"
+#include "ClickSampleCache.h"
+#include "ClickKit.h"
+#include "GrooveTable.h"
+#include "Trace.h"
+#include "RealtimeLog.h"
+
+//what the editor needs to draw the active engine, written by the audio thread and read by the editor's paint
+//owned by the processor so it outlives any engine that gets swapped out
+struct EngineDisplayState
+{
+    std::atomic<int> counter1{ 0 }; //beatCounter in Default mode, rhythm1Counter otherwise
+    std::atomic<int> counter2{ 0 }; //subdivisionCounter in Default mode, rhythm2Counter otherwise
+    std::atomic<int> length1{ 4 }; //numerator in Default mode, rhythm1 value otherwise
+    std::atomic<int> length2{ 1 }; //subdivisions in Default mode, rhythm2 value otherwise
+};
+
+//a click an engine scheduled, voice 0 is rhythm1 (beats in Default mode) and 1 is rhythm2 (subdivisions in Default mode)
+struct ScheduledClick
+{
+    juce::int64 samplePosition = 0; //samples since the processor started
+    int voice = 0;
+    int step = 0; //position in the voice's cycle, before RHYTHM<1,2>_ROTATE
+};
+
+//every click the engines schedule, handed from the audio thread to the timing analysis's worker thread without locking
+//owned by the processor so it outlives any engine that gets swapped out
+class ScheduledClickQueue
+{
+public:
+    //audio thread, the engines push clicks between beginBlock and endBlock, with offsets from the start of the block
+    void beginBlock(juce::int64 _blockStart, bool _isEnabled)
+    {
+        blockStart = _blockStart;
+        isEnabled = _isEnabled;
+    }
+
+    void push(int sampleOffset, int voice, int step)
+    {
+        numPushed++;
+        if (!isEnabled)
+        {
+            return;
+        }
+        //a full queue drops the click, the analysis just misses it
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 > 0)
+        {
+            clicks[(size_t)start1] = { blockStart + sampleOffset, voice, step };
+            fifo.finishedWrite(1);
+        }
+    }
+
+    void endBlock(int numSamples) { scheduledUntil.store(blockStart + numSamples, std::memory_order_release); }
+
+    //audio thread, clicks pushed since the last call whether the analysis takes them or not, every engine and the loop cache push each click they play
+    int takeNumPushed() { return std::exchange(numPushed, 0); }
+
+    //reader thread, copies up to maxClicks clicks into dest and returns how many
+    int pop(ScheduledClick* dest, int maxClicks)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxClicks, start1, size1, start2, size2);
+        std::copy(clicks.begin() + start1, clicks.begin() + start1 + size1, dest);
+        std::copy(clicks.begin() + start2, clicks.begin() + start2 + size2, dest + size1);
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    //every click before this sample position has been pushed
+    juce::int64 getScheduledUntil() const { return scheduledUntil.load(std::memory_order_acquire); }
+
+    //while neither the audio thread nor the reader is running, drops every click of the old timeline so none of them is matched against the new one
+    void reset()
+    {
+        fifo.reset();
+        blockStart = 0;
+        numPushed = 0;
+        scheduledUntil.store(0, std::memory_order_release);
+    }
+
+private:
+    static constexpr int capacity = 1024;
+
+    juce::AbstractFifo fifo{ capacity };
+    std::array<ScheduledClick, capacity> clicks;
+    juce::int64 blockStart = 0;
+    bool isEnabled = false;
+    int numPushed = 0;
+    std::atomic<juce::int64> scheduledUntil{ 0 };
+};
+
+//where each sound slot renders this block, every buffer here is a view onto the host's own channel pointers (getBusBuffer), nothing is copied
+//a slot whose aux bus is disabled has no channels there and renders into the main bus instead, so a disabled bus costs nothing
+//SampleType is the precision the host processes in, float or double
+template <typename SampleType>
+struct OutputRouting
+{
+    static constexpr int numSoundSlots = 3; //indexed by ClickSampleId: accent (rimShotHigh), beat/rhythm1 (rimShotLow), subdivision/rhythm2 (rimShotSub)
+
+    //renders one voice into its slot's bus, NumChannels is the main bus's compile time channel count
+    template <int NumChannels>
+    void renderVoice(ClickVoice& voice, ClickSampleId slot)
+    {
+        if (hasOwnBus(slot))
+        {
+            voice.render<0>(auxBuses[(size_t)slot]);
+        }
+        else
+        {
+            voice.render<NumChannels>(main);
+        }
+    }
+
+    //the slot's aux bus is enabled, so its voice is heard apart from the main bus
+    bool hasOwnBus(ClickSampleId slot) const { return auxBuses[(size_t)slot].getNumChannels() > 0; }
+
+    //points this routing at numSamples of another one's buses from startSample, for blocks that are rendered in pieces
+    void referToPartOf(OutputRouting& whole, int startSample, int numSamples)
+    {
+        auto partOf = [startSample, numSamples](juce::AudioBuffer<SampleType>& buffer)
+        {
+            return buffer.getNumChannels() > 0 ? juce::AudioBuffer<SampleType>(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), startSample, numSamples)
+                                               : juce::AudioBuffer<SampleType>();
+        };
+        main = partOf(whole.main);
+        for (int slot = 0; slot < numSoundSlots; slot++)
+        {
+            auxBuses[(size_t)slot] = partOf(whole.auxBuses[(size_t)slot]);
+        }
+    }
+
+    juce::AudioBuffer<SampleType> main;
+    std::array<juce::AudioBuffer<SampleType>, numSoundSlots> auxBuses;
+};
+
+//common interface of the Default, Polyrhythm and Polymeter engines
+//only the engine for the current MODE exists, the processor builds a new one on the message thread and hands it to the audio thread when MODE changes
+class RhythmEngine
+{
+public:
+    template <typename SampleType>
+    using RenderFunction = void (*)(RhythmEngine&, OutputRouting<SampleType>&, juce::MidiBuffer&);
+
+    RhythmEngine(juce::AudioProcessorValueTreeState* _apvts, RhythmConfigExchange* _rhythmConfigs, StepPatternExchange* _stepPatterns, EngineDisplayState* _displayState, ScheduledClickQueue* _scheduledClicks)
+        : apvts(_apvts), rhythmConfigs(_rhythmConfigs), stepPatterns(_stepPatterns), displayState(_displayState), scheduledClicks(_scheduledClicks)
+    {
+        rotateParams[0] = apvts->getRawParameterValue("RHYTHM1_ROTATE");
+        rotateParams[1] = apvts->getRawParameterValue("RHYTHM2_ROTATE");
+        swingParam = apvts->getRawParameterValue("SWING");
+    }
+    virtual ~RhythmEngine() = default;
+
+    //engines can be prepared on the message thread while the audio thread is running, so prepareToPlay must not touch rhythmConfigs
+    virtual void prepareToPlay(double _sampleRate, int samplesPerBlock) = 0;
+    //audio thread only (or while audio is stopped)
+    virtual void resetAll() = 0;
+    virtual void resetParams() = 0;
+
+    //MODE choice this engine plays
+    virtual int getMode() const = 0;
+    //rate of the last prepareToPlay, 0 before the first
+    virtual double getSampleRate() const = 0;
+    //samples after which the output repeats while nothing changes, valid once resetParams has run
+    virtual juce::int64 getCycleLength() const = 0;
+    //samples between two beats as this engine counts them, so a position in beats lands on its grid whatever the tempo, valid once resetParams has run
+    virtual double getSamplesPerBeat() const = 0;
+    //copies everything that moves while playing (intervals, counters, ringing clicks) from other, an engine of the same mode,
+    //the exchanges, display state and click queue this engine was built with stay its own, see LoopCache
+    virtual void copyStateFrom(const RhythmEngine& other) = 0;
+    //click voices that are ringing or have a click waiting, for the diagnostics panel
+    virtual int getNumActiveVoices() const = 0;
+    //audio thread, the voices play kit's sounds from their next click on, prepareToPlay gives them the built in ones
+    //the caller keeps kit alive until this engine has let go of its samples
+    virtual void useKit(const ClickKit& kit) = 0;
+
+    //audio thread, MIDI events the engine couldn't add to the block's buffer since the last call
+    int takeDroppedMidiEvents() { return std::exchange(droppedMidiEvents, 0); }
+    //audio thread, clicks a voice had no room to queue since the last call
+    int takeDroppedClicks() { return std::exchange(droppedClicks, 0); }
+
+    //calls the render loop specialized for this engine type, the host's precision and the main bus's channel count,
+    //so there's no mode check or virtual call per block
+    template <typename SampleType>
+    void getNextAudioBlock(OutputRouting<SampleType>& routing, juce::MidiBuffer& midiBuffer)
+    {
+        TRACE_SCOPE("engine getNextAudioBlock");
+        const auto channelIndex = (size_t)juce::jmin(routing.main.getNumChannels(), 3);
+        if constexpr (std::is_same_v<SampleType, double>)
+        {
+            doubleRenderFunctions[channelIndex](*this, routing, midiBuffer);
+        }
+        else
+        {
+            renderFunctions[channelIndex](*this, routing, midiBuffer);
+        }
+    }
+
+    //audio thread, called before every block, samples every click is held back from its place in the rhythm (AUDIO_OFFSET_MS plus the lookahead)
+    void setClickDelay(int samples) { clickDelay = samples; }
+
+    //creates the engine for a MODE choice (0 Default, 1 Polyrhythm, 2 Polymeter)
+    static std::unique_ptr<RhythmEngine> createForMode(int mode, juce::AudioProcessorValueTreeState* apvts, RhythmConfigExchange* rhythmConfigs, StepPatternExchange* stepPatterns, EngineDisplayState* displayState, ScheduledClickQueue* scheduledClicks);
+
+protected:
+    //every engine calls this from its constructor with its own type, EngineType must have a public
+    //template <int NumChannels, typename SampleType> void renderBlock(OutputRouting<SampleType>&, juce::MidiBuffer&)
+    template <typename EngineType>
+    void useRenderLoopsOf()
+    {
+        renderFunctions = { &renderWith<EngineType, 0, float>, &renderWith<EngineType, 1, float>, &renderWith<EngineType, 2, float>, &renderWith<EngineType, 0, float> };
+        doubleRenderFunctions = { &renderWith<EngineType, 0, double>, &renderWith<EngineType, 1, double>, &renderWith<EngineType, 2, double>, &renderWith<EngineType, 0, double> };
+    }
+
+    //level a step of a voice (0 rhythm1, 1 rhythm2) plays at, 0 when the step is off or loses its probability roll in this bar
+    //the pattern is rotated by its RHYTHM<1,2>_ROTATE macro, wrapping within length (the voice's current step count),
+    //the groove stays with the unrotated step since it belongs to the grid position, not the pattern
+    float getStepLevel(int voice, int step, int length, juce::uint32 bar) const
+    {
+        int rotatedStep = (step + (int)rotateParams[voice]->load()) % length;
+        if (!stepPatterns->getActive().voices[(size_t)voice].isStepOn(rotatedStep))
+        {
+            return 0.0f;
+        }
+        return getLaneLevel(voice, step, length, bar);
+    }
+
+    //same without the on/off steps, for Default mode, whose beats and subdivisions aren't on the step grid
+    //so a step turned off in another mode can't silently mute them, the lanes are edited in every mode
+    float getLaneLevel(int voice, int step, int length, juce::uint32 bar) const
+    {
+        int rotatedStep = (step + (int)rotateParams[voice]->load()) % length;
+        const auto& patterns = stepPatterns->getActive();
+        return patterns.lanes[(size_t)voice].getLevel(rotatedStep, getStepRandom(bar, voice, rotatedStep)) * grooveTables[(size_t)voice].getLevel(step);
+    }
+
+    //engines with a groove call this from resetParams once their intervals are known, see GrooveTable::update
+    void updateGroove(int voice, double cycleLength, int numSteps, int interval, bool isSwung)
+    {
+        const auto& patterns = stepPatterns->getActive();
+        grooveTables[(size_t)voice].update(patterns.grooves[(size_t)voice], patterns.grooveVersion, swingParam->load() / 100.0f, isSwung, cycleLength, numSteps, interval);
+    }
+
+    //samples a step is played after the engine counts it, 0 to numSteps like GrooveTable::getOffset
+    int getGrooveOffset(int voice, int step) const { return grooveTables[(size_t)voice].getOffset(step); }
+
+    //the part of copyStateFrom that lives in this base class
+    void copyBaseStateFrom(const RhythmEngine& other)
+    {
+        clickDelay = other.clickDelay;
+        grooveTables = other.grooveTables;
+    }
+
+    //every click goes through here, sampleOffset is where it falls in the rhythm, the voice starts it clickDelay later
+    void playClick(ClickVoice& voice, int sampleOffset, float level)
+    {
+        if (!voice.trigger(sampleOffset + clickDelay, level))
+        {
+            droppedClicks++;
+        }
+    }
+
+    //every click that is triggered is reported here too, step is the voice's position before rotation
+    void reportClick(int sampleOffset, int voice, int step)
+    {
+        scheduledClicks->push(sampleOffset + clickDelay, voice, step);
+    }
+
+    //apvts of caller that created this engine
+    juce::AudioProcessorValueTreeState* apvts = nullptr;
+    //rhythm configs shared with the processor, the active one is only swapped by the audio thread
+    RhythmConfigExchange* rhythmConfigs = nullptr;
+    //step patterns published by the StepPatternStore, the processor picks up new ones at the start of each block
+    StepPatternExchange* stepPatterns = nullptr;
+    EngineDisplayState* displayState = nullptr;
+    ScheduledClickQueue* scheduledClicks = nullptr;
+    int droppedMidiEvents = 0; //audio thread
+    int droppedClicks = 0; //audio thread
+
+private:
+    //NumChannels 0 means the channel count is only known at runtime
+    template <typename EngineType, int NumChannels, typename SampleType>
+    static void renderWith(RhythmEngine& engine, OutputRouting<SampleType>& routing, juce::MidiBuffer& midiBuffer)
+    {
+        static_cast<EngineType&>(engine).template renderBlock<NumChannels>(routing, midiBuffer);
+    }
+
+    std::array<RenderFunction<float>, 4> renderFunctions{};
+    std::array<RenderFunction<double>, 4> doubleRenderFunctions{};
+    int clickDelay = 0;
+    std::atomic<float>* rotateParams[2];
+    std::atomic<float>* swingParam = nullptr;
+    std::array<GrooveTable, 2> grooveTables; //straight until an engine calls updateGroove
+};
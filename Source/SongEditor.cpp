@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    SongEditor.cpp
+    Created: 22 Oct 2026 10:14:08am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "SongEditor.h"
+
+SongEditor::SongEditor(SongStore& _songStore, StepPatternStore& _stepPatterns)
+    : songStore(_songStore), stepPatterns(_stepPatterns)
+{
+    sectionBox.setTextWhenNothingSelected("no sections");
+    sectionBox.onChange = [this] { showSection(); };
+
+    addButton.onClick = [this]
+    {
+        //a copy of the section being shown, so a song is built by adding and changing what's different
+        const int index = sectionBox.getSelectedId() - 1;
+        const auto& sections = songStore.getSections();
+        songStore.addSection(juce::isPositiveAndBelow(index, sections.size()) ? sections.getReference(index) : SongSection());
+        refresh();
+        sectionBox.setSelectedId(songStore.getSections().size());
+    };
+    removeButton.onClick = [this]
+    {
+        const int index = sectionBox.getSelectedId() - 1;
+        if (juce::isPositiveAndBelow(index, songStore.getSections().size()))
+        {
+            songStore.removeSection(index);
+            refresh();
+            sectionBox.setSelectedId(juce::jmin(index + 1, songStore.getSections().size()));
+        }
+    };
+    useStepsButton.onClick = [this]
+    {
+        editSection([this](SongSection& section) { section.patterns = stepPatterns.getPatterns().voices; });
+    };
+
+    modeBox.addItem("Default", 1);
+    modeBox.addItem("Polyrhythm", 2);
+    modeBox.addItem("Polymeter", 3);
+    modeBox.onChange = [this] { editSection([this](SongSection& section) { section.mode = modeBox.getSelectedId() - 1; }); };
+
+    //the same ranges SongStore::loadFromState keeps a section to
+    bpmSlider.setRange(1.0, 300.0, 0.1);
+    bpmSlider.setTextValueSuffix(" bpm");
+    bpmSlider.onValueChange = [this] { editSection([this](SongSection& section) { section.bpm = bpmSlider.getValue(); }); };
+    numeratorSlider.setRange(1, MAX_LENGTH, 1);
+    numeratorSlider.setTextValueSuffix(" beats");
+    numeratorSlider.onValueChange = [this] { editSection([this](SongSection& section) { section.numerator = (int)numeratorSlider.getValue(); }); };
+    subdivisionsSlider.setRange(1, MAX_LENGTH, 1);
+    subdivisionsSlider.setTextValueSuffix(" subdivisions");
+    subdivisionsSlider.onValueChange = [this] { editSection([this](SongSection& section) { section.subdivisions = (int)subdivisionsSlider.getValue(); }); };
+    barsSlider.setRange(1, 999, 1);
+    barsSlider.setTextValueSuffix(" bars");
+    barsSlider.onValueChange = [this] { editSection([this](SongSection& section) { section.bars = (int)barsSlider.getValue(); }); };
+
+    for (auto* comp : std::initializer_list<juce::Component*>{ &sectionBox, &addButton, &removeButton, &useStepsButton, &modeBox, &bpmSlider, &numeratorSlider, &subdivisionsSlider, &barsSlider })
+    {
+        addAndMakeVisible(comp);
+    }
+    showSections();
+}
+
+void SongEditor::refresh()
+{
+    if (songStore.getSerial() != shownSerial)
+    {
+        showSections();
+    }
+}
+
+void SongEditor::showSections()
+{
+    shownSerial = songStore.getSerial();
+
+    const int selected = sectionBox.getSelectedId();
+    const auto& sections = songStore.getSections();
+    sectionBox.clear(juce::dontSendNotification);
+    for (int index = 0; index < sections.size(); index++)
+    {
+        sectionBox.addItem(describe(index, sections.getReference(index)), index + 1);
+    }
+    sectionBox.setSelectedId(juce::jlimit(sections.isEmpty() ? 0 : 1, sections.size(), selected), juce::dontSendNotification);
+    showSection();
+}
+
+void SongEditor::resized()
+{
+    auto bounds = getLocalBounds().reduced(5);
+    auto list = bounds.removeFromLeft(250);
+    sectionBox.setBounds(list.removeFromTop(25));
+    list.removeFromTop(5);
+    auto buttons = list.removeFromTop(25);
+    const int buttonWidth = buttons.getWidth() / 3;
+    addButton.setBounds(buttons.removeFromLeft(buttonWidth).reduced(2, 0));
+    removeButton.setBounds(buttons.removeFromLeft(buttonWidth).reduced(2, 0));
+    useStepsButton.setBounds(buttons.reduced(2, 0));
+
+    bounds.removeFromLeft(10);
+    auto left = bounds.removeFromLeft(bounds.getWidth() / 2);
+    modeBox.setBounds(left.removeFromTop(25).reduced(2, 0));
+    left.removeFromTop(5);
+    bpmSlider.setBounds(left.removeFromTop(25).reduced(2, 0));
+    left.removeFromTop(5);
+    barsSlider.setBounds(left.removeFromTop(25).reduced(2, 0));
+    numeratorSlider.setBounds(bounds.removeFromTop(25).reduced(2, 0));
+    bounds.removeFromTop(5);
+    subdivisionsSlider.setBounds(bounds.removeFromTop(25).reduced(2, 0));
+}
+
+void SongEditor::showSection()
+{
+    const int index = sectionBox.getSelectedId() - 1;
+    const auto& sections = songStore.getSections();
+    const bool hasSection = juce::isPositiveAndBelow(index, sections.size());
+    for (auto* comp : std::initializer_list<juce::Component*>{ &removeButton, &useStepsButton, &modeBox, &bpmSlider, &numeratorSlider, &subdivisionsSlider, &barsSlider })
+    {
+        comp->setEnabled(hasSection);
+    }
+    if (!hasSection)
+    {
+        return;
+    }
+    const auto& section = sections.getReference(index);
+    modeBox.setSelectedId(section.mode + 1, juce::dontSendNotification);
+    bpmSlider.setValue(section.bpm, juce::dontSendNotification);
+    numeratorSlider.setValue(section.numerator, juce::dontSendNotification);
+    subdivisionsSlider.setValue(section.subdivisions, juce::dontSendNotification);
+    barsSlider.setValue(section.bars, juce::dontSendNotification);
+}
+
+void SongEditor::editSection(const std::function<void(SongSection&)>& edit)
+{
+    const int index = sectionBox.getSelectedId() - 1;
+    if (!juce::isPositiveAndBelow(index, songStore.getSections().size()))
+    {
+        return;
+    }
+    auto section = songStore.getSections()[index];
+    edit(section);
+    songStore.setSection(index, section);
+    //the store's serial moved, but only this section's text changed, rebuilding the list would end a slider drag
+    shownSerial = songStore.getSerial();
+    sectionBox.changeItemText(index + 1, describe(index, section));
+}
+
+juce::String SongEditor::describe(int index, const SongSection& section)
+{
+    const char* const modeNames[] = { "Default", "Polyrhythm", "Polymeter" };
+    return juce::String(index + 1) + ": " + modeNames[section.mode] + ", " + juce::String(section.bars) + " bars at " + juce::String(section.bpm, 1) + " bpm";
+}
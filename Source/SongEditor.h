@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    SongEditor.h
+    Created: 22 Oct 2026 10:14:08am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SongTimeline.h"
+#include "StepPattern.h"
+
+//the song's sections (see SongStore), one picked from the list at a time and edited with the controls next to it
+//a new section is a copy of the one shown, "use steps" gives a section the steps the step grid is showing
+class SongEditor : public juce::Component
+{
+public:
+    SongEditor(SongStore& _songStore, StepPatternStore& _stepPatterns);
+
+    //message thread, shows the sections again when a preset or a restored session replaced them, cheap enough for every frame
+    void refresh();
+
+    void resized() override;
+
+private:
+    void showSections();
+    void showSection();
+    void editSection(const std::function<void(SongSection&)>& edit);
+    static juce::String describe(int index, const SongSection& section);
+
+    SongStore& songStore;
+    StepPatternStore& stepPatterns;
+    juce::uint32 shownSerial = 0;
+    juce::ComboBox sectionBox; //item ids are the section + 1
+    juce::TextButton addButton{ "add" };
+    juce::TextButton removeButton{ "remove" };
+    juce::TextButton useStepsButton{ "use steps" };
+    juce::ComboBox modeBox; //item ids are MODE + 1
+    juce::Slider bpmSlider{ juce::Slider::LinearBar, juce::Slider::TextBoxLeft };
+    juce::Slider numeratorSlider{ juce::Slider::IncDecButtons, juce::Slider::TextBoxLeft };
+    juce::Slider subdivisionsSlider{ juce::Slider::IncDecButtons, juce::Slider::TextBoxLeft };
+    juce::Slider barsSlider{ juce::Slider::IncDecButtons, juce::Slider::TextBoxLeft };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SongEditor)
+};
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    SongTimeline.cpp
+    Created: 19 Oct 2026 10:31:54pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "SongTimeline.h"
+
+SongSection::SongSection()
+{
+    for (auto& pattern : patterns)
+    {
+        pattern.setAll(true);
+    }
+}
+
+
+void SongTimeline::compile(const juce::Array<SongSection>& _sections, double sampleRate)
+{
+    sections.assign(_sections.begin(), _sections.end());
+    sectionStarts.assign(1, 0);
+
+    //the exact running totals are only rounded at each start, so rounding never builds up over a long song
+    double exactSamples = 0;
+    for (const auto& section : sections)
+    {
+        const double beats = (double)section.bars * section.getBeatsPerBar();
+        exactSamples += beats * 60.0 / section.bpm * sampleRate;
+        sectionStarts.push_back((juce::int64)std::llround(exactSamples));
+    }
+}
+
+int SongTimeline::findSection(juce::int64 samplePosition) const
+{
+    //the first start after the position belongs to the section after the one playing
+    auto next = std::upper_bound(sectionStarts.begin(), sectionStarts.end(), samplePosition);
+    return (int)(next - sectionStarts.begin()) - 1;
+}
+
+
+
+SongStore::SongStore(juce::AudioProcessorValueTreeState& _apvts) : apvts(_apvts)
+{
+    loadFromState();
+}
+
+void SongStore::setSections(const juce::Array<SongSection>& newSections)
+{
+    sections = newSections;
+    saveToState();
+}
+
+void SongStore::addSection(const SongSection& section)
+{
+    sections.add(section);
+    saveToState();
+}
+
+void SongStore::setSection(int index, const SongSection& section)
+{
+    if (juce::isPositiveAndBelow(index, sections.size()))
+    {
+        sections.set(index, section);
+        saveToState();
+    }
+}
+
+void SongStore::removeSection(int index)
+{
+    sections.remove(index);
+    saveToState();
+}
+
+void SongStore::loadFromState()
+{
+    sections.clear();
+    for (const auto& child : apvts.state.getChildWithName("SONG"))
+    {
+        SongSection section;
+        section.bpm = juce::jlimit(1.0, 300.0, (double)child.getProperty("bpm", 120.0));
+        section.numerator = juce::jlimit(1, MAX_LENGTH, (int)child.getProperty("numerator", 4));
+        section.subdivisions = juce::jlimit(1, MAX_LENGTH, (int)child.getProperty("subdivisions", 1));
+        section.mode = juce::jlimit(0, 2, (int)child.getProperty("mode", 0));
+        section.bars = juce::jmax(1, (int)child.getProperty("bars", 4));
+        const char* const patternIds[] = { "pattern1", "pattern2" };
+        for (size_t voice = 0; voice < section.patterns.size(); voice++)
+        {
+            auto text = child.getProperty(patternIds[voice]).toString();
+            if (text.length() == StepPattern::numWords * 16)
+            {
+                section.patterns[voice] = StepPattern::fromString(text);
+            }
+        }
+        sections.add(section);
+    }
+    serial++;
+    if (onChange)
+    {
+        onChange();
+    }
+}
+
+void SongStore::saveToState()
+{
+    auto song = apvts.state.getOrCreateChildWithName("SONG", nullptr);
+    song.removeAllChildren(nullptr);
+    for (const auto& section : sections)
+    {
+        juce::ValueTree child("SECTION");
+        child.setProperty("bpm", section.bpm, nullptr);
+        child.setProperty("numerator", section.numerator, nullptr);
+        child.setProperty("subdivisions", section.subdivisions, nullptr);
+        child.setProperty("mode", section.mode, nullptr);
+        child.setProperty("bars", section.bars, nullptr);
+        child.setProperty("pattern1", section.patterns[0].toString(), nullptr);
+        child.setProperty("pattern2", section.patterns[1].toString(), nullptr);
+        song.appendChild(child, nullptr);
+    }
+    serial++;
+    if (onChange)
+    {
+        onChange();
+    }
+}
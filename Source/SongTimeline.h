@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    SongTimeline.h
+    Created: 19 Oct 2026 10:31:54pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RhythmConfig.h"
+#include "RhythmEngine.h"
+#include "StepPattern.h"
+
+//one part of a song, played for a whole number of bars with its own tempo, meter, mode and steps
+struct SongSection
+{
+    SongSection();
+
+    //beats in one of this section's bars, Default mode counts NUMERATOR beats, the other modes have 4 beat bars
+    int getBeatsPerBar() const { return mode == 0 ? numerator : 4; }
+
+    double bpm = 120;
+    int numerator = 4;
+    int subdivisions = 1;
+    int mode = 0; //MODE choice, 0 Default, 1 Polyrhythm, 2 Polymeter
+    int bars = 4;
+    std::array<StepPattern, 2> patterns; //every step on unless edited, the lanes and grooves stay shared with the StepPatternStore
+};
+
+//the sections laid end to end, compiled at one sample rate into cumulative start positions in samples
+//so the section at any position is found by binary search, a host that seeks, loops or jumps costs O(log n) instead of replaying the song
+//the host's sample position places the song rather than its PPQ, which runs at the host's tempo and not the sections'
+class SongTimeline
+{
+public:
+    //message thread
+    void compile(const juce::Array<SongSection>& _sections, double sampleRate);
+
+    int getNumSections() const { return (int)sections.size(); }
+    const SongSection& getSection(int index) const { return sections[(size_t)index]; }
+
+    //any thread once compiled, -1 before the song starts and getNumSections() after it ends
+    int findSection(juce::int64 samplePosition) const;
+
+    //sections start on whole samples, the end of one is the start of the next
+    juce::int64 getSectionStart(int index) const { return sectionStarts[(size_t)index]; }
+    juce::int64 getSectionEnd(int index) const { return sectionStarts[(size_t)index + 1]; }
+
+private:
+    std::vector<SongSection> sections;
+    std::vector<juce::int64> sectionStarts; //one more than there are sections, the last is the end of the song
+};
+
+//a compiled song and everything the audio thread needs to play it, built and prepared on the message thread
+//and handed to the audio thread whole, like a pending engine, so a section can switch mode mid block without building anything
+//the engines read the song's own config and pattern exchanges, which only the audio thread writes and reads
+struct CompiledSong
+{
+    RhythmConfigExchange configs;
+    StepPatternExchange patterns;
+    SongTimeline timeline;
+    std::vector<StepPatterns> sectionPatterns; //each section's steps with the store's lanes and grooves, compiled again whenever those change
+    std::array<std::unique_ptr<RhythmEngine>, 3> engines; //indexed by mode, only the modes the song uses are built
+    double sampleRate = 0; //the engines were prepared for it and the timeline compiled at it
+};
+
+//owns the editable list of sections on the message thread and keeps it in the apvts state, under a SONG child, so it's saved with the session
+//every edit calls onChange, the processor then compiles the song again
+class SongStore
+{
+public:
+    SongStore(juce::AudioProcessorValueTreeState& _apvts);
+
+    //message thread only
+    const juce::Array<SongSection>& getSections() const { return sections; }
+    void setSections(const juce::Array<SongSection>& newSections);
+    void addSection(const SongSection& section);
+    void setSection(int index, const SongSection& section);
+    void removeSection(int index);
+    void loadFromState(); //call after the apvts state has been replaced
+    //moves with every edit and reload, for views that have to show the sections again
+    juce::uint32 getSerial() const { return serial; }
+
+    std::function<void()> onChange;
+
+private:
+    void saveToState();
+
+    juce::AudioProcessorValueTreeState& apvts;
+    juce::Array<SongSection> sections;
+    juce::uint32 serial = 0;
+};
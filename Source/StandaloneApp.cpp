@@ -0,0 +1,353 @@
+/*
+  ==============================================================================
+
+    StandaloneApp.cpp
+    Created: 20 Oct 2026 5:31:52am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+//replaces JUCE's standalone app (JUCE_USE_CUSTOM_PLUGIN_STANDALONE_APP=1 in the project's defines) for live use as a click source:
+//the process's memory is locked so the audio thread never waits on a page fault, the audio thread asks for real time priority,
+//every engine is run once before the user can press play, and --auto-buffer finds the smallest buffer size that plays without xruns
+#if JucePlugin_Build_Standalone && JUCE_USE_CUSTOM_PLUGIN_STANDALONE_APP
+
+#include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
+#include "PluginProcessor.h"
+
+#if JUCE_LINUX
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include <unistd.h>
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+namespace
+{
+    //no host, the throwaway processor runs on its own clock while it's prewarmed
+    class NoHostPlayHead : public juce::AudioPlayHead
+    {
+    public:
+        juce::Optional<PositionInfo> getPosition() const override { return {}; }
+    };
+
+    //runs a throwaway copy of the processor the device is about to play through every mode at the device's rate and block size,
+    //offline and silently, so the clicks are decoded into the shared sample cache for this rate and every render path has been run
+    //before the first real click, the user's processor is never touched: no parameter changes reach the host or the undo history,
+    //its diagnostics stay its own and the device's callback never waits on it
+    void prewarm(MetroGnomeAudioProcessor& processor, double sampleRate, int blockSize)
+    {
+        if (sampleRate <= 0 || blockSize <= 0)
+        {
+            return;
+        }
+        //the user's kit and patterns, so it's their samples that get decoded
+        juce::MemoryBlock state;
+        processor.getStateInformation(state);
+        auto warmer = std::make_unique<MetroGnomeAudioProcessor>();
+        warmer->setStateInformation(state.getData(), (int)state.getSize());
+        //a copy of a leading instance would publish offline positions to the instances following it, and a song would skip the engines
+        auto* localSyncParam = warmer->apvts.getParameter("LOCAL_SYNC");
+        localSyncParam->setValueNotifyingHost(localSyncParam->convertTo0to1(0.0f));
+        auto* songParam = warmer->apvts.getParameter("SONG");
+        songParam->setValueNotifyingHost(0.0f);
+        auto* modeParam = warmer->apvts.getParameter("MODE");
+        auto* onOffParam = warmer->apvts.getParameter("ON/OFF");
+        onOffParam->setValueNotifyingHost(1.0f);
+
+        NoHostPlayHead noHost;
+        warmer->setPlayHead(&noHost);
+        warmer->setRateAndBufferSizeDetails(sampleRate, blockSize);
+        warmer->prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(juce::jmax(warmer->getTotalNumInputChannels(), warmer->getTotalNumOutputChannels()), blockSize);
+        juce::MidiBuffer midiMessages;
+        const int modeLength = juce::roundToInt(sampleRate / 2);
+        for (int mode = 0; mode < 3; mode++)
+        {
+            modeParam->setValueNotifyingHost(modeParam->convertTo0to1((float)mode));
+            warmer->runMessageThreadUpdates();
+            warmer->requestReset();
+            for (int rendered = 0; rendered < modeLength; rendered += blockSize)
+            {
+                buffer.clear();
+                midiMessages.clear();
+                warmer->processBlock(buffer, midiMessages);
+            }
+        }
+        warmer->releaseResources();
+        warmer->setPlayHead(nullptr);
+    }
+
+    //rides along with the plugin on the device's callback and moves the audio thread to SCHED_FIFO on the first block
+    //JACK's thread is usually real time already and is left as it is, ALSA's is only if this asks for it
+    //every time the device starts, at a new rate, buffer size or device, a copy of the plugin's processor is prewarmed for it first
+    class RealtimePromoter : public juce::AudioIODeviceCallback
+    {
+    public:
+        enum State { notTried, promoted, alreadyRealtime, failed };
+
+        RealtimePromoter(juce::StandalonePluginHolder& _holder) : holder(_holder) {}
+
+        State getState() const { return (State)state.load(); }
+
+        void audioDeviceAboutToStart(juce::AudioIODevice* device) override
+        {
+            //a restarted device can come back on a new thread
+            hasTried = false;
+            //the device manager starts devices from the message thread, the processor's message thread updates can only run there
+            auto* processor = dynamic_cast<MetroGnomeAudioProcessor*>(holder.processor.get());
+            if (processor != nullptr && device != nullptr && juce::MessageManager::existsAndIsCurrentThread())
+            {
+                prewarm(*processor, device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples());
+            }
+        }
+        void audioDeviceStopped() override {}
+
+        void audioDeviceIOCallbackWithContext(const float* const*, int, float* const* outputChannelData, int numOutputChannels, int numSamples, const juce::AudioIODeviceCallbackContext&) override
+        {
+            //the device manager adds every callback's output together, this one only adds silence
+            for (int channel = 0; channel < numOutputChannels; channel++)
+            {
+                if (outputChannelData[channel] != nullptr)
+                {
+                    juce::FloatVectorOperations::clear(outputChannelData[channel], numSamples);
+                }
+            }
+            if (!hasTried)
+            {
+                hasTried = true;
+                state.store(promote());
+            }
+        }
+
+    private:
+        static State promote()
+        {
+#if JUCE_LINUX
+            int policy = 0;
+            sched_param param{};
+            pthread_getschedparam(pthread_self(), &policy, &param);
+            if (policy == SCHED_FIFO || policy == SCHED_RR)
+            {
+                return alreadyRealtime;
+            }
+            //under JACK's usual 70-80 so the server's own threads still come first
+            param.sched_priority = juce::jmin(sched_get_priority_max(SCHED_FIFO), 70);
+            //needs rtprio in /etc/security/limits.conf (or CAP_SYS_NICE), otherwise the thread stays where it was
+            return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0 ? promoted : failed;
+#else
+            return failed;
+#endif
+        }
+
+        juce::StandalonePluginHolder& holder;
+        bool hasTried = false; //audio thread
+        std::atomic<int> state{ notTried };
+    };
+
+    //tries the device's buffer sizes from the smallest up, each for trialSeconds, and keeps the first one that had no xruns
+    //xruns are the device's own count where it keeps one (ALSA and JACK do) plus the processor's overruns and late callbacks
+    class BufferSizeTuner : private juce::Timer
+    {
+    public:
+        BufferSizeTuner(juce::StandalonePluginHolder& _holder) : holder(_holder)
+        {
+            if (auto* device = holder.deviceManager.getCurrentAudioDevice())
+            {
+                sizes = device->getAvailableBufferSizes();
+                sizes.sort();
+                trySize(0);
+            }
+        }
+
+    private:
+        static constexpr int trialSeconds = 5;
+
+        void trySize(int index)
+        {
+            sizeIndex = index;
+            auto setup = holder.deviceManager.getAudioDeviceSetup();
+            setup.bufferSize = sizes[index];
+            holder.deviceManager.setAudioDeviceSetup(setup, true);
+            xrunsAtStart = countXRuns();
+            startTimer(trialSeconds * 1000);
+        }
+
+        void timerCallback() override
+        {
+            stopTimer();
+            const auto xruns = countXRuns() - xrunsAtStart;
+            if (xruns > 0 && sizeIndex + 1 < sizes.size())
+            {
+                juce::Logger::writeToLog("buffer size " + juce::String(sizes[sizeIndex]) + ": " + juce::String(xruns) + " xruns, trying the next one up");
+                trySize(sizeIndex + 1);
+                return;
+            }
+            juce::Logger::writeToLog("buffer size " + juce::String(sizes[sizeIndex]) + (xruns > 0 ? " is the largest there is, xruns remain" : " is stable"));
+        }
+
+        juce::int64 countXRuns() const
+        {
+            juce::int64 xruns = 0;
+            if (auto* device = holder.deviceManager.getCurrentAudioDevice())
+            {
+                xruns += juce::jmax(0, device->getXRunCount());
+            }
+            if (auto* processor = dynamic_cast<MetroGnomeAudioProcessor*>(holder.processor.get()))
+            {
+                xruns += processor->diagnostics.loadMeasurer.getXRunCount();
+                xruns += (juce::int64)processor->diagnostics.callbackGaps.load(std::memory_order_relaxed);
+            }
+            return xruns;
+        }
+
+        juce::StandalonePluginHolder& holder;
+        juce::Array<int> sizes;
+        int sizeIndex = 0;
+        juce::int64 xrunsAtStart = 0;
+    };
+}
+
+class MetroGnomeStandaloneApp : public juce::JUCEApplication
+{
+public:
+    MetroGnomeStandaloneApp()
+    {
+        juce::PropertiesFile::Options options;
+        options.applicationName = juce::CharPointer_UTF8(JucePlugin_Name);
+        options.filenameSuffix = ".settings";
+        options.osxLibrarySubFolder = "Application Support";
+#if JUCE_LINUX || JUCE_BSD
+        options.folderName = "~/.config";
+#else
+        options.folderName = "";
+#endif
+        appProperties.setStorageParameters(options);
+    }
+
+    const juce::String getApplicationName() override { return juce::CharPointer_UTF8(JucePlugin_Name); }
+    const juce::String getApplicationVersion() override { return JucePlugin_VersionString; }
+    //several instances play different click mixes for different performers
+    bool moreThanOneInstanceAllowed() override { return true; }
+    void anotherInstanceStarted(const juce::String&) override {}
+
+    void initialise(const juce::String& commandLine) override
+    {
+        lockMemory();
+
+        mainWindow = std::make_unique<juce::StandaloneFilterWindow>(getApplicationName(),
+            juce::LookAndFeel::getDefaultLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId),
+            appProperties.getUserSettings(), false);
+        mainWindow->setVisible(true);
+
+        if (auto* holder = mainWindow->getPluginHolder())
+        {
+            //the device is running by now, adding the callback starts it for this one too, which prewarms a copy of the processor
+            realtimePromoter = std::make_unique<RealtimePromoter>(*holder);
+            holder->deviceManager.addAudioCallback(realtimePromoter.get());
+            if (commandLine.contains("--auto-buffer"))
+            {
+                bufferSizeTuner = std::make_unique<BufferSizeTuner>(*holder);
+            }
+        }
+
+        juce::Timer::callAfterDelay(2000, [this]
+        {
+            const char* states[] = { "audio thread priority not set yet", "audio thread is real time", "audio thread was already real time", "audio thread couldn't get real time priority" };
+            if (realtimePromoter != nullptr)
+            {
+                juce::Logger::writeToLog(states[realtimePromoter->getState()]);
+            }
+        });
+    }
+
+    void shutdown() override
+    {
+        bufferSizeTuner.reset();
+        if (mainWindow != nullptr)
+        {
+            if (auto* holder = mainWindow->getPluginHolder())
+            {
+                holder->deviceManager.removeAudioCallback(realtimePromoter.get());
+            }
+        }
+        realtimePromoter.reset();
+        mainWindow = nullptr;
+        appProperties.saveIfNeeded();
+    }
+
+    void systemRequestedQuit() override
+    {
+        if (mainWindow != nullptr)
+        {
+            if (auto* holder = mainWindow->getPluginHolder())
+            {
+                holder->savePluginState();
+            }
+        }
+
+        if (juce::ModalComponentManager::getInstance()->cancelAllModalComponents())
+        {
+            juce::Timer::callAfterDelay(100, []()
+            {
+                if (auto app = juce::JUCEApplicationBase::getInstance())
+                {
+                    app->systemRequestedQuit();
+                }
+            });
+        }
+        else
+        {
+            quit();
+        }
+    }
+
+private:
+    static void lockMemory()
+    {
+#if JUCE_LINUX
+        //locked memory counts against RLIMIT_MEMLOCK (memlock in /etc/security/limits.conf), with MCL_FUTURE every later allocation does too
+        //and fails once it's reached, so everything later is only locked when the limit is unlimited,
+        //otherwise what's mapped now is locked if it fits, and nothing if it doesn't
+        rlimit limit{};
+        if (getrlimit(RLIMIT_MEMLOCK, &limit) != 0)
+        {
+            return;
+        }
+        if (limit.rlim_cur == RLIM_INFINITY)
+        {
+            if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+            {
+                juce::Logger::writeToLog("couldn't lock memory");
+            }
+            return;
+        }
+        //the first field of statm is every page mapped, which is what MCL_CURRENT locks
+        const auto mappedBytes = (rlim_t)juce::File("/proc/self/statm").loadFileAsString().getLargeIntValue() * (rlim_t)sysconf(_SC_PAGESIZE);
+        if (mappedBytes == 0 || mappedBytes > limit.rlim_cur || mlockall(MCL_CURRENT) != 0)
+        {
+            juce::Logger::writeToLog("memory not locked, the memlock limit is " + juce::String((juce::int64)(limit.rlim_cur / 1024)) + "k for "
+                + juce::String((juce::int64)(mappedBytes / 1024)) + "k mapped, set it to unlimited to avoid page faults on the audio thread");
+            return;
+        }
+        juce::Logger::writeToLog("memory mapped so far is locked, set the memlock limit to unlimited to lock what's allocated later too");
+#endif
+    }
+
+    juce::ApplicationProperties appProperties;
+    std::unique_ptr<juce::StandaloneFilterWindow> mainWindow;
+    std::unique_ptr<RealtimePromoter> realtimePromoter;
+    std::unique_ptr<BufferSizeTuner> bufferSizeTuner;
+};
+
+juce::JUCEApplicationBase* juce_CreateApplication()
+{
+    return new MetroGnomeStandaloneApp();
+}
+
+#endif
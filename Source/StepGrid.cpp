@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    StepGrid.cpp
+    Created: 20 Oct 2026 1:17:52am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "StepGrid.h"
+
+StepGrid::StepGrid(const StepPatternStore& _stepPatterns, const EngineDisplayState& _displayState)
+    : stepPatterns(_stepPatterns), displayState(_displayState)
+{
+    cells.reserve(2 * MAX_LENGTH);
+    setRepaintsOnMouseActivity(false);
+}
+
+void StepGrid::setLengths(int length1, int length2)
+{
+    length1 = juce::jlimit(1, MAX_LENGTH, length1);
+    length2 = juce::jlimit(1, MAX_LENGTH, length2);
+    if (length1 == lengths[0] && length2 == lengths[1])
+    {
+        return;
+    }
+    lengths = { length1, length2 };
+    updateLayout();
+    repaint();
+}
+
+void StepGrid::resized()
+{
+    updateLayout();
+}
+
+void StepGrid::updateLayout()
+{
+    //same circles the editor draws in drawPolyRhythmCircle, rhythm2's is the smaller one
+    cells.clear();
+    auto visualArea = getLocalBounds().reduced(cellSize);
+    int width = visualArea.getWidth();
+    int height = visualArea.getHeight();
+    int radius = (width > height) ? height : width;
+    const float radiusSkews[2] = { 1.0f, 1.5f };
+    auto unitTick = getLookAndFeel().getTickShape(0.75f);
+
+    for (int voice = 0; voice < 2; voice++)
+    {
+        if (lengths[(size_t)voice] == 1)
+        {
+            continue;
+        }
+        juce::Path rhythmCircle;
+        int rhythmRadius = radius / radiusSkews[voice];
+        int Xoffset = (width - rhythmRadius) / 2;
+        int Yoffset = (height - rhythmRadius) / 2;
+        rhythmCircle.addEllipse(visualArea.getX() + Xoffset, visualArea.getY() + Yoffset, rhythmRadius, rhythmRadius);
+        float circleLength = rhythmCircle.getLength();
+
+        for (int step = 0; step < lengths[(size_t)voice]; step++)
+        {
+            //the cell hangs off the step's point on the circle like the old toggle buttons did, the box sits where their tick box was
+            auto point = rhythmCircle.getPointAlongPath((float(step) / lengths[(size_t)voice]) * circleLength);
+            Cell cell;
+            cell.voice = voice;
+            cell.step = step;
+            cell.bounds = juce::Rectangle<int>((int)point.getX(), (int)point.getY(), cellSize, cellSize);
+            float boxSize = juce::jmin(15.0f, cellSize * 0.75f) * 1.1f;
+            cell.box = juce::Rectangle<float>(cell.bounds.getX() + 4.0f, cell.bounds.getY() + (cellSize - boxSize) * 0.5f, boxSize, boxSize);
+            cell.tick = unitTick;
+            cell.tick.applyTransform(cell.tick.getTransformToScaleToFit(cell.box.reduced(4, 5), false));
+            cells.push_back(cell);
+        }
+    }
+}
+
+void StepGrid::paint(juce::Graphics& g)
+{
+    TRACE_SCOPE("step grid paint");
+    const int counters[2] = { displayState.counter1.load(), displayState.counter2.load() };
+    for (const auto& cell : cells)
+    {
+        g.setColour(juce::Colours::grey);
+        g.drawRoundedRectangle(cell.box, 4.0f, 1.0f);
+        if (stepPatterns.isStepOn(cell.voice, cell.step))
+        {
+            //the step that is playing right now lights up
+            g.setColour(counters[cell.voice] == cell.step ? juce::Colours::green : juce::Colours::grey);
+            g.fillPath(cell.tick);
+        }
+    }
+}
+
+bool StepGrid::hitTest(int x, int y)
+{
+    //clicks between the boxes go through to the editor
+    return findCell({ x, y }) != nullptr;
+}
+
+void StepGrid::mouseDown(const juce::MouseEvent& event)
+{
+    auto* cell = findCell(event.getPosition());
+    if (cell != nullptr && onStepClicked)
+    {
+        onStepClicked(cell->voice, cell->step);
+        repaint(cell->bounds);
+    }
+}
+
+const StepGrid::Cell* StepGrid::findCell(juce::Point<int> position) const
+{
+    //later cells are drawn on top where the circles' cells overlap, so they win
+    for (auto cell = cells.rbegin(); cell != cells.rend(); ++cell)
+    {
+        if (cell->bounds.contains(position))
+        {
+            return &*cell;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    StepGrid.h
+    Created: 20 Oct 2026 1:17:52am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Utilities.h"
+#include "RhythmEngine.h"
+#include "StepPattern.h"
+#include "Trace.h"
+
+//every step of both voices in one component, drawn as tick boxes around the polyrhythm circles instead of a ToggleButton per step
+//the boxes' positions are worked out when the size or the voices' lengths change, painting only walks that list
+//and reads the steps and counters, clicks are matched against the same list
+class StepGrid : public juce::Component
+{
+public:
+    StepGrid(const StepPatternStore& _stepPatterns, const EngineDisplayState& _displayState);
+
+    //steps shown per voice, a voice of length 1 has nothing to toggle and shows no boxes
+    //does nothing when they haven't changed, so it can be called every frame
+    void setLengths(int length1, int length2);
+
+    //called with the voice and step of a clicked box, the grid only draws the store and never changes it itself
+    std::function<void(int voice, int step)> onStepClicked;
+
+    //how far the boxes reach past the circles, the grid's bounds should be the visual area expanded by this
+    static constexpr int cellSize = 22;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    bool hitTest(int x, int y) override;
+    void mouseDown(const juce::MouseEvent& event) override;
+
+private:
+    struct Cell
+    {
+        juce::Rectangle<float> box; //the tick box drawn in the cell
+        juce::Path tick; //already scaled into the box
+        juce::Rectangle<int> bounds; //clickable area
+        int voice = 0;
+        int step = 0;
+    };
+
+    void updateLayout();
+    const Cell* findCell(juce::Point<int> position) const;
+
+    const StepPatternStore& stepPatterns;
+    const EngineDisplayState& displayState;
+    std::array<int, 2> lengths{ 1, 1 };
+    std::vector<Cell> cells; //voice 1's steps first, both in step order
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StepGrid)
+};
@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    StepLaneEditor.cpp
+    Created: 21 Oct 2026 9:02:37am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "StepLaneEditor.h"
+
+void LaneBars::setNumSteps(int _numSteps)
+{
+    _numSteps = juce::jlimit(1, MAX_STEPS, _numSteps);
+    if (_numSteps != numSteps)
+    {
+        numSteps = _numSteps;
+        repaint();
+    }
+}
+
+void LaneBars::paint(juce::Graphics& g)
+{
+    if (!getValue)
+    {
+        return;
+    }
+    const float barWidth = getWidth() / (float)numSteps;
+    for (int step = 0; step < numSteps; step++)
+    {
+        juce::Rectangle<float> bar(step * barWidth, 0.0f, barWidth, (float)getHeight());
+        bar.reduce(1.0f, 0.0f);
+        g.setColour(juce::Colours::darkgrey);
+        g.fillRect(bar);
+        //the first step of the cycle stands out like the accent does on the circles
+        g.setColour(step == 0 ? juce::Colours::orange : juce::Colours::steelblue);
+        g.fillRect(bar.removeFromBottom(bar.getHeight() * juce::jlimit(0.0f, 1.0f, getValue(step))));
+    }
+}
+
+void LaneBars::mouseDown(const juce::MouseEvent& event)
+{
+    setFromMouse(event.getPosition());
+}
+
+void LaneBars::mouseDrag(const juce::MouseEvent& event)
+{
+    //dragging across draws the lane, every bar passed over is set
+    setFromMouse(event.getPosition());
+}
+
+void LaneBars::setFromMouse(juce::Point<int> position)
+{
+    if (!onValueChanged || getWidth() <= 0 || getHeight() <= 0)
+    {
+        return;
+    }
+    const int step = juce::jlimit(0, numSteps - 1, position.getX() * numSteps / getWidth());
+    const float value = juce::jlimit(0.0f, 1.0f, 1.0f - position.getY() / (float)getHeight());
+    onValueChanged(step, value);
+    repaint();
+}
+
+
+StepLaneEditor::StepLaneEditor(StepPatternStore& _stepPatterns)
+    : stepPatterns(_stepPatterns)
+{
+    voiceBox.addItem("rhythm 1", 1);
+    voiceBox.addItem("rhythm 2", 2);
+    voiceBox.setSelectedId(1, juce::dontSendNotification);
+    voiceBox.onChange = [this] { updateBars(); };
+
+    laneBox.addItem("velocity", 1);
+    laneBox.addItem("accent", 2);
+    laneBox.addItem("probability", 3);
+    laneBox.setSelectedId(1, juce::dontSendNotification);
+    laneBox.onChange = [this] { updateBars(); };
+
+    bars.getValue = [this](int step) { return getLaneValue(step); };
+    bars.onValueChanged = [this](int step, float value) { setLaneValue(step, value); };
+
+    addAndMakeVisible(voiceBox);
+    addAndMakeVisible(laneBox);
+    addAndMakeVisible(bars);
+}
+
+void StepLaneEditor::setLengths(int length1, int length2)
+{
+    if (length1 == lengths[0] && length2 == lengths[1])
+    {
+        return;
+    }
+    lengths = { length1, length2 };
+    updateBars();
+}
+
+void StepLaneEditor::resized()
+{
+    auto bounds = getLocalBounds().reduced(5);
+    auto controls = bounds.removeFromLeft(120);
+    voiceBox.setBounds(controls.removeFromTop(25));
+    controls.removeFromTop(5);
+    laneBox.setBounds(controls.removeFromTop(25));
+    bounds.removeFromLeft(5);
+    bars.setBounds(bounds);
+}
+
+float StepLaneEditor::getLaneValue(int step) const
+{
+    const auto& lanes = stepPatterns.getLanes(voiceBox.getSelectedId() - 1);
+    switch (laneBox.getSelectedId())
+    {
+    case 2:
+        return lanes.accent[(size_t)step];
+    case 3:
+        return lanes.probability[(size_t)step];
+    default:
+        return lanes.velocity[(size_t)step];
+    }
+}
+
+void StepLaneEditor::setLaneValue(int step, float value)
+{
+    const int voice = voiceBox.getSelectedId() - 1;
+    switch (laneBox.getSelectedId())
+    {
+    case 2:
+        stepPatterns.setAccent(voice, step, value);
+        break;
+    case 3:
+        stepPatterns.setProbability(voice, step, value);
+        break;
+    default:
+        stepPatterns.setVelocity(voice, step, value);
+        break;
+    }
+}
+
+void StepLaneEditor::updateBars()
+{
+    bars.setNumSteps(lengths[(size_t)(voiceBox.getSelectedId() - 1)]);
+    bars.repaint();
+}
+
+
+GrooveEditor::GrooveEditor(StepPatternStore& _stepPatterns)
+    : stepPatterns(_stepPatterns)
+{
+    voiceBox.addItem("rhythm 1", 1);
+    voiceBox.addItem("rhythm 2", 2);
+    voiceBox.setSelectedId(1, juce::dontSendNotification);
+    voiceBox.onChange = [this] { updateBars(); };
+
+    laneBox.addItem("timing", 1);
+    laneBox.addItem("velocity", 2);
+    laneBox.setSelectedId(1, juce::dontSendNotification);
+    laneBox.onChange = [this] { bars.repaint(); };
+
+    lengthSlider.setRange(1, MAX_STEPS, 1);
+    lengthSlider.onValueChange = [this] {
+        stepPatterns.setGrooveLength(voiceBox.getSelectedId() - 1, (int)lengthSlider.getValue());
+        updateBars();
+    };
+
+    //a full bar is the latest a step can be pushed, GrooveTemplate::maxTiming
+    bars.getValue = [this](int step) { return getGrooveValue(step); };
+    bars.onValueChanged = [this](int step, float value) { setGrooveValue(step, value); };
+
+    addAndMakeVisible(voiceBox);
+    addAndMakeVisible(laneBox);
+    addAndMakeVisible(lengthSlider);
+    addAndMakeVisible(bars);
+    updateBars();
+}
+
+void GrooveEditor::refresh()
+{
+    if (stepPatterns.getGroove(voiceBox.getSelectedId() - 1).length != bars.getNumSteps())
+    {
+        updateBars();
+    }
+}
+
+void GrooveEditor::resized()
+{
+    auto bounds = getLocalBounds().reduced(5);
+    auto controls = bounds.removeFromLeft(120);
+    voiceBox.setBounds(controls.removeFromTop(25));
+    controls.removeFromTop(5);
+    laneBox.setBounds(controls.removeFromTop(25));
+    controls.removeFromTop(5);
+    lengthSlider.setBounds(controls.removeFromTop(25));
+    bounds.removeFromLeft(5);
+    bars.setBounds(bounds);
+}
+
+float GrooveEditor::getGrooveValue(int step) const
+{
+    const auto& groove = stepPatterns.getGroove(voiceBox.getSelectedId() - 1);
+    if (laneBox.getSelectedId() == 2)
+    {
+        return groove.velocity[(size_t)step];
+    }
+    return groove.timing[(size_t)step] / GrooveTemplate::maxTiming;
+}
+
+void GrooveEditor::setGrooveValue(int step, float value)
+{
+    const int voice = voiceBox.getSelectedId() - 1;
+    if (laneBox.getSelectedId() == 2)
+    {
+        stepPatterns.setGrooveVelocity(voice, step, value);
+    }
+    else
+    {
+        stepPatterns.setGrooveTiming(voice, step, value * GrooveTemplate::maxTiming);
+    }
+}
+
+void GrooveEditor::updateBars()
+{
+    const int length = stepPatterns.getGroove(voiceBox.getSelectedId() - 1).length;
+    lengthSlider.setValue(length, juce::dontSendNotification);
+    bars.setNumSteps(length);
+    bars.repaint();
+}
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    StepLaneEditor.h
+    Created: 21 Oct 2026 9:02:37am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "StepPattern.h"
+
+//one bar per step, dragged up or down to set the step's value between 0 and 1
+//it only draws and edits through getValue and onValueChanged, so the same bars serve every lane and groove
+class LaneBars : public juce::Component
+{
+public:
+    //message thread, what each bar shows and where an edit goes
+    std::function<float(int step)> getValue;
+    std::function<void(int step, float value)> onValueChanged;
+
+    //does nothing when it hasn't changed, so it can be called every frame
+    void setNumSteps(int _numSteps);
+    int getNumSteps() const { return numSteps; }
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& event) override;
+    void mouseDrag(const juce::MouseEvent& event) override;
+
+private:
+    void setFromMouse(juce::Point<int> position);
+
+    int numSteps = 1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LaneBars)
+};
+
+//the velocity, accent and probability lanes of either voice (see StepLanes), for as many steps as the voice is playing
+//shown in every mode, Default mode's beats and subdivisions play by the lanes too
+class StepLaneEditor : public juce::Component
+{
+public:
+    StepLaneEditor(StepPatternStore& _stepPatterns);
+
+    //the engines' applied lengths of both voices, does nothing when they haven't changed
+    void setLengths(int length1, int length2);
+
+    void resized() override;
+
+private:
+    float getLaneValue(int step) const;
+    void setLaneValue(int step, float value);
+    void updateBars();
+
+    StepPatternStore& stepPatterns;
+    std::array<int, 2> lengths{ 1, 1 };
+    juce::ComboBox voiceBox; //item ids are the voice + 1
+    juce::ComboBox laneBox; //1 velocity, 2 accent, 3 probability
+    LaneBars bars;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StepLaneEditor)
+};
+
+//the groove template of either voice (see GrooveTemplate), its timing or velocity for every step of the template and how many steps it repeats after
+class GrooveEditor : public juce::Component
+{
+public:
+    GrooveEditor(StepPatternStore& _stepPatterns);
+
+    //message thread, picks up a length the store got from somewhere else (a preset or a restored session), cheap enough for every frame
+    void refresh();
+
+    void resized() override;
+
+private:
+    float getGrooveValue(int step) const;
+    void setGrooveValue(int step, float value);
+    void updateBars();
+
+    StepPatternStore& stepPatterns;
+    juce::ComboBox voiceBox; //item ids are the voice + 1
+    juce::ComboBox laneBox; //1 timing, 2 velocity
+    juce::Slider lengthSlider{ juce::Slider::IncDecButtons, juce::Slider::TextBoxLeft };
+    LaneBars bars;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GrooveEditor)
+};
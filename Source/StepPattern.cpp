@@ -0,0 +1,231 @@
+/*
+  ==============================================================================
+
+    StepPattern.cpp
+    Created: 19 Oct 2026 4:08:33pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "StepPattern.h"
+
+//state properties holding each voice's pattern and lanes
+static const char* const patternIds[] = { "RHYTHM1_PATTERN", "RHYTHM2_PATTERN" };
+static const char* const velocityIds[] = { "RHYTHM1_VELOCITY", "RHYTHM2_VELOCITY" };
+static const char* const accentIds[] = { "RHYTHM1_ACCENT", "RHYTHM2_ACCENT" };
+static const char* const probabilityIds[] = { "RHYTHM1_PROBABILITY", "RHYTHM2_PROBABILITY" };
+static const char* const grooveLengthIds[] = { "RHYTHM1_GROOVE_LENGTH", "RHYTHM2_GROOVE_LENGTH" };
+static const char* const grooveTimingIds[] = { "RHYTHM1_GROOVE_TIMING", "RHYTHM2_GROOVE_TIMING" };
+static const char* const grooveVelocityIds[] = { "RHYTHM1_GROOVE_VELOCITY", "RHYTHM2_GROOVE_VELOCITY" };
+
+//lanes are kept in the state as base64 float arrays
+static juce::String laneToString(const std::array<float, MAX_STEPS>& lane)
+{
+    return juce::MemoryBlock(lane.data(), sizeof(float) * lane.size()).toBase64Encoding();
+}
+
+static void laneFromString(std::array<float, MAX_STEPS>& lane, const juce::var& text)
+{
+    juce::MemoryBlock block;
+    if (text.isString() && block.fromBase64Encoding(text.toString()) && block.getSize() == sizeof(float) * lane.size())
+    {
+        block.copyTo(lane.data(), 0, block.getSize());
+    }
+}
+
+void StepPattern::setStep(int step, bool isOn)
+{
+    const juce::uint64 mask = (juce::uint64)1 << (step & 63);
+    if (isOn)
+    {
+        words[(size_t)(step >> 6)] |= mask;
+    }
+    else
+    {
+        words[(size_t)(step >> 6)] &= ~mask;
+    }
+}
+
+void StepPattern::setAll(bool isOn)
+{
+    words.fill(isOn ? ~(juce::uint64)0 : (juce::uint64)0);
+}
+
+juce::String StepPattern::toString() const
+{
+    juce::String text;
+    for (auto word : words)
+    {
+        text << juce::String::toHexString((juce::int64)word).paddedLeft('0', 16);
+    }
+    return text;
+}
+
+StepPattern StepPattern::fromString(const juce::String& text)
+{
+    StepPattern pattern;
+    for (int i = 0; i < numWords; i++)
+    {
+        pattern.words[(size_t)i] = (juce::uint64)text.substring(i * 16, (i + 1) * 16).getHexValue64();
+    }
+    return pattern;
+}
+
+
+StepLanes::StepLanes()
+{
+    velocity.fill(1.0f);
+    accent.fill(0.0f);
+    probability.fill(1.0f);
+}
+
+
+GrooveTemplate::GrooveTemplate()
+{
+    timing.fill(0.0f);
+    velocity.fill(1.0f);
+}
+
+
+StepPatternStore::StepPatternStore(juce::AudioProcessorValueTreeState& _apvts) : apvts(_apvts)
+{
+    loadFromState();
+}
+
+void StepPatternStore::toggleStep(int voice, int step)
+{
+    auto& pattern = patterns.voices[(size_t)voice];
+    pattern.setStep(step, !pattern.isStepOn(step));
+    apvts.state.setProperty(patternIds[voice], pattern.toString(), nullptr);
+    publish();
+}
+
+void StepPatternStore::setVelocity(int voice, int step, float velocity)
+{
+    patterns.lanes[(size_t)voice].velocity[(size_t)step] = juce::jlimit(0.0f, 1.0f, velocity);
+    apvts.state.setProperty(velocityIds[voice], laneToString(patterns.lanes[(size_t)voice].velocity), nullptr);
+    publish();
+}
+
+void StepPatternStore::setAccent(int voice, int step, float accent)
+{
+    patterns.lanes[(size_t)voice].accent[(size_t)step] = juce::jlimit(0.0f, 1.0f, accent);
+    apvts.state.setProperty(accentIds[voice], laneToString(patterns.lanes[(size_t)voice].accent), nullptr);
+    publish();
+}
+
+void StepPatternStore::setProbability(int voice, int step, float probability)
+{
+    patterns.lanes[(size_t)voice].probability[(size_t)step] = juce::jlimit(0.0f, 1.0f, probability);
+    apvts.state.setProperty(probabilityIds[voice], laneToString(patterns.lanes[(size_t)voice].probability), nullptr);
+    publish();
+}
+
+void StepPatternStore::setGrooveLength(int voice, int length)
+{
+    patterns.grooves[(size_t)voice].length = juce::jlimit(1, MAX_STEPS, length);
+    patterns.grooveVersion++;
+    apvts.state.setProperty(grooveLengthIds[voice], patterns.grooves[(size_t)voice].length, nullptr);
+    publish();
+}
+
+void StepPatternStore::setGrooveTiming(int voice, int step, float timing)
+{
+    patterns.grooves[(size_t)voice].timing[(size_t)step] = juce::jlimit(0.0f, GrooveTemplate::maxTiming, timing);
+    patterns.grooveVersion++;
+    apvts.state.setProperty(grooveTimingIds[voice], laneToString(patterns.grooves[(size_t)voice].timing), nullptr);
+    publish();
+}
+
+void StepPatternStore::setGrooveVelocity(int voice, int step, float velocity)
+{
+    patterns.grooves[(size_t)voice].velocity[(size_t)step] = juce::jlimit(0.0f, 1.0f, velocity);
+    patterns.grooveVersion++;
+    apvts.state.setProperty(grooveVelocityIds[voice], laneToString(patterns.grooves[(size_t)voice].velocity), nullptr);
+    publish();
+}
+
+juce::ValueTree StepPatternStore::getBeatTree(int beat) const
+{
+    return apvts.state.getChildWithName("TUPLETS").getChildWithProperty("beat", beat).createCopy();
+}
+
+void StepPatternStore::setBeatTree(int beat, const juce::ValueTree& tree)
+{
+    //the trees live in the state as they are, only the compiled events are published
+    auto tuplets = apvts.state.getOrCreateChildWithName("TUPLETS", nullptr);
+    tuplets.removeChild(tuplets.getChildWithProperty("beat", beat), nullptr);
+    if (tree.isValid() && juce::isPositiveAndBelow(beat, MAX_LENGTH))
+    {
+        juce::ValueTree beatTree("BEAT");
+        beatTree.copyPropertiesAndChildrenFrom(tree, nullptr);
+        beatTree.setProperty("beat", beat, nullptr);
+        tuplets.appendChild(beatTree, nullptr);
+    }
+    compileTuplets();
+    publish();
+}
+
+void StepPatternStore::compileTuplets()
+{
+    const auto version = patterns.tuplets.version + 1;
+    patterns.tuplets = TupletPattern::compile(apvts.state.getChildWithName("TUPLETS"));
+    patterns.tuplets.version = version;
+}
+
+void StepPatternStore::loadFromState()
+{
+    //sessions and presets without a pattern start with every step on, like the old per step params did
+    for (size_t voice = 0; voice < patterns.voices.size(); voice++)
+    {
+        auto text = apvts.state.getProperty(patternIds[voice]).toString();
+        if (text.length() == StepPattern::numWords * 16)
+        {
+            patterns.voices[voice] = StepPattern::fromString(text);
+        }
+        else
+        {
+            patterns.voices[voice].setAll(true);
+        }
+
+        //lanes missing from the state keep their defaults
+        patterns.lanes[voice] = StepLanes();
+        laneFromString(patterns.lanes[voice].velocity, apvts.state.getProperty(velocityIds[voice]));
+        laneFromString(patterns.lanes[voice].accent, apvts.state.getProperty(accentIds[voice]));
+        laneFromString(patterns.lanes[voice].probability, apvts.state.getProperty(probabilityIds[voice]));
+
+        //so is a groove, the default one is straight
+        patterns.grooves[voice] = GrooveTemplate();
+        patterns.grooves[voice].length = juce::jlimit(1, MAX_STEPS, (int)apvts.state.getProperty(grooveLengthIds[voice], 1));
+        laneFromString(patterns.grooves[voice].timing, apvts.state.getProperty(grooveTimingIds[voice]));
+        laneFromString(patterns.grooves[voice].velocity, apvts.state.getProperty(grooveVelocityIds[voice]));
+    }
+    patterns.grooveVersion++;
+    compileTuplets();
+    publish();
+}
+
+void StepPatternStore::writeTo(juce::ValueTree& state) const
+{
+    for (size_t voice = 0; voice < patterns.voices.size(); voice++)
+    {
+        state.setProperty(patternIds[voice], patterns.voices[voice].toString(), nullptr);
+        state.setProperty(velocityIds[voice], laneToString(patterns.lanes[voice].velocity), nullptr);
+        state.setProperty(accentIds[voice], laneToString(patterns.lanes[voice].accent), nullptr);
+        state.setProperty(probabilityIds[voice], laneToString(patterns.lanes[voice].probability), nullptr);
+        state.setProperty(grooveLengthIds[voice], patterns.grooves[voice].length, nullptr);
+        state.setProperty(grooveTimingIds[voice], laneToString(patterns.grooves[voice].timing), nullptr);
+        state.setProperty(grooveVelocityIds[voice], laneToString(patterns.grooves[voice].velocity), nullptr);
+    }
+}
+
+void StepPatternStore::publish()
+{
+    //the edits have already written the one property they changed, the audio thread gets the whole set
+    exchange.publish(patterns);
+    if (onChange)
+    {
+        onChange();
+    }
+}
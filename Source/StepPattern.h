@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    StepPattern.h
+    Created: 19 Oct 2026 4:08:33pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Utilities.h"
+#include "TupletPattern.h"
+
+//on/off state of every step of one voice packed into bits, step i is bit (i % 64) of word (i / 64)
+//so the audio thread can test a step with a single word load and mask
+struct StepPattern
+{
+    static constexpr int numWords = MAX_STEPS / 64;
+
+    bool isStepOn(int step) const { return ((words[(size_t)(step >> 6)] >> (step & 63)) & 1) != 0; }
+    void setStep(int step, bool isOn);
+    void setAll(bool isOn);
+
+    //hex words, used to keep the pattern in the apvts state
+    juce::String toString() const;
+    static StepPattern fromString(const juce::String& text);
+
+    std::array<juce::uint64, numWords> words{};
+};
+
+//per step velocity, accent and probability of one voice, each lane is a contiguous array indexed by step
+//so the engines read them with the same index they already use for the step bits
+struct StepLanes
+{
+    StepLanes();
+
+    //level a step that is on plays at, 0 when it loses its probability roll
+    float getLevel(int step, float randomValue) const
+    {
+        if (randomValue >= probability[(size_t)step])
+        {
+            return 0.0f;
+        }
+        //the accent raises the velocity towards full level
+        return velocity[(size_t)step] + accent[(size_t)step] * (1.0f - velocity[(size_t)step]);
+    }
+
+    std::array<float, MAX_STEPS> velocity; //0 to 1, drives click gain and MIDI velocity
+    std::array<float, MAX_STEPS> accent; //0 to 1
+    std::array<float, MAX_STEPS> probability; //0 to 1, chance the step triggers
+};
+
+//a voice's groove, timing pushes each step late by a fraction of a step (SWING is added on top) and velocity scales its level
+//it repeats every length steps, counted from the start of the voice's cycle, so a short template fits any pattern length
+//timing is late only: the engines find a step when its grid position comes up, a step can't be played before that
+struct GrooveTemplate
+{
+    static constexpr float maxTiming = 0.5f;
+
+    GrooveTemplate();
+
+    int length = 1;
+    std::array<float, MAX_STEPS> timing; //0 to maxTiming, fraction of a step
+    std::array<float, MAX_STEPS> velocity; //0 to 1, multiplies the step's level
+};
+
+//patterns of both voices, index 0 is rhythm1 (NUMERATOR, beats in Default mode) and 1 is rhythm2 (SUBDIVISION, subdivisions of a beat in Default mode)
+struct StepPatterns
+{
+    std::array<StepPattern, 2> voices;
+    std::array<StepLanes, 2> lanes;
+    std::array<GrooveTemplate, 2> grooves;
+    juce::uint32 grooveVersion = 0; //changes with every groove edit, so the engines only rebuild their groove tables when it moves
+    TupletPattern tuplets; //Default mode only, compiled from the trees in the state
+};
+
+//deterministic random value in [0, 1) for a step of a given bar, used for the probability lane
+//the same bar always rolls the same numbers, so offline renders come out identical every time
+inline float getStepRandom(juce::uint32 bar, int voice, int step)
+{
+    //splitmix64 finalizer over the bar, voice and step
+    juce::uint64 x = ((juce::uint64)bar << 32) ^ ((juce::uint64)voice << 16) ^ (juce::uint64)step;
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return (float)(x >> 40) / (float)(1 << 24);
+}
+
+using StepPatternExchange = TripleBuffer<StepPatterns>;
+
+//owns the patterns and lanes instead of one AudioParameterBool per step, so the host only sees a couple of macro params (RHYTHM<1,2>_ROTATE)
+//the editable copy lives on the message thread and is kept in the apvts state so it's saved with the session and presets,
+//every edit is published whole to the audio thread, which picks it up at the start of the next block
+class StepPatternStore
+{
+public:
+    StepPatternStore(juce::AudioProcessorValueTreeState& _apvts);
+
+    //message thread only
+    const StepPatterns& getPatterns() const { return patterns; }
+    bool isStepOn(int voice, int step) const { return patterns.voices[(size_t)voice].isStepOn(step); }
+    void toggleStep(int voice, int step);
+    const StepLanes& getLanes(int voice) const { return patterns.lanes[(size_t)voice]; }
+    void setVelocity(int voice, int step, float velocity);
+    void setAccent(int voice, int step, float accent);
+    void setProbability(int voice, int step, float probability);
+    const GrooveTemplate& getGroove(int voice) const { return patterns.grooves[(size_t)voice]; }
+    void setGrooveLength(int voice, int length);
+    void setGrooveTiming(int voice, int step, float timing);
+    void setGrooveVelocity(int voice, int step, float velocity);
+    //Default mode tuplet trees, see TupletPattern, getBeatTree returns a copy (invalid when the beat has none)
+    //and every edit goes back through setBeatTree so the compiled events stay in step, an invalid tree takes the beat's away
+    juce::ValueTree getBeatTree(int beat) const;
+    void setBeatTree(int beat, const juce::ValueTree& tree);
+    void loadFromState(); //call after the apvts state has been replaced
+    //an edit only writes the property it changed into the apvts state, this writes every one of them, for a state that's being saved
+    void writeTo(juce::ValueTree& state) const;
+
+    //the audio thread's side
+    StepPatternExchange& getExchange() { return exchange; }
+
+    //called after every edit and reload, on the thread that made it, the song's sections take their lanes, grooves and tuplets from here
+    std::function<void()> onChange;
+
+private:
+    void publish();
+    void compileTuplets();
+
+    juce::AudioProcessorValueTreeState& apvts;
+    StepPatterns patterns;
+    StepPatternExchange exchange;
+};
@@ -0,0 +1,271 @@
+/*
+  ==============================================================================
+
+    TempoFollower.cpp
+    Created: 19 Oct 2026 6:12:20pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "TempoFollower.h"
+
+namespace
+{
+    const double hopSeconds = 0.005; //onset strength resolution
+    const double combHalfLifeSeconds = 1.5; //how long a resonator remembers an onset, the same for every period
+    const double combEnergySeconds = 2.0; //smoothing of the resonator energies the tempo is picked from
+    const double preferredBpm = 120.0; //centre of the tempo prior
+    const float combConfidence = 1.3f; //the winning resonator's energy over the bank's mean before the tempo is trusted
+    const double retuneTolerance = 0.04; //a comb tempo this far from the grid's retunes the grid instead of nudging it
+    const double captureWindow = 0.2; //onsets within this fraction of a beat from the grid steer it, the rest are off beat notes
+    const double phaseGain = 0.25; //loop gains, fraction of an onset's timing error taken out of the phase and the period
+    const double periodGain = 0.02;
+    const int onsetsToLock = 4;
+    const int beatsToLoseLock = 8;
+}
+
+void TempoFollower::prepare(double _sampleRate, int maximumBlockSize)
+{
+    sampleRate = _sampleRate;
+    onsets.prepare(sampleRate, hopSeconds);
+    hopSize = onsets.getHopSize();
+    const double hopsPerSecond = sampleRate / hopSize;
+
+    minLag = (int)std::floor(60.0 / maxBpm * hopsPerSecond);
+    const int maxLag = (int)std::ceil(60.0 / minBpm * hopsPerSecond);
+    numCombs = maxLag - minLag + 1;
+
+    combOffsets.resize((size_t)numCombs);
+    combPositions.resize((size_t)numCombs);
+    combFeedback.resize((size_t)numCombs);
+    combEnergy.resize((size_t)numCombs);
+    combWeights.resize((size_t)numCombs);
+    int totalDelay = 0;
+    for (int comb = 0; comb < numCombs; comb++)
+    {
+        const int lag = minLag + comb;
+        combOffsets[(size_t)comb] = totalDelay;
+        totalDelay += lag;
+        combFeedback[(size_t)comb] = (float)std::pow(0.5, lag / (combHalfLifeSeconds * hopsPerSecond));
+        //a resonator also rings at multiples of the played period, the prior breaks those ties towards moderate tempos
+        const double octavesFromPreferred = std::log2(60.0 * hopsPerSecond / lag / preferredBpm);
+        combWeights[(size_t)comb] = (float)std::exp(-0.5 * octavesFromPreferred * octavesFromPreferred);
+    }
+    combDelays.resize((size_t)totalDelay);
+
+    energySmoothing = (float)std::exp(-1.0 / (combEnergySeconds * hopsPerSecond));
+
+    juce::ignoreUnused(maximumBlockSize);
+    reset();
+}
+
+void TempoFollower::reset()
+{
+    onsets.reset();
+
+    std::fill(combDelays.begin(), combDelays.end(), 0.0f);
+    std::fill(combPositions.begin(), combPositions.end(), 0);
+    std::fill(combEnergy.begin(), combEnergy.end(), 0.0f);
+    combPeriod = 0;
+
+    beatPeriod = 60.0 / preferredBpm * sampleRate;
+    samplesIntoBeat = 0;
+    beatCount = 0;
+    matchedOnsets = 0;
+    beatsSinceMatch = 0;
+    offTempoOnsets = 0;
+    locked = false;
+    blockStartBeatCount = 0;
+    blockStartBeatPhase = 0;
+}
+
+template <typename SampleType>
+void TempoFollower::process(const juce::AudioBuffer<SampleType>& input)
+{
+    //the grid only moves on hop boundaries, samples already gathered into the current hop are counted on top
+    double blockStartSamples = samplesIntoBeat + onsets.getHopPosition();
+    blockStartBeatCount = beatCount;
+    while (blockStartSamples >= beatPeriod)
+    {
+        blockStartSamples -= beatPeriod;
+        blockStartBeatCount++;
+    }
+    blockStartBeatPhase = blockStartSamples / beatPeriod;
+
+    const int numChannels = input.getNumChannels();
+    const int numSamples = input.getNumSamples();
+    const float channelGain = numChannels > 0 ? 1.0f / numChannels : 0.0f;
+    auto* const* channels = input.getArrayOfReadPointers();
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        float mono = 0;
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            mono += (float)channels[channel][i];
+        }
+        if (onsets.pushSample(mono * channelGain))
+        {
+            processHop();
+        }
+    }
+}
+
+template void TempoFollower::process<float>(const juce::AudioBuffer<float>&);
+template void TempoFollower::process<double>(const juce::AudioBuffer<double>&);
+
+void TempoFollower::processHop()
+{
+    //the resonators only see how far the onset strength rises above its running mean
+    const float combInput = juce::jmax(0.0f, onsets.getOnsetStrength() - onsets.getMeanStrength());
+
+    for (int comb = 0; comb < numCombs; comb++)
+    {
+        const int lag = minLag + comb;
+        auto& position = combPositions[(size_t)comb];
+        auto& delayed = combDelays[(size_t)(combOffsets[(size_t)comb] + position)];
+        const float feedback = combFeedback[(size_t)comb];
+        //the sample read here went in one period ago and is replaced by the new output
+        const float output = feedback * delayed + (1.0f - feedback) * combInput;
+        delayed = output;
+        position = position + 1 < lag ? position + 1 : 0;
+        combEnergy[(size_t)comb] = energySmoothing * combEnergy[(size_t)comb] + (1.0f - energySmoothing) * output * output;
+    }
+    updateTempo();
+
+    advanceGrid(hopSize);
+
+    if (onsets.isOnset())
+    {
+        steerPhase();
+    }
+}
+
+void TempoFollower::updateTempo()
+{
+    int bestComb = -1;
+    float bestScore = 0;
+    float totalScore = 0;
+    for (int comb = 0; comb < numCombs; comb++)
+    {
+        const float score = combEnergy[(size_t)comb] * combWeights[(size_t)comb];
+        totalScore += score;
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestComb = comb;
+        }
+    }
+
+    if (bestComb < 0 || bestScore < combConfidence * totalScore / numCombs)
+    {
+        combPeriod = 0;
+        return;
+    }
+
+    //parabolic interpolation between neighbouring resonators, a whole hop is too coarse at fast tempos
+    double lag = minLag + bestComb;
+    if (bestComb > 0 && bestComb < numCombs - 1)
+    {
+        const float left = combEnergy[(size_t)bestComb - 1] * combWeights[(size_t)bestComb - 1];
+        const float right = combEnergy[(size_t)bestComb + 1] * combWeights[(size_t)bestComb + 1];
+        const float curvature = left - 2.0f * bestScore + right;
+        if (curvature < 0)
+        {
+            lag += 0.5 * (left - right) / curvature;
+        }
+    }
+    combPeriod = lag * hopSize;
+    bestCombIndex = bestComb;
+}
+
+double TempoFollower::getCombPhase() const
+{
+    //the winning resonator's delay line holds its last period of output, the onsets that repeat at its period pile up in one place,
+    //how many hops ago that was is how far into the beat the grid is
+    const int lag = minLag + bestCombIndex;
+    const int offset = combOffsets[(size_t)bestCombIndex];
+    const int newest = combPositions[(size_t)bestCombIndex] + lag - 1;
+    int hopsSinceBeat = 0;
+    float peak = -1;
+    for (int hopsAgo = 0; hopsAgo < lag; hopsAgo++)
+    {
+        const float value = combDelays[(size_t)(offset + (newest - hopsAgo) % lag)];
+        if (value > peak)
+        {
+            peak = value;
+            hopsSinceBeat = hopsAgo;
+        }
+    }
+    //an onset strength value belongs to the middle of its hop
+    return std::fmod((hopsSinceBeat + 0.5) * hopSize, beatPeriod);
+}
+
+void TempoFollower::steerPhase()
+{
+    if (combPeriod <= 0)
+    {
+        return;
+    }
+
+    //the grid has just moved to the end of the hop after the onset
+    const double onsetOffset = onsets.getOnsetDelay();
+
+    //while locked the resonators have to disagree with the grid for a few onsets in a row, so a fill doesn't throw the lock
+    const bool isOffTempo = std::abs(beatPeriod - combPeriod) > retuneTolerance * combPeriod;
+    offTempoOnsets = isOffTempo ? offTempoOnsets + 1 : 0;
+    if (isOffTempo && (!locked || offTempoOnsets >= onsetsToLock))
+    {
+        //new tempo (or the first one), take the beat from the resonator and lock again from scratch
+        beatPeriod = combPeriod;
+        samplesIntoBeat = getCombPhase();
+        matchedOnsets = 0;
+        beatsSinceMatch = 0;
+        offTempoOnsets = 0;
+        locked = false;
+        return;
+    }
+
+    //timing of the onset against the nearest beat, positive when the player is late
+    double error = samplesIntoBeat - onsetOffset;
+    error -= beatPeriod * std::floor(error / beatPeriod + 0.5);
+    if (std::abs(error) > captureWindow * beatPeriod)
+    {
+        if (!locked)
+        {
+            //still looking for the beat, with nothing matched yet the grid is put back on the resonator's beat
+            if (matchedOnsets == 0)
+            {
+                samplesIntoBeat = getCombPhase();
+            }
+        }
+        return;
+    }
+
+    //the phase is never pushed back over a beat, the engines would play that beat twice
+    samplesIntoBeat = juce::jlimit(0.0, beatPeriod - 1.0, samplesIntoBeat - phaseGain * error);
+    beatPeriod = juce::jlimit(combPeriod * (1.0 - retuneTolerance), combPeriod * (1.0 + retuneTolerance), beatPeriod + periodGain * error);
+
+    beatsSinceMatch = 0;
+    if (++matchedOnsets >= onsetsToLock)
+    {
+        locked = true;
+    }
+}
+
+void TempoFollower::advanceGrid(int numSamples)
+{
+    samplesIntoBeat += numSamples;
+    while (samplesIntoBeat >= beatPeriod)
+    {
+        samplesIntoBeat -= beatPeriod;
+        beatCount++;
+        if (++beatsSinceMatch > beatsToLoseLock)
+        {
+            //the player stopped or went somewhere the grid can't follow, the engines go back to their own clock
+            locked = false;
+            matchedOnsets = 0;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    TempoFollower.h
+    Created: 19 Oct 2026 6:12:20pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "OnsetDetector.h"
+
+//tracks the tempo and beat phase of the sidechain input (a live drummer) so the click can follow it
+//the input is cut into 5ms hops by an OnsetDetector, a bank of comb filter resonators over its onset strength estimates the tempo
+//and a phase locked loop keeps the beat grid on the played onsets
+//the grid is predicted ahead, so following adds no latency to the click, an onset only steers the grid one hop after it's heard
+//the work per block is fixed: 4 biquads per input sample and one pass over the comb bank per hop, nothing is allocated after prepare
+class TempoFollower
+{
+public:
+    static constexpr double minBpm = 60.0;
+    static constexpr double maxBpm = 200.0;
+
+    TempoFollower() = default;
+
+    //allocates the comb bank, call while audio is stopped
+    void prepare(double _sampleRate, int maximumBlockSize);
+    void reset();
+
+    //audio thread, analyses one block of input, the estimates below describe the position at the start of this block
+    //instantiated for float and double input in the .cpp
+    template <typename SampleType>
+    void process(const juce::AudioBuffer<SampleType>& input);
+
+    //true once the comb bank has a clear winner and played onsets have landed on the grid
+    bool isLocked() const { return locked; }
+    double getBpm() const { return 60.0 * sampleRate / beatPeriod; }
+    //beats completed and how far into the current beat (0 to 1) the start of the last processed block was
+    juce::int64 getBeatCount() const { return blockStartBeatCount; }
+    double getBeatPhase() const { return blockStartBeatPhase; }
+
+private:
+    void processHop();
+    void updateTempo();
+    double getCombPhase() const;
+    void steerPhase();
+    void advanceGrid(int numSamples);
+
+    double sampleRate = 44100;
+    int hopSize = 256; //samples per onset strength value
+
+    OnsetDetector onsets;
+
+    //comb filter bank, one resonator per beat period (in hops) from maxBpm to minBpm
+    //each resonator feeds its output back one period later, so it rings when onsets repeat at its period
+    int minLag = 0;
+    int numCombs = 0;
+    std::vector<float> combDelays; //every resonator's delay line, laid out back to back
+    std::vector<int> combOffsets; //start of each resonator's delay line in combDelays
+    std::vector<int> combPositions; //read/write position in each delay line
+    std::vector<float> combFeedback; //per lag feedback so every resonator decays over the same time
+    std::vector<float> combEnergy; //smoothed output energy of each resonator
+    std::vector<float> combWeights; //prefers periods near 120bpm, keeps the bank off double and half time
+    float energySmoothing = 0;
+    double combPeriod = 0; //winning period in samples, 0 until the bank has a clear winner
+    int bestCombIndex = 0;
+
+    //beat grid steered by the phase locked loop, in samples
+    double beatPeriod = 22050;
+    double samplesIntoBeat = 0;
+    juce::int64 beatCount = 0;
+    int matchedOnsets = 0; //onsets that landed near the grid since the last (re)lock
+    int beatsSinceMatch = 0; //the lock is dropped once the player has been quiet or off the grid for too long
+    int offTempoOnsets = 0; //onsets in a row where the comb bank disagreed with the grid's tempo
+    bool locked = false;
+
+    juce::int64 blockStartBeatCount = 0;
+    double blockStartBeatPhase = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TempoFollower)
+};
@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    ThreadRings.h
+    Created: 22 Oct 2026 5:37:12pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//a thread's items on their way to a writer thread, the thread is the only writer and the writer thread the only reader
+//it's preallocated, a full ring drops the item and counts it rather than wait
+template <typename Item, int ringCapacity>
+class ThreadRing
+{
+public:
+    static constexpr int capacity = ringCapacity;
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "the capacity has to be a power of two");
+
+    void push(const Item& item) noexcept
+    {
+        const auto write = writePosition.load(std::memory_order_relaxed);
+        if (write - readPosition.load(std::memory_order_acquire) >= (juce::uint64)capacity)
+        {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        items[(size_t)(write & (capacity - 1))] = item;
+        writePosition.store(write + 1, std::memory_order_release);
+    }
+
+    //the reader only
+    template <typename Callback>
+    void drain(Callback&& callback)
+    {
+        const auto read = readPosition.load(std::memory_order_relaxed);
+        const auto write = writePosition.load(std::memory_order_acquire);
+        for (auto position = read; position != write; position++)
+        {
+            callback(items[(size_t)(position & (capacity - 1))]);
+        }
+        readPosition.store(write, std::memory_order_release);
+    }
+
+    //counts on across the threads the ring is handed to
+    juce::uint32 getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::array<Item, capacity> items;
+    std::atomic<juce::uint64> writePosition{ 0 };
+    std::atomic<juce::uint64> readPosition{ 0 };
+    std::atomic<juce::uint32> dropped{ 0 };
+};
+
+//a fixed set of ThreadRings shared by every instance of the plugin in the process, each thread that writes gets one of its own
+//the first write claims a free ring with a compare and swap, without allocating, locking or asking JUCE for the thread's name,
+//so it's safe on a host's audio thread, the reader names the thread from the id it leaves
+//a thread gives its ring back when it exits, the reader empties it before another thread can claim it,
+//so only maxThreads threads writing at the same time run out, the ones after that write nothing
+template <typename Item, int ringCapacity, int maxThreads = 32>
+class ThreadRings
+{
+public:
+    using Ring = ThreadRing<Item, ringCapacity>;
+    static constexpr int numRings = maxThreads;
+
+    //who holds a ring, generation moves with every claim so the reader can tell a new thread from the last one
+    struct Owner
+    {
+        juce::Thread::ThreadID threadId = nullptr;
+        bool isMessageThread = false;
+        juce::uint32 generation = 0;
+    };
+
+    //the calling thread's ring, nullptr when every ring was held by a live thread the first time it wrote
+    static Ring* getForThisThread() noexcept
+    {
+        thread_local Claim claim;
+        return claim.slot != nullptr ? &claim.slot->ring : nullptr;
+    }
+
+    //the reader only, visit(index, owner, ring) is called for every ring a thread holds or has given back and has to drain it,
+    //a ring that was given back is free to be claimed again once visit returns
+    template <typename Visit>
+    static void forEachRing(Visit&& visit)
+    {
+        for (int index = 0; index < maxThreads; index++)
+        {
+            auto& slot = slots[(size_t)index];
+            const auto state = slot.state.load(std::memory_order_acquire);
+            if (state != claimed && state != released)
+            {
+                continue;
+            }
+            visit(index, slot.owner, slot.ring);
+            if (state == released)
+            {
+                slot.state.store(free, std::memory_order_release);
+            }
+        }
+    }
+
+    //the reader only, a name for a thread from what its claim recorded
+    static juce::String getThreadName(const Owner& owner)
+    {
+        if (owner.isMessageThread)
+        {
+            return "message thread";
+        }
+        return "thread " + juce::String::toHexString((juce::pointer_sized_int)owner.threadId);
+    }
+
+private:
+    enum State : int
+    {
+        free,
+        claiming, //the claiming thread is writing the owner
+        claimed,
+        released //the thread exited, its last items are still to be read
+    };
+
+    struct Slot
+    {
+        std::atomic<int> state{ free };
+        Owner owner; //written while claiming, read by the reader while claimed or released
+        Ring ring;
+    };
+
+    //lives as long as the thread, so the ring is given back when the thread exits
+    struct Claim
+    {
+        Claim() noexcept
+        {
+            for (auto& candidate : slots)
+            {
+                int expected = free;
+                if (candidate.state.compare_exchange_strong(expected, claiming, std::memory_order_acquire))
+                {
+                    candidate.owner.threadId = juce::Thread::getCurrentThreadId();
+                    candidate.owner.isMessageThread = juce::MessageManager::existsAndIsCurrentThread();
+                    candidate.owner.generation++;
+                    candidate.state.store(claimed, std::memory_order_release);
+                    slot = &candidate;
+                    return;
+                }
+            }
+        }
+
+        ~Claim()
+        {
+            if (slot != nullptr)
+            {
+                slot->state.store(released, std::memory_order_release);
+            }
+        }
+
+        Slot* slot = nullptr;
+    };
+
+    inline static std::array<Slot, maxThreads> slots;
+};
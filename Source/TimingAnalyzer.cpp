@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    TimingAnalyzer.cpp
+    Created: 19 Oct 2026 7:58:41pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "TimingAnalyzer.h"
+
+namespace
+{
+    const double hopSeconds = 0.002; //finer than the tempo follower's, the onset time is only known to within a hop
+    const double matchWindowSeconds = 0.15; //a hit further than this from every click isn't scored
+    const int workerIntervalMs = 20;
+}
+
+void TimingStats::Accumulator::add(float deviationMs)
+{
+    count++;
+    const double delta = deviationMs - mean;
+    mean += delta / count;
+    sumOfSquares += delta * (deviationMs - mean);
+
+    const int bin = juce::roundToInt(deviationMs / binWidthMs) + numBins / 2;
+    histogram[(size_t)juce::jlimit(0, numBins - 1, bin)]++;
+}
+
+TimingAnalyzer::TimingAnalyzer(ScheduledClickQueue& _scheduledClicks)
+    : juce::Thread("MetroGnome timing analysis"), scheduledClicks(_scheduledClicks)
+{
+    inputChunks.resize(numChunks);
+}
+
+TimingAnalyzer::~TimingAnalyzer()
+{
+    stopThread(1000);
+}
+
+void TimingAnalyzer::prepare(double _sampleRate)
+{
+    stopThread(1000);
+
+    sampleRate = _sampleRate;
+    onsets.prepare(sampleRate, hopSeconds);
+    inputFifo.reset();
+    //prepareToPlay starts the sample count over, the worker is stopped so the queue's reader is too
+    scheduledClicks.reset();
+    nextInputSample = -1;
+    numRecentClicks = 0;
+    nextRecentClick = 0;
+    numPendingOnsets = 0;
+
+    startThread();
+}
+
+template <typename SampleType>
+void TimingAnalyzer::pushInput(const juce::AudioBuffer<SampleType>& input, juce::int64 blockStart)
+{
+    const int numChannels = input.getNumChannels();
+    const int numSamples = input.getNumSamples();
+    const float channelGain = numChannels > 0 ? 1.0f / numChannels : 0.0f;
+
+    for (int position = 0; position < numSamples; position += chunkSize)
+    {
+        int start1, size1, start2, size2;
+        inputFifo.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 == 0)
+        {
+            return;
+        }
+
+        auto& chunk = inputChunks[(size_t)start1];
+        chunk.startSample = blockStart + position;
+        chunk.numSamples = juce::jmin(chunkSize, numSamples - position);
+        std::fill(chunk.samples.begin(), chunk.samples.begin() + chunk.numSamples, 0.0f);
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            //the chunks are always float, the onset detector doesn't need more
+            const SampleType* source = input.getReadPointer(channel, position);
+            for (int sample = 0; sample < chunk.numSamples; sample++)
+            {
+                chunk.samples[(size_t)sample] += (float)source[sample] * channelGain;
+            }
+        }
+        inputFifo.finishedWrite(1);
+    }
+}
+
+template void TimingAnalyzer::pushInput<float>(const juce::AudioBuffer<float>&, juce::int64);
+template void TimingAnalyzer::pushInput<double>(const juce::AudioBuffer<double>&, juce::int64);
+
+void TimingAnalyzer::run()
+{
+    while (!threadShouldExit())
+    {
+        if (resetRequested.exchange(false))
+        {
+            workingStats = TimingStats();
+            haveStatsChanged = true;
+        }
+
+        readClicks();
+        readInput();
+        matchOnsets();
+
+        if (haveStatsChanged)
+        {
+            stats.publish(workingStats);
+            haveStatsChanged = false;
+        }
+        wait(workerIntervalMs);
+    }
+}
+
+void TimingAnalyzer::readClicks()
+{
+    std::array<ScheduledClick, 64> clicks;
+    int numClicks;
+    while ((numClicks = scheduledClicks.pop(clicks.data(), (int)clicks.size())) > 0)
+    {
+        for (int i = 0; i < numClicks; i++)
+        {
+            recentClicks[(size_t)nextRecentClick] = clicks[(size_t)i];
+            nextRecentClick = (nextRecentClick + 1) % maxRecentClicks;
+            numRecentClicks = juce::jmin(numRecentClicks + 1, maxRecentClicks);
+        }
+    }
+}
+
+void TimingAnalyzer::readInput()
+{
+    const int latency = roundTripLatency.load(std::memory_order_relaxed);
+
+    int start1, size1, start2, size2;
+    inputFifo.prepareToRead(inputFifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1 + size2; i++)
+    {
+        const auto& chunk = inputChunks[(size_t)(i < size1 ? start1 + i : start2 + i - size1)];
+        if (chunk.startSample != nextInputSample)
+        {
+            //first input, or the ring was full and some was dropped, the detector's history no longer lines up
+            onsets.reset();
+        }
+        nextInputSample = chunk.startSample + chunk.numSamples;
+
+        for (int sample = 0; sample < chunk.numSamples; sample++)
+        {
+            if (onsets.pushSample(chunk.samples[(size_t)sample]) && onsets.isOnset() && numPendingOnsets < maxPendingOnsets)
+            {
+                //the hop ended after this sample, the hit was heard one round trip after the click it answers
+                const double onsetTime = (double)(chunk.startSample + sample + 1) - onsets.getOnsetDelay();
+                pendingOnsets[(size_t)numPendingOnsets++] = (juce::int64)onsetTime - latency;
+            }
+        }
+    }
+    inputFifo.finishedRead(size1 + size2);
+}
+
+void TimingAnalyzer::matchOnsets()
+{
+    const juce::int64 scheduledUntil = scheduledClicks.getScheduledUntil();
+    const auto matchWindow = (juce::int64)(matchWindowSeconds * sampleRate);
+
+    int numWaiting = 0;
+    for (int i = 0; i < numPendingOnsets; i++)
+    {
+        const juce::int64 onsetTime = pendingOnsets[(size_t)i];
+        if (onsetTime + matchWindow > scheduledUntil)
+        {
+            //a click the player hit early may not have been scheduled yet
+            pendingOnsets[(size_t)numWaiting++] = onsetTime;
+            continue;
+        }
+
+        const ScheduledClick* nearest = nullptr;
+        juce::int64 nearestDistance = matchWindow + 1;
+        for (int click = 0; click < numRecentClicks; click++)
+        {
+            const auto distance = std::abs(onsetTime - recentClicks[(size_t)click].samplePosition);
+            if (distance < nearestDistance)
+            {
+                nearestDistance = distance;
+                nearest = &recentClicks[(size_t)click];
+            }
+        }
+
+        if (nearest == nullptr)
+        {
+            workingStats.unmatchedHits++;
+        }
+        else
+        {
+            const float deviationMs = (float)((onsetTime - nearest->samplePosition) * 1000.0 / sampleRate);
+            workingStats.all.add(deviationMs);
+            workingStats.steps[(size_t)juce::jlimit(0, 1, nearest->voice)][(size_t)juce::jlimit(0, MAX_STEPS - 1, nearest->step)].add(deviationMs);
+            workingStats.lastDeviationMs = deviationMs;
+        }
+        haveStatsChanged = true;
+    }
+    numPendingOnsets = numWaiting;
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    TimingAnalyzer.h
+    Created: 19 Oct 2026 7:58:41pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Utilities.h"
+#include "OnsetDetector.h"
+#include "RhythmEngine.h"
+
+//how early or late the player's hits were against the click, everything is accumulated incrementally so the memory never grows
+struct TimingStats
+{
+    static constexpr int numBins = 21;
+    static constexpr float binWidthMs = 5.0f; //bins are centred from -50ms to +50ms, the outer ones also hold everything beyond
+
+    struct Accumulator
+    {
+        void add(float deviationMs);
+        float getStandardDeviation() const { return count > 1 ? (float)std::sqrt(sumOfSquares / (count - 1)) : 0.0f; }
+
+        int count = 0;
+        double mean = 0; //ms, negative is early
+        double sumOfSquares = 0; //of the differences from the mean (Welford)
+        std::array<int, numBins> histogram{};
+    };
+
+    Accumulator all;
+    std::array<std::array<Accumulator, MAX_STEPS>, 2> steps; //per voice and step of the click each hit was matched to
+    float lastDeviationMs = 0;
+    int unmatchedHits = 0; //hits with no click near enough to count
+};
+
+//scores the player against the click: onsets in the input are matched to the nearest click the engine scheduled
+//the audio thread only copies the input into a lock free ring of chunks, onset detection, matching and statistics all run on this worker thread
+//the input is compared after taking off the round trip latency, the time between a click leaving the plugin and the player's answer coming back in
+class TimingAnalyzer : private juce::Thread
+{
+public:
+    TimingAnalyzer(ScheduledClickQueue& _scheduledClicks);
+    ~TimingAnalyzer() override;
+
+    //message thread, while audio is stopped, (re)starts the worker
+    void prepare(double _sampleRate);
+
+    //audio thread, blockStart is the sample position of the block in the same count the clicks use
+    //instantiated for float and double input in the .cpp
+    template <typename SampleType>
+    void pushInput(const juce::AudioBuffer<SampleType>& input, juce::int64 blockStart);
+    void setRoundTripLatency(int samples) { roundTripLatency.store(samples, std::memory_order_relaxed); }
+
+    //any thread, the statistics start over on the worker's next pass
+    void requestReset() { resetRequested.store(true); }
+
+    //message thread only (the editor), the newest statistics the worker published
+    const TimingStats& getStats()
+    {
+        stats.acquire();
+        return stats.getActive();
+    }
+
+private:
+    void run() override;
+    void readClicks();
+    void readInput();
+    void matchOnsets();
+
+    static constexpr int chunkSize = 512;
+    static constexpr int numChunks = 256; //about 3 seconds of input at 44.1kHz
+    static constexpr int maxRecentClicks = 256;
+    static constexpr int maxPendingOnsets = 32;
+
+    struct InputChunk
+    {
+        juce::int64 startSample = 0;
+        int numSamples = 0;
+        std::array<float, chunkSize> samples; //mono
+    };
+
+    ScheduledClickQueue& scheduledClicks;
+    double sampleRate = 44100;
+    std::atomic<int> roundTripLatency{ 0 };
+    std::atomic<bool> resetRequested{ false };
+
+    //input ring, written by the audio thread, a full ring drops the rest of the block and the worker starts its detector over at the gap
+    juce::AbstractFifo inputFifo{ numChunks };
+    std::vector<InputChunk> inputChunks;
+
+    //worker thread only
+    OnsetDetector onsets;
+    juce::int64 nextInputSample = -1;
+    std::array<ScheduledClick, maxRecentClicks> recentClicks; //ring of the last clicks, oldest are overwritten
+    int numRecentClicks = 0;
+    int nextRecentClick = 0;
+    std::array<juce::int64, maxPendingOnsets> pendingOnsets; //onsets (latency taken off) waiting for the clicks around them to be scheduled
+    int numPendingOnsets = 0;
+    TimingStats workingStats;
+    bool haveStatsChanged = false;
+
+    //worker writes, editor reads
+    TripleBuffer<TimingStats> stats;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimingAnalyzer)
+};
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    Trace.cpp
+    Created: 20 Oct 2026 4:02:37am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "Trace.h"
+
+#if METROGNOME_TRACING
+
+TraceWriter::TraceWriter()
+    : juce::Thread("trace writer")
+{
+    file = juce::File::getSpecialLocation(juce::File::tempDirectory)
+        .getChildFile("MetroGnome-trace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json")
+        .getNonexistentSibling();
+    stream = std::make_unique<juce::FileOutputStream>(file);
+    if (stream->failedToOpen())
+    {
+        stream.reset();
+        return;
+    }
+    *stream << "[\n";
+
+    //the cycle counter's rate, measured against the high resolution clock
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    originClock = readTraceClock();
+    juce::Thread::sleep(50);
+    const auto elapsedMicroseconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+    clocksPerMicrosecond = juce::jmax(1.0e-9, (readTraceClock() - originClock) / elapsedMicroseconds);
+
+    startThread(juce::Thread::Priority::low);
+}
+
+TraceWriter::~TraceWriter()
+{
+    stopThread(1000);
+    if (stream != nullptr)
+    {
+        flush();
+        *stream << "\n]\n";
+        stream->flush();
+    }
+}
+
+void TraceWriter::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(200);
+        flush();
+    }
+}
+
+void TraceWriter::flush()
+{
+    auto separate = [this]
+    {
+        if (!isFirstEvent)
+        {
+            *stream << ",\n";
+        }
+        isFirstEvent = false;
+    };
+    TraceRings::forEachRing([&](int index, const TraceRings::Owner& owner, TraceRing& ring)
+    {
+        //a ring goes from thread to thread, the track is the thread's, named here rather than when the ring was claimed
+        const auto tid = juce::String((juce::int64)(juce::pointer_sized_int)owner.threadId);
+        if (namedGeneration[(size_t)index] != owner.generation)
+        {
+            separate();
+            *stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":" << TraceRings::getThreadName(owner).quoted() << "}}";
+            namedGeneration[(size_t)index] = owner.generation;
+        }
+        if (ring.getDropped() != lastDropped[(size_t)index])
+        {
+            //markers lost to a full ring show up as a counter on the thread's track
+            separate();
+            *stream << "{\"name\":\"dropped markers\",\"ph\":\"C\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << juce::String((readTraceClock() - originClock) / clocksPerMicrosecond, 3)
+                    << ",\"args\":{\"dropped\":" << (int)ring.getDropped() << "}}";
+            lastDropped[(size_t)index] = ring.getDropped();
+        }
+        ring.drain([&](const TraceEvent& event)
+        {
+            separate();
+            const double start = (event.start - originClock) / clocksPerMicrosecond;
+            const double duration = (event.end - event.start) / clocksPerMicrosecond;
+            *stream << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << juce::String(start, 3) << ",\"dur\":" << juce::String(duration, 3) << "}";
+        });
+    });
+    stream->flush();
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    Trace.h
+    Created: 20 Oct 2026 4:02:37am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ThreadRings.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//scoped timing markers for finding out what the plugin was doing around a glitch, written out as Chrome trace event JSON
+//(open it in chrome://tracing or ui.perfetto.dev)
+//off unless METROGNOME_TRACING=1 is added to the exporter's preprocessor definitions, TRACE_SCOPE then compiles to nothing,
+//with it on a marker is two clock reads and a store into the thread's own ring, with no locks, allocation or system calls
+#ifndef METROGNOME_TRACING
+ #define METROGNOME_TRACING 0
+#endif
+
+#if METROGNOME_TRACING
+
+//the clock markers are stamped with, the CPU's cycle counter where there is one, TraceWriter converts it to time
+inline juce::int64 readTraceClock() noexcept
+{
+#if JUCE_INTEL
+    return (juce::int64)__rdtsc();
+#else
+    return juce::Time::getHighResolutionTicks();
+#endif
+}
+
+//one finished scope, name has to be a string literal as only the pointer is kept
+struct TraceEvent
+{
+    const char* name = nullptr;
+    juce::int64 start = 0;
+    juce::int64 end = 0;
+};
+
+//every thread's markers on their way to the TraceWriter, a thread's ring is claimed the first time it hits a marker
+using TraceRings = ThreadRings<TraceEvent, 8192>;
+using TraceRing = TraceRings::Ring;
+
+//times the scope it lives in
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* _name) noexcept : name(_name), start(readTraceClock()) {}
+
+    ~TraceScope()
+    {
+        if (auto* ring = TraceRings::getForThisThread())
+        {
+            ring->push({ name, start, readTraceClock() });
+        }
+    }
+
+private:
+    const char* name;
+    juce::int64 start;
+
+    JUCE_DECLARE_NON_COPYABLE(TraceScope)
+};
+
+//empties every ring into a trace file in the temp directory a few times a second, one per process,
+//held through a juce::SharedResourcePointer by each instance of the plugin so the rings only ever have one reader
+class TraceWriter : private juce::Thread
+{
+public:
+    TraceWriter();
+    ~TraceWriter() override;
+
+    const juce::File& getFile() const { return file; }
+
+private:
+    void run() override;
+    void flush();
+
+    juce::File file;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::int64 originClock = 0;
+    double clocksPerMicrosecond = 1;
+    std::array<juce::uint32, TraceRings::numRings> namedGeneration{}; //the owner each ring's thread_name was written for
+    std::array<juce::uint32, TraceRings::numRings> lastDropped{};
+    bool isFirstEvent = true;
+};
+
+#define TRACE_SCOPE(name) TraceScope JUCE_JOIN_MACRO(traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name)
+
+#endif
@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    TupletEditor.cpp
+    Created: 22 Oct 2026 2:41:53pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "TupletEditor.h"
+
+TupletEditor::TupletEditor(StepPatternStore& _stepPatterns)
+    : stepPatterns(_stepPatterns)
+{
+    for (int beat = 0; beat < MAX_LENGTH; beat++)
+    {
+        beatBox.addItem("beat " + juce::String(beat + 1), beat + 1);
+    }
+    beatBox.setSelectedId(1, juce::dontSendNotification);
+    beatBox.onChange = [this] { loadTree(); };
+
+    notesSlider.setRange(2, 9, 1);
+    notesSlider.setValue(3, juce::dontSendNotification);
+    notesSlider.setTextValueSuffix(" notes");
+    splitButton.onClick = [this] { splitNode(); };
+    clearButton.onClick = [this]
+    {
+        tree = juce::ValueTree();
+        storeTree();
+    };
+
+    weightSlider.setRange(1, TupletPattern::maxWeight, 1);
+    weightSlider.setTextValueSuffix(" weight");
+    weightSlider.onValueChange = [this]
+    {
+        getNode(selected).setProperty("weight", (int)weightSlider.getValue(), nullptr);
+        storeTree();
+    };
+    velocitySlider.setRange(0.0, 1.0, 0.01);
+    velocitySlider.onValueChange = [this]
+    {
+        getNode(selected).setProperty("velocity", velocitySlider.getValue(), nullptr);
+        storeTree();
+    };
+    soundBox.addItem("high", 1);
+    soundBox.addItem("low", 2);
+    soundBox.addItem("sub", 3);
+    soundBox.onChange = [this]
+    {
+        getNode(selected).setProperty("sound", soundBox.getSelectedId() - 1, nullptr);
+        storeTree();
+    };
+    restButton.onClick = [this]
+    {
+        getNode(selected).setProperty("rest", restButton.getToggleState(), nullptr);
+        storeTree();
+    };
+
+    for (auto* comp : std::initializer_list<juce::Component*>{ &beatBox, &notesSlider, &splitButton, &clearButton, &weightSlider, &velocitySlider, &soundBox, &restButton })
+    {
+        addAndMakeVisible(comp);
+    }
+    loadTree();
+}
+
+void TupletEditor::refresh()
+{
+    if (stepPatterns.getPatterns().tuplets.version != shownVersion)
+    {
+        loadTree();
+    }
+}
+
+void TupletEditor::paint(juce::Graphics& g)
+{
+    auto area = getTreeArea();
+    g.setColour(juce::Colours::darkgrey);
+    g.drawRect(area);
+    if (!tree.isValid())
+    {
+        g.setColour(juce::Colours::grey);
+        g.drawText("plays SUBDIVISION, split to start a tree", area, juce::Justification::centred);
+        return;
+    }
+
+    forEachNode([&](const juce::ValueTree& node, juce::Rectangle<float> bounds, const NodePath& path)
+    {
+        const bool isSelected = path == selected;
+        if (node.hasType("NOTE"))
+        {
+            //notes reach down to the bottom so the beat reads as one row of clicks
+            auto note = bounds.withBottom(area.getBottom()).reduced(1.0f);
+            const bool isRest = node.getProperty("rest", false);
+            g.setColour(isRest ? juce::Colours::darkgrey : juce::Colours::steelblue);
+            g.fillRect(note.withTop(note.getBottom() - note.getHeight() * (isRest ? 0.1f : juce::jlimit(0.0f, 1.0f, (float)node.getProperty("velocity", 1.0f)))));
+            g.setColour(isSelected ? juce::Colours::orange : juce::Colours::lightgrey);
+            g.drawRect(note, isSelected ? 2.0f : 1.0f);
+        }
+        else
+        {
+            g.setColour(isSelected ? juce::Colours::orange : juce::Colours::grey);
+            g.fillRect(bounds.reduced(1.0f).withHeight(4.0f));
+        }
+    });
+}
+
+void TupletEditor::resized()
+{
+    auto bounds = getLocalBounds().reduced(5);
+    auto controls = bounds.removeFromLeft(250);
+    auto row = controls.removeFromTop(25);
+    beatBox.setBounds(row.removeFromLeft(120));
+    row.removeFromLeft(5);
+    clearButton.setBounds(row);
+    controls.removeFromTop(5);
+    row = controls.removeFromTop(25);
+    notesSlider.setBounds(row.removeFromLeft(120));
+    row.removeFromLeft(5);
+    splitButton.setBounds(row);
+    controls.removeFromTop(5);
+    row = controls.removeFromTop(25);
+    weightSlider.setBounds(row.removeFromLeft(120));
+    row.removeFromLeft(5);
+    restButton.setBounds(row);
+    controls.removeFromTop(5);
+    row = controls.removeFromTop(25);
+    velocitySlider.setBounds(row.removeFromLeft(120));
+    row.removeFromLeft(5);
+    soundBox.setBounds(row);
+}
+
+void TupletEditor::mouseDown(const juce::MouseEvent& event)
+{
+    //the deepest node under the mouse, a group only takes clicks on its own row, a note on everything below it too
+    const auto position = event.position;
+    const float bottom = getTreeArea().getBottom();
+    NodePath hit;
+    bool isHit = false;
+    forEachNode([&](const juce::ValueTree& node, juce::Rectangle<float> bounds, const NodePath& path)
+    {
+        if (node.hasType("NOTE"))
+        {
+            bounds.setBottom(bottom);
+        }
+        if (bounds.contains(position))
+        {
+            hit = path;
+            isHit = true;
+        }
+    });
+    if (isHit)
+    {
+        selected = hit;
+        showNode();
+        repaint();
+    }
+}
+
+void TupletEditor::loadTree()
+{
+    shownVersion = stepPatterns.getPatterns().tuplets.version;
+    tree = stepPatterns.getBeatTree(beatBox.getSelectedId() - 1);
+    if (!getNode(selected).isValid())
+    {
+        selected.clear();
+    }
+    showNode();
+    repaint();
+}
+
+void TupletEditor::storeTree()
+{
+    stepPatterns.setBeatTree(beatBox.getSelectedId() - 1, tree);
+    //the store compiled the edit, it doesn't have to be loaded back
+    shownVersion = stepPatterns.getPatterns().tuplets.version;
+    if (!getNode(selected).isValid())
+    {
+        selected.clear();
+    }
+    showNode();
+    repaint();
+}
+
+void TupletEditor::showNode()
+{
+    const auto node = getNode(selected);
+    const bool isNote = node.hasType("NOTE");
+    //the beat always fills its span, only its children have a weight
+    weightSlider.setEnabled(node.isValid() && !selected.isEmpty());
+    velocitySlider.setEnabled(isNote);
+    soundBox.setEnabled(isNote);
+    restButton.setEnabled(isNote);
+    splitButton.setEnabled(selected.size() < TupletPattern::maxDepth);
+    clearButton.setEnabled(tree.isValid());
+
+    weightSlider.setValue((int)node.getProperty("weight", 1), juce::dontSendNotification);
+    velocitySlider.setValue((float)node.getProperty("velocity", 1.0f), juce::dontSendNotification);
+    soundBox.setSelectedId(juce::jlimit(0, 2, (int)node.getProperty("sound", 2)) + 1, juce::dontSendNotification);
+    restButton.setToggleState(node.getProperty("rest", false), juce::dontSendNotification);
+}
+
+void TupletEditor::splitNode()
+{
+    if (!tree.isValid())
+    {
+        tree = juce::ValueTree("BEAT");
+        selected.clear();
+    }
+    auto node = getNode(selected);
+    if (node.hasType("NOTE"))
+    {
+        //a note becomes a group in its place and keeps its share of the parent
+        juce::ValueTree group("GROUP");
+        group.setProperty("weight", node.getProperty("weight", 1), nullptr);
+        auto parent = node.getParent();
+        const int index = parent.indexOf(node);
+        parent.removeChild(index, nullptr);
+        parent.addChild(group, index, nullptr);
+        node = group;
+    }
+    node.removeAllChildren(nullptr);
+    for (int note = 0; note < (int)notesSlider.getValue(); note++)
+    {
+        node.appendChild(juce::ValueTree("NOTE"), nullptr);
+    }
+    storeTree();
+}
+
+juce::ValueTree TupletEditor::getNode(const NodePath& path) const
+{
+    auto node = tree;
+    for (int index : path)
+    {
+        node = node.getChild(index);
+    }
+    return node;
+}
+
+juce::Rectangle<float> TupletEditor::getTreeArea() const
+{
+    return getLocalBounds().reduced(5).withTrimmedLeft(255).toFloat();
+}
+
+void TupletEditor::forEachNode(const std::function<void(const juce::ValueTree&, juce::Rectangle<float>, const NodePath&)>& visit) const
+{
+    if (!tree.isValid())
+    {
+        return;
+    }
+    auto area = getTreeArea();
+    NodePath path;
+    visitNode(tree, area.withHeight(area.getHeight() / (TupletPattern::maxDepth + 1)), path, visit);
+}
+
+void TupletEditor::visitNode(const juce::ValueTree& node, juce::Rectangle<float> bounds, NodePath& path,
+    const std::function<void(const juce::ValueTree&, juce::Rectangle<float>, const NodePath&)>& visit) const
+{
+    visit(node, bounds, path);
+    if (node.hasType("NOTE"))
+    {
+        return;
+    }
+
+    //the same shares TupletPattern::compile gives the children
+    int totalWeight = 0;
+    for (const auto& child : node)
+    {
+        totalWeight += juce::jlimit(1, TupletPattern::maxWeight, (int)child.getProperty("weight", 1));
+    }
+    float x = bounds.getX();
+    for (int index = 0; index < node.getNumChildren(); index++)
+    {
+        const auto child = node.getChild(index);
+        const float width = bounds.getWidth() * juce::jlimit(1, TupletPattern::maxWeight, (int)child.getProperty("weight", 1)) / (float)totalWeight;
+        path.add(index);
+        visitNode(child, { x, bounds.getBottom(), width, bounds.getHeight() }, path, visit);
+        path.removeLast();
+        x += width;
+    }
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    TupletEditor.h
+    Created: 22 Oct 2026 2:41:53pm
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "StepPattern.h"
+#include "TupletPattern.h"
+
+//Default mode's tuplet tree of one beat (see TupletPattern), drawn as nested spans, one row per depth
+//a node is picked by clicking it, split turns it into a group of equal notes, the other controls edit the picked node
+//every edit goes back through StepPatternStore::setBeatTree as a whole tree
+class TupletEditor : public juce::Component
+{
+public:
+    TupletEditor(StepPatternStore& _stepPatterns);
+
+    //message thread, shows the tree again when a preset or a restored session replaced it, cheap enough for every frame
+    void refresh();
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void mouseDown(const juce::MouseEvent& event) override;
+
+private:
+    //child indices from the beat down to a node, empty is the beat itself
+    using NodePath = juce::Array<int>;
+
+    void loadTree();
+    void storeTree();
+    void showNode();
+    void splitNode();
+    juce::ValueTree getNode(const NodePath& path) const;
+    juce::Rectangle<float> getTreeArea() const;
+    //calls visit for every node with where it's drawn, parents before their children
+    void forEachNode(const std::function<void(const juce::ValueTree& node, juce::Rectangle<float> bounds, const NodePath& path)>& visit) const;
+    void visitNode(const juce::ValueTree& node, juce::Rectangle<float> bounds, NodePath& path,
+        const std::function<void(const juce::ValueTree&, juce::Rectangle<float>, const NodePath&)>& visit) const;
+
+    StepPatternStore& stepPatterns;
+    juce::ValueTree tree; //a copy of the beat's tree, invalid when it has none
+    NodePath selected;
+    juce::uint32 shownVersion = 0;
+
+    juce::ComboBox beatBox; //item ids are the beat + 1
+    juce::Slider notesSlider{ juce::Slider::IncDecButtons, juce::Slider::TextBoxLeft };
+    juce::TextButton splitButton{ "split" };
+    juce::TextButton clearButton{ "clear" };
+    juce::Slider weightSlider{ juce::Slider::IncDecButtons, juce::Slider::TextBoxLeft };
+    juce::Slider velocitySlider{ juce::Slider::LinearBar, juce::Slider::TextBoxLeft };
+    juce::ComboBox soundBox; //item ids are the ClickSampleId + 1
+    juce::ToggleButton restButton{ "rest" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TupletEditor)
+};
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    TupletPattern.cpp
+    Created: 20 Oct 2026 12:04:19am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "TupletPattern.h"
+#include <numeric>
+
+namespace
+{
+    struct Fraction
+    {
+        Fraction(juce::int64 _numerator, juce::int64 _denominator)
+        {
+            const auto divisor = std::gcd(_numerator, _denominator);
+            numerator = _numerator / divisor;
+            denominator = _denominator / divisor;
+        }
+
+        Fraction operator+(const Fraction& other) const { return { numerator * other.denominator + other.numerator * denominator, denominator * other.denominator }; }
+        Fraction operator*(const Fraction& other) const { return { numerator * other.numerator, denominator * other.denominator }; }
+        bool operator<(const Fraction& other) const { return numerator * other.denominator < other.numerator * denominator; }
+
+        juce::int64 numerator;
+        juce::int64 denominator;
+    };
+
+    int getWeight(const juce::ValueTree& node)
+    {
+        return juce::jlimit(1, TupletPattern::maxWeight, (int)node.getProperty("weight", 1));
+    }
+
+    //adds the notes of a node spanning length of the beat from start, groups hand each child its share
+    void addEvents(const juce::ValueTree& node, Fraction start, Fraction length, int depth, std::vector<std::pair<Fraction, TupletEvent>>& events)
+    {
+        if (node.hasType("NOTE"))
+        {
+            if (!(bool)node.getProperty("rest", false) && start.numerator > 0)
+            {
+                TupletEvent event;
+                event.offsetNumerator = start.numerator;
+                event.offsetDenominator = start.denominator;
+                event.sound = juce::jlimit(0, 2, (int)node.getProperty("sound", 2));
+                event.velocity = juce::jlimit(0.0f, 1.0f, (float)node.getProperty("velocity", 1.0f));
+                events.push_back({ start, event });
+            }
+            return;
+        }
+        if (depth >= TupletPattern::maxDepth || !(node.hasType("GROUP") || node.hasType("BEAT")))
+        {
+            return;
+        }
+
+        int totalWeight = 0;
+        for (const auto& child : node)
+        {
+            totalWeight += getWeight(child);
+        }
+        if (totalWeight > TupletPattern::maxGroupWeight)
+        {
+            return;
+        }
+        int weightBefore = 0;
+        for (const auto& child : node)
+        {
+            const int weight = getWeight(child);
+            addEvents(child, start + length * Fraction(weightBefore, totalWeight), length * Fraction(weight, totalWeight), depth + 1, events);
+            weightBefore += weight;
+        }
+    }
+}
+
+TupletPattern TupletPattern::compile(const juce::ValueTree& tuplets)
+{
+    std::array<juce::ValueTree, MAX_LENGTH> beatTrees;
+    for (const auto& child : tuplets)
+    {
+        const int beat = (int)child.getProperty("beat", -1);
+        if (child.hasType("BEAT") && juce::isPositiveAndBelow(beat, MAX_LENGTH))
+        {
+            beatTrees[(size_t)beat] = child;
+        }
+    }
+
+    TupletPattern pattern;
+    std::vector<std::pair<Fraction, TupletEvent>> beatEvents;
+    for (int beat = 0; beat < MAX_LENGTH; beat++)
+    {
+        pattern.beatStarts[(size_t)beat] = pattern.numEvents;
+        if (!beatTrees[(size_t)beat].isValid())
+        {
+            continue;
+        }
+        pattern.hasTrees[(size_t)beat] = true;
+
+        beatEvents.clear();
+        addEvents(beatTrees[(size_t)beat], Fraction(0, 1), Fraction(1, 1), 0, beatEvents);
+        std::stable_sort(beatEvents.begin(), beatEvents.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        //a pattern with more events than fit loses the last ones
+        for (const auto& event : beatEvents)
+        {
+            if (pattern.numEvents < maxEvents)
+            {
+                pattern.events[(size_t)pattern.numEvents++] = event.second;
+            }
+        }
+    }
+    pattern.beatStarts[MAX_LENGTH] = pattern.numEvents;
+    return pattern;
+}
+
+void TupletOffsetTable::update(const TupletPattern& pattern, int beatInterval)
+{
+    if (pattern.version == builtVersion && beatInterval == builtInterval)
+    {
+        return;
+    }
+    builtVersion = pattern.version;
+    builtInterval = beatInterval;
+
+    for (int event = 0; event < pattern.numEvents; event++)
+    {
+        //rounded once from the exact fraction, not accumulated from the previous event
+        const auto& tupletEvent = pattern.events[(size_t)event];
+        offsets[(size_t)event] = (int)((2 * tupletEvent.offsetNumerator * beatInterval + tupletEvent.offsetDenominator) / (2 * tupletEvent.offsetDenominator));
+    }
+}
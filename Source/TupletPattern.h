@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    TupletPattern.h
+    Created: 20 Oct 2026 12:04:19am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Utilities.h"
+
+//one click of a compiled tuplet beat, the offset is an exact fraction of the beat so no rounding builds up through nested groups
+struct TupletEvent
+{
+    juce::int64 offsetNumerator = 0;
+    juce::int64 offsetDenominator = 1;
+    int sound = 2; //ClickSampleId, the subdivision click unless the note picks another
+    float velocity = 1.0f;
+};
+
+//per beat rhythm trees for Default mode, a beat with a tree plays its events instead of the SUBDIVISION clicks
+//the trees are edited as ValueTrees on the message thread:
+//  BEAT (beat: index in the bar) is a group that fills the beat
+//  GROUP splits its span between its children in proportion to their weight (default 1), so 3 children are a triplet and weights 1 1 2 are two sixteenths and an eighth
+//  NOTE is a leaf with weight, velocity (0 to 1), sound (ClickSampleId) and rest (true for silence)
+//every edit compiles all of them into one flat array sorted by beat and offset, the audio thread never walks a tree
+//a note at offset 0 lands on the beat itself, which rhythm1 plays, so it only takes up its share of the beat
+struct TupletPattern
+{
+    static constexpr int maxEvents = 256;
+    //keep the exact offsets' denominators well inside 64 bits, deeper or heavier groups are skipped
+    static constexpr int maxDepth = 4;
+    static constexpr int maxWeight = 16;
+    static constexpr int maxGroupWeight = 64; //children's weights added up
+
+    //message thread, tuplets is the parent of the BEAT trees, anything malformed is skipped
+    static TupletPattern compile(const juce::ValueTree& tuplets);
+
+    bool hasTree(int beat) const { return juce::isPositiveAndBelow(beat, MAX_LENGTH) && hasTrees[(size_t)beat]; }
+    int getFirstEvent(int beat) const { return beatStarts[(size_t)beat]; }
+    int getEndEvent(int beat) const { return beatStarts[(size_t)beat + 1]; }
+
+    std::array<TupletEvent, maxEvents> events;
+    int numEvents = 0;
+    std::array<int, MAX_LENGTH + 1> beatStarts{}; //beat b's events are [beatStarts[b], beatStarts[b + 1])
+    std::array<bool, MAX_LENGTH> hasTrees{};
+    juce::uint32 version = 0; //changes with every edit, so the engine only converts the offsets to samples again when it moves
+};
+
+//the samples each event of a TupletPattern falls after its beat, for one beat length
+class TupletOffsetTable
+{
+public:
+    //only converts again when the pattern or the beat length changed
+    void update(const TupletPattern& pattern, int beatInterval);
+
+    int getOffset(int event) const { return offsets[(size_t)event]; }
+
+private:
+    std::array<int, TupletPattern::maxEvents> offsets{};
+    juce::uint32 builtVersion = 0;
+    int builtInterval = -1;
+};
@@ -9,4 +9,46 @@
 */
 #pragma once
 
-const int MAX_LENGTH = 16;
\ No newline at end of file
+#include <array>
+#include <atomic>
+
+const int MAX_LENGTH = 16;
+const int MAX_STEPS = 256; //steps a pattern can hold, independent of how many the sliders currently reach
+
+
+//lock free triple buffer that hands values from one writer thread to one reader thread
+//the writer fills its back slot and publishes it, the reader picks up the newest published slot whenever it decides to
+//neither side ever blocks or allocates, and the reader's active slot is never touched by the writer
+template <typename T>
+class TripleBuffer
+{
+public:
+    //writer thread only
+    void publish(const T& value)
+    {
+        slots[back] = value;
+        back = state.exchange(back | pendingFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    //reader thread only
+    bool hasPending() const { return (state.load(std::memory_order_acquire) & pendingFlag) != 0; }
+
+    bool acquire()
+    {   //swaps the newest published value in as the active one, returns false if nothing new was published
+        if (!hasPending())
+            return false;
+        front = state.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& getActive() const { return slots[front]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int pendingFlag = 4;
+
+    std::array<T, 3> slots{};
+    int front = 0; //slot owned by the reader
+    int back = 1; //slot owned by the writer
+    std::atomic<int> state{ 2 }; //index of the middle slot, plus pendingFlag when it holds an unread value
+};
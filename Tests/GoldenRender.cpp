@@ -0,0 +1,436 @@
+/*
+  ==============================================================================
+
+    GoldenRender.cpp
+    Created: 20 Oct 2026 2:46:10am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "GoldenRender.h"
+#include "PluginProcessor.h"
+#include "SongTimeline.h"
+#include <algorithm>
+#include <deque>
+
+RenderFingerprint RenderFingerprint::fromSimulation(const HostSimulation& simulation)
+{
+    RenderFingerprint fingerprint;
+    const auto& audio = simulation.audio;
+    const int numSamples = audio.getNumSamples();
+    fingerprint.length = numSamples;
+
+    //loudest channel per sample, so a click on any channel counts
+    std::vector<float> peaks((size_t)numSamples, 0.0f);
+    for (int channel = 0; channel < audio.getNumChannels(); channel++)
+    {
+        auto* samples = audio.getReadPointer(channel);
+        for (int i = 0; i < numSamples; i++)
+        {
+            peaks[(size_t)i] = juce::jmax(peaks[(size_t)i], (float)std::abs(samples[i]));
+        }
+    }
+
+    //peak of the window before each sample from a running maximum, rescanning the window every sample would slow the whole suite down
+    std::deque<int> window; //indices with falling peaks, the front is the window's maximum
+    int nextAllowed = 0; //one onset per window, the rest of the attack isn't another click
+    for (int i = 0; i < numSamples; i++)
+    {
+        while (!window.empty() && window.front() < i - onsetWindow)
+        {
+            window.pop_front();
+        }
+        float before = window.empty() ? 0.0f : peaks[(size_t)window.front()];
+        if (i >= nextAllowed && peaks[(size_t)i] > onsetThreshold && peaks[(size_t)i] > before * onsetRatio)
+        {
+            float peak = 0.0f;
+            for (int j = i; j < juce::jmin(numSamples, i + onsetWindow); j++)
+            {
+                peak = juce::jmax(peak, peaks[(size_t)j]);
+            }
+            fingerprint.onsets.push_back({ i, juce::Decibels::gainToDecibels(peak) });
+            nextAllowed = i + onsetWindow;
+        }
+
+        while (!window.empty() && peaks[(size_t)window.back()] <= peaks[(size_t)i])
+        {
+            window.pop_back();
+        }
+        window.push_back(i);
+    }
+
+    for (const auto& event : simulation.midi)
+    {
+        if (event.message.isNoteOnOrOff())
+        {
+            fingerprint.notes.push_back({ event.position, event.message.getNoteNumber(), event.message.isNoteOn() ? (int)event.message.getVelocity() : 0 });
+        }
+    }
+    return fingerprint;
+}
+
+juce::String RenderFingerprint::toString() const
+{
+    juce::String text;
+    text << "length " << length << "\n";
+    for (const auto& onset : onsets)
+    {
+        text << "onset " << onset.position << " " << juce::String(onset.peakDb, 2) << "\n";
+    }
+    for (const auto& note : notes)
+    {
+        text << "note " << note.position << " " << note.noteNumber << " " << note.velocity << "\n";
+    }
+    return text;
+}
+
+RenderFingerprint RenderFingerprint::fromString(const juce::String& text)
+{
+    RenderFingerprint fingerprint;
+    for (const auto& line : juce::StringArray::fromLines(text))
+    {
+        auto tokens = juce::StringArray::fromTokens(line, " ", "");
+        if (tokens[0] == "length" && tokens.size() == 2)
+        {
+            fingerprint.length = tokens[1].getLargeIntValue();
+        }
+        else if (tokens[0] == "onset" && tokens.size() == 3)
+        {
+            fingerprint.onsets.push_back({ tokens[1].getLargeIntValue(), tokens[2].getFloatValue() });
+        }
+        else if (tokens[0] == "note" && tokens.size() == 4)
+        {
+            fingerprint.notes.push_back({ tokens[1].getLargeIntValue(), tokens[2].getIntValue(), tokens[3].getIntValue() });
+        }
+    }
+    return fingerprint;
+}
+
+juce::StringArray RenderFingerprint::compareWith(const RenderFingerprint& golden, Tolerance tolerance) const
+{
+    juce::StringArray differences;
+    if (length != golden.length)
+    {
+        differences.add("length " + juce::String(length) + ", golden " + juce::String(golden.length));
+    }
+
+    //both lists are in order, walked together so one extra or missing click shows up as that and doesn't shift every pair after it
+    size_t actual = 0;
+    size_t expected = 0;
+    while (actual < onsets.size() || expected < golden.onsets.size())
+    {
+        if (expected == golden.onsets.size() || (actual < onsets.size() && onsets[actual].position < golden.onsets[expected].position - tolerance.positionTolerance))
+        {
+            differences.add("extra onset at " + juce::String(onsets[actual++].position));
+        }
+        else if (actual == onsets.size() || golden.onsets[expected].position < onsets[actual].position - tolerance.positionTolerance)
+        {
+            differences.add("missing onset at " + juce::String(golden.onsets[expected++].position));
+        }
+        else
+        {
+            const auto& a = onsets[actual++];
+            const auto& e = golden.onsets[expected++];
+            if (std::abs(a.peakDb - e.peakDb) > tolerance.levelToleranceDb)
+            {
+                differences.add("onset at " + juce::String(a.position) + " is " + juce::String(a.peakDb, 2) + " dB, golden " + juce::String(e.peakDb, 2) + " dB");
+            }
+        }
+    }
+
+    //MIDI events are exact, a note that moved by a sample is a different note
+    size_t note = 0;
+    for (; note < notes.size() && note < golden.notes.size(); note++)
+    {
+        const auto& a = notes[note];
+        const auto& e = golden.notes[note];
+        if (a.position != e.position || a.noteNumber != e.noteNumber || a.velocity != e.velocity)
+        {
+            differences.add("note " + juce::String((int)note) + " is " + juce::String(a.noteNumber) + "/" + juce::String(a.velocity) + " at " + juce::String(a.position)
+                + ", golden " + juce::String(e.noteNumber) + "/" + juce::String(e.velocity) + " at " + juce::String(e.position));
+            break; //everything after the first moved note is usually moved too
+        }
+    }
+    if (notes.size() != golden.notes.size())
+    {
+        differences.add(juce::String((int)notes.size()) + " notes, golden " + juce::String((int)golden.notes.size()));
+    }
+    return differences;
+}
+
+
+std::vector<GoldenRenderSuite::Case> GoldenRenderSuite::getCanonicalCases()
+{
+    //every mode at a slow and an odd tempo, all steps and a pattern with gaps, at two sample rates and two block sizes,
+    //5 against 3 so Default has triplet subdivisions in 5/4 and the other modes have rhythms that don't share a step
+    std::vector<Case> cases;
+    const int modes[] = { 0, 1, 2 };
+    const double tempos[] = { 60.0, 173.3 };
+    const double sampleRates[] = { 44100.0, 96000.0 };
+    const int blockSizes[] = { 512, 37 };
+    for (int mode : modes)
+    {
+        for (double bpm : tempos)
+        {
+            for (int pattern = 0; pattern < 2; pattern++)
+            {
+                for (double sampleRate : sampleRates)
+                {
+                    for (int blockSize : blockSizes)
+                    {
+                        Case c;
+                        c.name = "mode" + juce::String(mode) + "_bpm" + juce::String(bpm, 1) + "_pattern" + juce::String(pattern)
+                            + "_" + juce::String((int)sampleRate) + "_" + juce::String(blockSize);
+                        auto& s = c.scenario;
+                        s << "samplerate " << (int)sampleRate << "\n";
+                        s << "length " << (int)(sampleRate * 4) << "\n";
+                        s << "blocks " << blockSize << "\n";
+                        s << "param 0 MODE " << mode << "\n";
+                        s << "param 0 BPM " << juce::String(bpm, 1) << "\n";
+                        s << "param 0 NUMERATOR 5\n";
+                        s << "param 0 SUBDIVISION 3\n";
+                        if (pattern == 1)
+                        {
+                            s << "step 0 0 1\n";
+                            s << "step 0 0 3\n";
+                            s << "step 0 1 2\n";
+                        }
+                        s << "reset 0\n";
+                        s << "param 0 ON/OFF 1\n";
+                        cases.push_back(c);
+                    }
+                }
+            }
+        }
+    }
+    return cases;
+}
+
+std::vector<GoldenRenderSuite::Case> GoldenRenderSuite::getEquivalenceCases()
+{
+    //every mode with a pattern with gaps and swing, so clicks are pushed past the end of the blocks they're scheduled in,
+    //on the engine's own clock and following a playing host, whose clock the engines read back every block
+    std::vector<Case> cases;
+    const juce::String variableBlocks = "blocks 1 7 64 511 13 2048 100 3 900 256\n";
+    for (int mode = 0; mode < 3; mode++)
+    {
+        juce::String session;
+        session << "samplerate 48000\n";
+        session << "length 480000\n";
+        session << "param 0 MODE " << mode << "\n";
+        session << "param 0 BPM 137\n";
+        session << "param 0 NUMERATOR 5\n";
+        session << "param 0 SUBDIVISION 3\n";
+        session << "param 0 SWING 62\n";
+        session << "step 0 0 1\n";
+        session << "step 0 1 2\n";
+        session << "reset 0\n";
+        session << "param 0 ON/OFF 1\n";
+
+        const juce::String name = "mode" + juce::String(mode);
+        cases.push_back({ name + "_variable_blocks", variableBlocks + session, "blocks 512\n" + session });
+        const juce::String hostSession = session + "tempo 0 137\nplay 0\n";
+        cases.push_back({ name + "_host_variable_blocks", variableBlocks + hostSession, "blocks 512\n" + hostSession });
+
+        //the wait lets the worker render the loop, the loop plays from about 2 seconds in, the swing change at 5 seconds hands back to the engine
+        const juce::String cachedSession = variableBlocks + session + "wait 24000 500\nparam 240000 SWING 58\nwait 240000 500\n";
+        cases.push_back({ name + "_loop_cache", cachedSession + "param 0 LOOP_CACHE 1\n", cachedSession });
+    }
+    return cases;
+}
+
+std::vector<GoldenRenderSuite::Case> GoldenRenderSuite::getSongCases()
+{
+    //odd tempos so the sections start between whole beats of the one before, every mode, and a mode coming back,
+    //cut into blocks of every size so the boundaries fall anywhere in them
+    struct SectionSettings { int mode; double bpm; int numerator; int subdivisions; int bars; };
+    const SectionSettings settings[] = { { 0, 120.0, 4, 2, 2 }, { 1, 97.3, 5, 3, 2 }, { 2, 143.1, 3, 4, 3 }, { 0, 61.7, 7, 1, 1 }, { 1, 173.3, 3, 1, 2 } };
+    const double sampleRate = 48000;
+
+    juce::Array<SongSection> sections;
+    Case c;
+    c.name = "song_section_starts";
+    c.scenario << "samplerate " << (int)sampleRate << "\n";
+    c.scenario << "blocks 1 7 64 511 13 2048 100 3 900 256\n";
+    for (const auto& setting : settings)
+    {
+        SongSection section;
+        section.mode = setting.mode;
+        section.bpm = setting.bpm;
+        section.numerator = setting.numerator;
+        section.subdivisions = setting.subdivisions;
+        section.bars = setting.bars;
+        sections.add(section);
+        c.scenario << "section 0 " << setting.mode << " " << juce::String(setting.bpm, 1) << " " << setting.numerator << " " << setting.subdivisions << " " << setting.bars << "\n";
+    }
+    SongTimeline timeline;
+    timeline.compile(sections, sampleRate);
+    for (int section = 0; section < timeline.getNumSections(); section++)
+    {
+        c.expectedOnsets.push_back(timeline.getSectionStart(section));
+    }
+    c.scenario << "length " << timeline.getSectionEnd(timeline.getNumSections() - 1) << "\n";
+    c.scenario << "param 0 SONG 1\n";
+    c.scenario << "param 0 ON/OFF 1\n";
+    return { c };
+}
+
+std::vector<GoldenRenderSuite::Case> GoldenRenderSuite::getSyncCases()
+{
+    //the tempo changes 10 beats in at 120, 7.5 beats of samples at 90, a follower that put a position in samples on the new tempo
+    //would jump half a bar, every mode since each counts its beats differently
+    std::vector<Case> cases;
+    for (int mode = 0; mode < 3; mode++)
+    {
+        juce::String session;
+        session << "samplerate 48000\n";
+        session << "length 480000\n";
+        session << "blocks 512\n";
+        session << "param 0 MODE " << mode << "\n";
+        session << "param 0 NUMERATOR 4\n";
+        session << "param 0 SUBDIVISION 3\n";
+
+        Case c;
+        c.name = "mode" + juce::String(mode) + "_sync_tempo_change";
+        c.scenario << session << "param 0 BPM 120\nparam 0 LOCAL_SYNC 1\nreset 0\nparam 0 ON/OFF 1\nparam 240000 BPM 90\n";
+        c.follower << session << "param 0 LOCAL_SYNC 2\nparam 0 ON/OFF 1\n";
+        cases.push_back(c);
+    }
+    return cases;
+}
+
+std::vector<GoldenRenderSuite::Case> GoldenRenderSuite::loadScenarioCases(const juce::File& directory)
+{
+    //sorted, so the cases run and print in the same order on every machine
+    auto files = directory.findChildFiles(juce::File::findFiles, false, "*.txt");
+    std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b) { return a.getFileName() < b.getFileName(); });
+    std::vector<Case> cases;
+    for (const auto& file : files)
+    {
+        const auto text = file.loadFileAsString();
+        cases.push_back({ "scenario_" + file.getFileNameWithoutExtension(), text });
+
+        //a later blocks line replaces the scenario's own, the reference is the same session cut into the reference's blocks
+        HostScenario scenario;
+        if (HostScenario::parse(text, scenario).wasOk() && !scenario.referenceBlockSizes.empty())
+        {
+            juce::String blocks = "\nblocks";
+            for (int blockSize : scenario.referenceBlockSizes)
+            {
+                blocks << " " << blockSize;
+            }
+            cases.push_back({ "scenario_" + file.getFileNameWithoutExtension() + "_reference_blocks", text, text + blocks + "\n" });
+        }
+    }
+    return cases;
+}
+
+std::vector<GoldenRenderSuite::CaseResult> GoldenRenderSuite::run(const std::vector<Case>& cases, const juce::File& goldenDirectory, bool isRecording, RenderFingerprint::Tolerance tolerance)
+{
+    std::vector<CaseResult> results;
+    if (isRecording)
+    {
+        goldenDirectory.createDirectory();
+    }
+    for (const auto& c : cases)
+    {
+        CaseResult result;
+        result.name = c.name;
+
+        RenderFingerprint fingerprint;
+        RenderFingerprint follower;
+        auto rendered = c.follower.isNotEmpty() ? renderTogether(c.scenario, c.follower, fingerprint, follower) : render(c.scenario, fingerprint);
+        if (rendered.failed())
+        {
+            result.differences.add(rendered.getErrorMessage());
+            results.push_back(result);
+            continue;
+        }
+
+        auto goldenFile = goldenDirectory.getChildFile(c.name + ".golden");
+        if (c.follower.isNotEmpty())
+        {
+            //MIDI is placed to the sample, the follower only has to be as close as the sync gets it, so only the clicks are compared
+            result.hasGolden = true;
+            fingerprint.notes.clear();
+            follower.notes.clear();
+            auto syncTolerance = tolerance;
+            syncTolerance.positionTolerance = juce::jmax(tolerance.positionTolerance, syncToleranceSamples);
+            result.differences = follower.compareWith(fingerprint, syncTolerance);
+        }
+        else if (!c.expectedOnsets.empty())
+        {
+            result.hasGolden = true;
+            for (auto expected : c.expectedOnsets)
+            {
+                const bool isFound = std::any_of(fingerprint.onsets.begin(), fingerprint.onsets.end(),
+                    [&](const RenderFingerprint::Onset& onset) { return std::abs(onset.position - expected) <= tolerance.positionTolerance; });
+                if (!isFound)
+                {
+                    result.differences.add("no click starts at " + juce::String(expected));
+                }
+            }
+        }
+        else if (c.reference.isNotEmpty())
+        {
+            //nothing to record, the reference is rendered again every run
+            RenderFingerprint reference;
+            rendered = render(c.reference, reference);
+            result.hasGolden = rendered.wasOk();
+            result.differences = rendered.wasOk() ? fingerprint.compareWith(reference, tolerance) : juce::StringArray(rendered.getErrorMessage());
+        }
+        else if (isRecording)
+        {
+            result.hasGolden = goldenFile.replaceWithText(fingerprint.toString());
+        }
+        else if (goldenFile.existsAsFile())
+        {
+            result.hasGolden = true;
+            result.differences = fingerprint.compareWith(RenderFingerprint::fromString(goldenFile.loadFileAsString()), tolerance);
+        }
+        results.push_back(result);
+    }
+    return results;
+}
+
+juce::Result GoldenRenderSuite::render(const juce::String& scenarioText, RenderFingerprint& fingerprint)
+{
+    HostScenario scenario;
+    auto parsed = HostScenario::parse(scenarioText, scenario);
+    if (parsed.failed())
+    {
+        return parsed;
+    }
+
+    //a fresh processor per render, so nothing one case left behind leaks into the next
+    auto processor = std::make_unique<MetroGnomeAudioProcessor>();
+    HostSimulator simulator(*processor);
+    fingerprint = RenderFingerprint::fromSimulation(simulator.run(scenario));
+    return juce::Result::ok();
+}
+
+juce::Result GoldenRenderSuite::renderTogether(const juce::String& leaderText, const juce::String& followerText, RenderFingerprint& leader, RenderFingerprint& follower)
+{
+    HostScenario leaderScenario;
+    HostScenario followerScenario;
+    auto parsed = HostScenario::parse(leaderText, leaderScenario);
+    if (parsed.wasOk())
+    {
+        parsed = HostScenario::parse(followerText, followerScenario);
+    }
+    if (parsed.failed())
+    {
+        return parsed;
+    }
+
+    //the two instances meet in the machine's shared clock segment, like two standalones would
+    auto leaderProcessor = std::make_unique<MetroGnomeAudioProcessor>();
+    auto followerProcessor = std::make_unique<MetroGnomeAudioProcessor>();
+    HostSimulator leaderSimulator(*leaderProcessor);
+    HostSimulator followerSimulator(*followerProcessor);
+    const auto simulations = HostSimulator::runTogether(leaderSimulator, leaderScenario, followerSimulator, followerScenario);
+    leader = RenderFingerprint::fromSimulation(simulations.first);
+    follower = RenderFingerprint::fromSimulation(simulations.second);
+    return juce::Result::ok();
+}
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    GoldenRender.h
+    Created: 20 Oct 2026 2:46:10am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HostSimulator.h"
+
+//what a render has to keep doing after a refactor, instead of the whole WAV: where each click starts and how loud it is,
+//and every MIDI event, a few hundred bytes of text per render
+struct RenderFingerprint
+{
+    //slack when comparing, a click that moved by more than positionTolerance samples or changed level by more than levelToleranceDb is a difference
+    struct Tolerance
+    {
+        int positionTolerance = 1;
+        float levelToleranceDb = 0.5f;
+    };
+
+    struct Onset
+    {
+        juce::int64 position = 0;
+        float peakDb = 0; //loudest sample of any channel in the click's first onsetWindow samples
+    };
+
+    struct Note
+    {
+        juce::int64 position = 0;
+        int noteNumber = 0;
+        int velocity = 0; //0 for note off
+    };
+
+    //a click starts where the signal jumps above onsetRatio times the peak of the onsetWindow samples before it,
+    //the clicks' attacks are a few samples long so this still finds a click that lands on the tail of the previous one
+    static constexpr int onsetWindow = 64;
+    static constexpr float onsetRatio = 4.0f;
+    static constexpr float onsetThreshold = 0.001f; //-60 dB, anything quieter is taken as silence
+
+    static RenderFingerprint fromSimulation(const HostSimulation& simulation);
+
+    //one line per onset and per note, read back by fromString
+    juce::String toString() const;
+    static RenderFingerprint fromString(const juce::String& text);
+
+    //every difference as a line of text, empty when the two match within tolerance
+    juce::StringArray compareWith(const RenderFingerprint& golden, Tolerance tolerance) const;
+
+    juce::int64 length = 0;
+    std::vector<Onset> onsets;
+    std::vector<Note> notes;
+};
+
+//renders a fixed set of configurations (modes, tempos, patterns, sample rates, block sizes) and the scenario files in Tests/Scenarios
+//through the HostSimulator and compares their fingerprints with the golden ones kept as <case name>.golden in Tests/Golden,
+//so a change to the engines can be checked to play the same clicks at the same samples as before,
+//equivalence cases are compared with a second render of another scenario instead, one that has to come out the same,
+//song cases with the samples their sections start on and sync cases with the instance they follow
+//needs JUCE initialised, MetroGnomeTests golden runs it, each case gets its own fresh processor
+class GoldenRenderSuite
+{
+public:
+    struct Case
+    {
+        juce::String name;
+        juce::String scenario; //HostScenario text
+        juce::String reference; //HostScenario text of a render this one has to match, instead of a golden file
+        std::vector<juce::int64> expectedOnsets; //samples a click has to start on, checked against the render itself instead of a golden file
+        juce::String follower; //HostScenario text of a second instance rendered alongside this one, block for block, whose clicks have to match this one's
+    };
+
+    struct CaseResult
+    {
+        juce::String name;
+        bool hasGolden = false; //a golden file, or the reference render, to compare with
+        juce::StringArray differences; //also holds the scenario's parse error, if any
+        bool passed() const { return hasGolden && differences.isEmpty(); }
+    };
+
+    static std::vector<Case> getCanonicalCases();
+    //the same session rendered two ways that mustn't make a difference: any block sizes against fixed ones, the loop cache against the live engine
+    static std::vector<Case> getEquivalenceCases();
+    //a song through every mode, each section's first click has to start on the section's first sample
+    static std::vector<Case> getSongCases();
+    //a LOCAL_SYNC leader that changes tempo while playing, its follower has to stay on the leader's beats through the change
+    static std::vector<Case> getSyncCases();
+    //one case per .txt file in directory, named after the file, and one against its reference blocks if it has any
+    static std::vector<Case> loadScenarioCases(const juce::File& directory);
+
+    //isRecording writes the current fingerprints as the new goldens instead of comparing with them
+    static std::vector<CaseResult> run(const std::vector<Case>& cases, const juce::File& goldenDirectory, bool isRecording, RenderFingerprint::Tolerance tolerance = {});
+
+private:
+    static juce::Result render(const juce::String& scenarioText, RenderFingerprint& fingerprint);
+    static juce::Result renderTogether(const juce::String& leaderText, const juce::String& followerText, RenderFingerprint& leader, RenderFingerprint& follower);
+
+    //the follower places its blocks against the leader's by the machine's clock, and offline the leader's block is rendered
+    //a whole block's processing time before the follower's, so the follower's clicks land up to that much late, 2ms at the sync cases' 48kHz
+    static constexpr int syncToleranceSamples = 96;
+};
@@ -0,0 +1,446 @@
+/*
+  ==============================================================================
+
+    HostSimulator.cpp
+    Created: 20 Oct 2026 2:03:44am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "HostSimulator.h"
+#include "PluginProcessor.h"
+
+juce::Result HostScenario::parse(const juce::String& text, HostScenario& scenario)
+{
+    scenario = HostScenario();
+    auto lines = juce::StringArray::fromLines(text);
+    for (int lineIndex = 0; lineIndex < lines.size(); lineIndex++)
+    {
+        auto line = lines[lineIndex].upToFirstOccurrenceOf("#", false, false).trim();
+        if (line.isEmpty())
+        {
+            continue;
+        }
+        auto tokens = juce::StringArray::fromTokens(line, " \t", "");
+        tokens.removeEmptyStrings();
+        auto fail = [&](const juce::String& reason) { return juce::Result::fail("line " + juce::String(lineIndex + 1) + ": " + reason); };
+        auto hasArguments = [&](int count) { return tokens.size() == count + 1; };
+        const auto& keyword = tokens[0];
+
+        if (keyword == "samplerate" && hasArguments(1))
+        {
+            scenario.sampleRate = tokens[1].getDoubleValue();
+            if (scenario.sampleRate <= 0)
+            {
+                return fail("bad sample rate");
+            }
+        }
+        else if (keyword == "length" && hasArguments(1))
+        {
+            scenario.length = tokens[1].getLargeIntValue();
+        }
+        else if ((keyword == "blocks" && tokens.size() > 1) || (keyword == "reference" && tokens[1] == "blocks" && tokens.size() > 2))
+        {
+            auto& blockSizes = keyword == "blocks" ? scenario.blockSizes : scenario.referenceBlockSizes;
+            blockSizes.clear();
+            for (int i = keyword == "blocks" ? 1 : 2; i < tokens.size(); i++)
+            {
+                int blockSize = tokens[i].getIntValue();
+                if (blockSize <= 0)
+                {
+                    return fail("block sizes have to be at least 1");
+                }
+                blockSizes.push_back(blockSize);
+            }
+        }
+        else if (keyword == "precision" && hasArguments(1) && (tokens[1] == "float" || tokens[1] == "double"))
+        {
+            scenario.isDouble = tokens[1] == "double";
+        }
+        else
+        {
+            //the rest are events, which all start with when they happen
+            if (tokens.size() < 2 || !tokens[1].containsOnly("0123456789"))
+            {
+                return fail("unknown line '" + line + "'");
+            }
+            Event event;
+            event.at = tokens[1].getLargeIntValue();
+            if (keyword == "tempo" && hasArguments(2))
+            {
+                event.type = EventType::tempo;
+                event.value = tokens[2].getDoubleValue();
+                if (event.value <= 0)
+                {
+                    return fail("bad tempo");
+                }
+            }
+            else if (keyword == "play" && hasArguments(1))
+            {
+                event.type = EventType::play;
+            }
+            else if (keyword == "stop" && hasArguments(1))
+            {
+                event.type = EventType::stop;
+            }
+            else if (keyword == "seek" && hasArguments(2))
+            {
+                event.type = EventType::seek;
+                event.position = tokens[2].getLargeIntValue();
+            }
+            else if (keyword == "loop" && hasArguments(2) && tokens[2] == "off")
+            {
+                event.type = EventType::loopOff;
+            }
+            else if (keyword == "loop" && hasArguments(3))
+            {
+                event.type = EventType::loop;
+                event.position = tokens[2].getLargeIntValue();
+                event.loopEnd = tokens[3].getLargeIntValue();
+                if (event.loopEnd <= event.position)
+                {
+                    return fail("a loop has to end after it starts");
+                }
+            }
+            else if (keyword == "param" && hasArguments(3))
+            {
+                event.type = EventType::param;
+                event.parameterID = tokens[2];
+                event.value = tokens[3].getDoubleValue();
+            }
+            else if (keyword == "step" && hasArguments(3))
+            {
+                event.type = EventType::step;
+                event.value = tokens[2].getIntValue();
+                event.position = tokens[3].getIntValue();
+                if (!juce::isPositiveAndBelow((int)event.value, 2) || !juce::isPositiveAndBelow(event.position, (juce::int64)MAX_STEPS))
+                {
+                    return fail("no such step");
+                }
+            }
+            else if (keyword == "reset" && hasArguments(1))
+            {
+                event.type = EventType::reset;
+            }
+            else if (keyword == "section" && hasArguments(6))
+            {
+                event.type = EventType::section;
+                event.mode = tokens[2].getIntValue();
+                event.value = tokens[3].getDoubleValue();
+                event.numerator = tokens[4].getIntValue();
+                event.subdivisions = tokens[5].getIntValue();
+                event.position = tokens[6].getIntValue();
+                if (!juce::isPositiveAndBelow(event.mode, 3) || event.value <= 0 || event.numerator < 1 || event.numerator > MAX_LENGTH
+                    || event.subdivisions < 1 || event.subdivisions > MAX_LENGTH || event.position <= 0)
+                {
+                    return fail("bad section");
+                }
+            }
+            else if (keyword == "wait" && hasArguments(2))
+            {
+                event.type = EventType::wait;
+                event.value = tokens[2].getIntValue();
+                if (event.value <= 0)
+                {
+                    return fail("bad wait");
+                }
+            }
+            else
+            {
+                return fail("unknown line '" + line + "'");
+            }
+            scenario.events.push_back(event);
+        }
+    }
+    std::stable_sort(scenario.events.begin(), scenario.events.end(), [](const Event& a, const Event& b) { return a.at < b.at; });
+    return juce::Result::ok();
+}
+
+
+bool HostSimulation::writeTo(const juce::File& directory) const
+{
+    if (!directory.createDirectory())
+    {
+        return false;
+    }
+
+    auto audioFile = directory.getChildFile("audio.wav");
+    audioFile.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(audioFile.createOutputStream());
+    if (stream == nullptr)
+    {
+        return false;
+    }
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), sampleRate, (unsigned int)audio.getNumChannels(), 32, {}, 0));
+    if (writer == nullptr)
+    {
+        return false;
+    }
+    stream.release(); //the writer owns it now
+    juce::AudioBuffer<float> floatAudio(audio.getNumChannels(), audio.getNumSamples());
+    for (int channel = 0; channel < audio.getNumChannels(); channel++)
+    {
+        auto* source = audio.getReadPointer(channel);
+        auto* destination = floatAudio.getWritePointer(channel);
+        for (int i = 0; i < audio.getNumSamples(); i++)
+        {
+            destination[i] = (float)source[i];
+        }
+    }
+    writer->writeFromAudioSampleBuffer(floatAudio, 0, floatAudio.getNumSamples());
+    writer.reset();
+
+    //a thousand ticks a second, so a DAW lines the notes up with the WAV, midi.txt has them to the sample
+    juce::MidiMessageSequence sequence;
+    juce::String midiText;
+    for (const auto& event : midi)
+    {
+        sequence.addEvent(event.message, event.position * 1000.0 / sampleRate);
+        midiText << event.position << " " << event.message.getDescription() << "\n";
+    }
+    sequence.updateMatchedPairs();
+    juce::MidiFile midiFile;
+    midiFile.setSmpteTimeFormat(25, 40);
+    midiFile.addTrack(sequence);
+    auto midiPath = directory.getChildFile("midi.mid");
+    midiPath.deleteFile();
+    juce::FileOutputStream midiStream(midiPath);
+    if (midiStream.failedToOpen() || !midiFile.writeTo(midiStream))
+    {
+        return false;
+    }
+    juce::String blocksText;
+    for (const auto& block : blocks)
+    {
+        blocksText << block.start << " " << block.numSamples << " " << block.timelinePosition << " " << (block.isPlaying ? "playing" : "stopped") << " " << block.bpm << "\n";
+    }
+    return directory.getChildFile("midi.txt").replaceWithText(midiText) && directory.getChildFile("blocks.txt").replaceWithText(blocksText);
+}
+
+
+HostSimulator::HostSimulator(MetroGnomeAudioProcessor& _processor)
+    : processor(_processor)
+{
+}
+
+HostSimulator::~HostSimulator()
+{
+    processor.setPlayHead(nullptr);
+}
+
+HostSimulation HostSimulator::run(const HostScenario& scenario)
+{
+    start(scenario);
+    while (renderNextBlock())
+    {
+    }
+    return finish();
+}
+
+std::pair<HostSimulation, HostSimulation> HostSimulator::runTogether(HostSimulator& first, const HostScenario& firstScenario, HostSimulator& second, const HostScenario& secondScenario)
+{
+    //first's block always goes before second's, like two audio callbacks on one machine where first's device runs slightly ahead
+    first.start(firstScenario);
+    second.start(secondScenario);
+    bool isFirstRendering = true;
+    bool isSecondRendering = true;
+    while (isFirstRendering || isSecondRendering)
+    {
+        isFirstRendering = isFirstRendering && first.renderNextBlock();
+        isSecondRendering = isSecondRendering && second.renderNextBlock();
+    }
+    return { first.finish(), second.finish() };
+}
+
+void HostSimulator::start(const HostScenario& _scenario)
+{
+    scenario = _scenario;
+    bpm.reset();
+    isPlaying = false;
+    timelinePosition = 0;
+    ppqPosition = 0;
+    isLooping = false;
+    nextEvent = 0;
+    nextBlockSize = 0;
+    rendered = 0;
+
+    const int maxBlockSize = *std::max_element(scenario.blockSizes.begin(), scenario.blockSizes.end());
+    processor.setPlayHead(&playHead);
+    processor.setProcessingPrecision(scenario.isDouble ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(scenario.sampleRate, maxBlockSize);
+    processor.prepareToPlay(scenario.sampleRate, maxBlockSize);
+    processor.runMessageThreadUpdates();
+
+    const int numChannels = juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+    if (scenario.isDouble)
+    {
+        doubleBuffer.setSize(numChannels, maxBlockSize);
+    }
+    else
+    {
+        floatBuffer.setSize(numChannels, maxBlockSize);
+    }
+    midiMessages.ensureSize(2048);
+
+    simulation = HostSimulation();
+    simulation.sampleRate = scenario.sampleRate;
+    simulation.audio.setSize(processor.getMainBusNumOutputChannels(), (int)scenario.length);
+    simulation.audio.clear();
+}
+
+bool HostSimulator::renderNextBlock()
+{
+    if (rendered >= scenario.length)
+    {
+        return false;
+    }
+    if (scenario.isDouble)
+    {
+        renderBlock(doubleBuffer);
+    }
+    else
+    {
+        renderBlock(floatBuffer);
+    }
+    return true;
+}
+
+HostSimulation HostSimulator::finish()
+{
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+    return std::move(simulation);
+}
+
+template <typename SampleType>
+void HostSimulator::renderBlock(juce::AudioBuffer<SampleType>& buffer)
+{
+    //the message thread gets its turn between blocks, like a host whose editor and automation run alongside
+    while (nextEvent < scenario.events.size() && scenario.events[nextEvent].at <= rendered)
+    {
+        applyEvent(scenario.events[nextEvent++]);
+    }
+    processor.runMessageThreadUpdates();
+
+    int numSamples = (int)juce::jmin<juce::int64>(scenario.blockSizes[nextBlockSize], scenario.length - rendered);
+    nextBlockSize = (nextBlockSize + 1) % scenario.blockSizes.size();
+    if (isPlaying && isLooping && timelinePosition < loopEnd)
+    {
+        //the block is cut at the loop's end, the next one starts back at its start
+        numSamples = (int)juce::jmin<juce::int64>(numSamples, loopEnd - timelinePosition);
+    }
+
+    auto& info = playHead.position;
+    info = juce::AudioPlayHead::PositionInfo();
+    info.setIsPlaying(isPlaying);
+    info.setTimeInSamples(timelinePosition);
+    info.setTimeInSeconds(timelinePosition / scenario.sampleRate);
+    info.setPpqPosition(ppqPosition);
+    info.setIsLooping(isLooping);
+    if (bpm)
+    {
+        info.setBpm(*bpm);
+        info.setTimeSignature(juce::AudioPlayHead::TimeSignature());
+        if (isLooping)
+        {
+            const double ppqPerSample = *bpm / (60.0 * scenario.sampleRate);
+            info.setLoopPoints(juce::AudioPlayHead::LoopPoints{ loopStart * ppqPerSample, loopEnd * ppqPerSample });
+        }
+    }
+    simulation.blocks.push_back({ rendered, numSamples, timelinePosition, isPlaying, bpm ? *bpm : 0.0 });
+
+    //silent input, the block is a view onto the start of the buffer so the processor sees the block size the host asked for
+    buffer.clear();
+    const int numChannels = buffer.getNumChannels();
+    juce::AudioBuffer<SampleType> block(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+    midiMessages.clear();
+    processor.processBlock(block, midiMessages);
+
+    for (int channel = 0; channel < simulation.audio.getNumChannels(); channel++)
+    {
+        auto* source = block.getReadPointer(channel);
+        auto* destination = simulation.audio.getWritePointer(channel, (int)rendered);
+        for (int i = 0; i < numSamples; i++)
+        {
+            destination[i] = (double)source[i];
+        }
+    }
+    for (const auto metadata : midiMessages)
+    {
+        simulation.midi.push_back({ rendered + metadata.samplePosition, metadata.getMessage() });
+    }
+
+    rendered += numSamples;
+    if (isPlaying)
+    {
+        timelinePosition += numSamples;
+        ppqPosition += numSamples * (bpm ? *bpm : 120.0) / (60.0 * scenario.sampleRate);
+        if (isLooping && timelinePosition == loopEnd)
+        {
+            timelinePosition = loopStart;
+            ppqPosition = loopStart * (bpm ? *bpm : 120.0) / (60.0 * scenario.sampleRate);
+        }
+    }
+}
+
+void HostSimulator::applyEvent(const HostScenario::Event& event)
+{
+    //runs where the message thread would, between blocks
+    const double sampleRate = processor.getSampleRate();
+    switch (event.type)
+    {
+    case HostScenario::EventType::tempo:
+        bpm = event.value;
+        break;
+    case HostScenario::EventType::play:
+        isPlaying = true;
+        break;
+    case HostScenario::EventType::stop:
+        isPlaying = false;
+        break;
+    case HostScenario::EventType::seek:
+        timelinePosition = event.position;
+        ppqPosition = event.position * (bpm ? *bpm : 120.0) / (60.0 * sampleRate);
+        break;
+    case HostScenario::EventType::loop:
+        isLooping = true;
+        loopStart = event.position;
+        loopEnd = event.loopEnd;
+        break;
+    case HostScenario::EventType::loopOff:
+        isLooping = false;
+        break;
+    case HostScenario::EventType::param:
+        if (auto* parameter = processor.apvts.getParameter(event.parameterID))
+        {
+            parameter->setValueNotifyingHost(parameter->convertTo0to1((float)event.value));
+        }
+        else
+        {
+            jassertfalse; //the scenario names a param that doesn't exist
+        }
+        break;
+    case HostScenario::EventType::step:
+        processor.stepPatterns.toggleStep((int)event.value, (int)event.position);
+        break;
+    case HostScenario::EventType::reset:
+        processor.requestReset();
+        break;
+    case HostScenario::EventType::wait:
+        juce::Thread::sleep((int)event.value);
+        break;
+    case HostScenario::EventType::section:
+    {
+        SongSection section;
+        section.mode = event.mode;
+        section.bpm = event.value;
+        section.numerator = event.numerator;
+        section.subdivisions = event.subdivisions;
+        section.bars = (int)event.position;
+        processor.songStore.addSection(section);
+        break;
+    }
+    }
+}
@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    HostSimulator.h
+    Created: 20 Oct 2026 2:03:44am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class MetroGnomeAudioProcessor;
+
+//a scripted host session, parsed from a small line based text format, # starts a comment:
+//  samplerate <Hz>                    default 48000
+//  length <samples>                   how much is rendered
+//  blocks <size> [<size> ...]         block sizes, used in turn and repeated, default 512
+//  reference blocks <size> [...]      the golden suite renders the scenario again with these block sizes, the two have to match
+//  precision float|double             processBlock overload the host calls, default float
+//  tempo <at> <bpm>                   the host reports a tempo from here on, without any the host reports none (no DAW)
+//  play <at> / stop <at>              transport
+//  seek <at> <position>               the host's timeline jumps to position
+//  loop <at> <start> <end> / loop <at> off
+//  param <at> <ID> <value>            value in the param's own range, e.g. param 0 ON/OFF 1
+//  step <at> <voice> <step>           toggles a step, like a click on the step grid
+//  reset <at>                         what the editor's mode and play buttons do
+//  wait <at> <ms>                     the host stalls between blocks, so worker threads (the loop cache) get to finish what they started
+//  section <at> <mode> <bpm> <numerator> <subdivisions> <bars>
+//                                     adds a section to the end of the song, every step on, like the song editor's add button
+//<at> is in rendered samples, an event happens at the start of the first block that starts at or after it,
+//positions are in samples on the host's timeline, which only moves while playing
+struct HostScenario
+{
+    enum class EventType { tempo, play, stop, seek, loop, loopOff, param, step, reset, wait, section };
+
+    struct Event
+    {
+        juce::int64 at = 0;
+        EventType type = EventType::play;
+        double value = 0; //bpm (also a section's), param value, voice or milliseconds
+        juce::int64 position = 0; //seek target, loop start, step or a section's bars
+        juce::int64 loopEnd = 0;
+        juce::String parameterID;
+        int mode = 0; //the rest are a section's
+        int numerator = 4;
+        int subdivisions = 1;
+    };
+
+    //fails on the first line it can't read, with the line number in the message
+    static juce::Result parse(const juce::String& text, HostScenario& scenario);
+
+    double sampleRate = 48000;
+    juce::int64 length = 48000;
+    std::vector<int> blockSizes{ 512 };
+    std::vector<int> referenceBlockSizes; //empty when there's no reference render
+    bool isDouble = false;
+    std::vector<Event> events; //sorted by at, events at the same time keep the script's order
+};
+
+//everything the processor put out during a scenario, positions are in rendered samples
+struct HostSimulation
+{
+    struct MidiEvent
+    {
+        juce::int64 position = 0;
+        juce::MidiMessage message;
+    };
+
+    //what the host told the processor for one block
+    struct Block
+    {
+        juce::int64 start = 0;
+        int numSamples = 0;
+        juce::int64 timelinePosition = 0;
+        bool isPlaying = false;
+        double bpm = 0; //0 while the host reports no tempo
+    };
+
+    //audio.wav, midi.mid, midi.txt (the exact sample of every event) and blocks.txt in directory
+    bool writeTo(const juce::File& directory) const;
+
+    double sampleRate = 48000;
+    juce::AudioBuffer<double> audio; //main output, kept in double whatever the host's precision was
+    std::vector<MidiEvent> midi;
+    std::vector<Block> blocks;
+};
+
+//drives a processor through a HostScenario without a DAW or audio device, with a fake play head
+//and the message thread's work done between blocks, so the same scenario renders the same output every time
+//the loop cache and timing analysis run worker threads, scenarios that turn them on are only as deterministic as those threads
+class HostSimulator
+{
+public:
+    HostSimulator(MetroGnomeAudioProcessor& _processor);
+    ~HostSimulator();
+
+    HostSimulation run(const HostScenario& scenario);
+    //renders two scenarios on two processors block for block, taking turns, for instances that play together through LOCAL_SYNC
+    static std::pair<HostSimulation, HostSimulation> runTogether(HostSimulator& first, const HostScenario& firstScenario, HostSimulator& second, const HostScenario& secondScenario);
+
+private:
+    class PlayHead : public juce::AudioPlayHead
+    {
+    public:
+        juce::Optional<PositionInfo> getPosition() const override { return position; }
+
+        PositionInfo position;
+    };
+
+    //run is start, renderNextBlock until it returns false, then finish
+    void start(const HostScenario& _scenario);
+    bool renderNextBlock();
+    HostSimulation finish();
+    template <typename SampleType>
+    void renderBlock(juce::AudioBuffer<SampleType>& buffer);
+    void applyEvent(const HostScenario::Event& event);
+
+    MetroGnomeAudioProcessor& processor;
+    PlayHead playHead;
+
+    //the scenario being rendered and how far it got
+    HostScenario scenario;
+    HostSimulation simulation;
+    juce::AudioBuffer<float> floatBuffer;
+    juce::AudioBuffer<double> doubleBuffer;
+    juce::MidiBuffer midiMessages;
+    size_t nextEvent = 0;
+    size_t nextBlockSize = 0;
+    juce::int64 rendered = 0;
+
+    //the simulated host's transport
+    juce::Optional<double> bpm;
+    bool isPlaying = false;
+    juce::int64 timelinePosition = 0;
+    double ppqPosition = 0;
+    bool isLooping = false;
+    juce::int64 loopStart = 0;
+    juce::int64 loopEnd = 0;
+};
@@ -0,0 +1,280 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 23 Oct 2026 9:12:40am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "HostSimulator.h"
+#include "GoldenRender.h"
+#include "StressHarness.h"
+#include "TempoFollower.h"
+#include "OnsetDetector.h"
+
+//the console side of the project (MetroGnomeTests.jucer), the plugin's processor driven without a DAW or an audio device,
+//every command exits with 0 when it worked and 1 when it didn't, so a script or a CI job can run it as it is
+namespace
+{
+    void runScenario(const juce::ArgumentList& args)
+    {
+        if (args.size() != 3)
+        {
+            juce::ConsoleApplication::fail("expected a scenario file and an output folder");
+        }
+        const auto scenarioFile = args[1].resolveAsExistingFile();
+        const auto outputFolder = args[2].resolveAsFile();
+
+        HostScenario scenario;
+        const auto parsed = HostScenario::parse(scenarioFile.loadFileAsString(), scenario);
+        if (parsed.failed())
+        {
+            juce::ConsoleApplication::fail(scenarioFile.getFileName() + ", " + parsed.getErrorMessage());
+        }
+
+        MetroGnomeAudioProcessor processor;
+        HostSimulator simulator(processor);
+        const auto simulation = simulator.run(scenario);
+        if (!simulation.writeTo(outputFolder))
+        {
+            juce::ConsoleApplication::fail("couldn't write to " + outputFolder.getFullPathName());
+        }
+        std::cout << scenarioFile.getFileName() << ": " << simulation.audio.getNumSamples() << " samples in " << simulation.blocks.size() << " blocks, "
+                  << simulation.midi.size() << " MIDI events, written to " << outputFolder.getFullPathName() << std::endl;
+    }
+
+    void runGolden(const juce::ArgumentList& args)
+    {
+        //run from the repository's root unless the folders are given
+        const bool isRecording = args.containsOption("--record");
+        //until goldens have been recorded and committed the cases that need one are only reported, --require-goldens fails them
+        const bool isGoldenRequired = args.containsOption("--require-goldens");
+        const auto goldenFolder = args.containsOption("--golden") ? args.getFileForOption("--golden") : juce::File::getCurrentWorkingDirectory().getChildFile("Tests/Golden");
+        const auto scenarioFolder = args.containsOption("--scenarios") ? args.getExistingFolderForOption("--scenarios") : juce::File::getCurrentWorkingDirectory().getChildFile("Tests/Scenarios");
+        if (!isRecording && isGoldenRequired && !goldenFolder.isDirectory())
+        {
+            juce::ConsoleApplication::fail("no golden folder at " + goldenFolder.getFullPathName() + ", record one with --record");
+        }
+
+        auto cases = GoldenRenderSuite::getCanonicalCases();
+        for (auto& scenarioCase : GoldenRenderSuite::loadScenarioCases(scenarioFolder))
+        {
+            cases.push_back(std::move(scenarioCase));
+        }
+        for (auto& equivalenceCase : GoldenRenderSuite::getEquivalenceCases())
+        {
+            cases.push_back(std::move(equivalenceCase));
+        }
+        for (auto& songCase : GoldenRenderSuite::getSongCases())
+        {
+            cases.push_back(std::move(songCase));
+        }
+        for (auto& syncCase : GoldenRenderSuite::getSyncCases())
+        {
+            cases.push_back(std::move(syncCase));
+        }
+
+        //the cases that check themselves (equivalence, song and sync) always count, a case without a golden file is listed
+        //and only fails with --require-goldens, so the gate is green on a tree that hasn't recorded its goldens yet
+        int numFailed = 0;
+        int numUnchecked = 0;
+        for (const auto& result : GoldenRenderSuite::run(cases, goldenFolder, isRecording))
+        {
+            if (result.passed())
+            {
+                continue;
+            }
+            if (!result.hasGolden && result.differences.isEmpty() && !isRecording && !isGoldenRequired)
+            {
+                numUnchecked++;
+            }
+            else
+            {
+                numFailed++;
+            }
+            std::cout << result.name << (result.hasGolden ? "" : isRecording ? ": couldn't write the golden file" : ": no golden file") << std::endl;
+            for (const auto& difference : result.differences)
+            {
+                std::cout << "  " << difference << std::endl;
+            }
+        }
+        std::cout << (int)cases.size() - numFailed - numUnchecked << " of " << cases.size() << (isRecording ? " goldens recorded in " : " cases match in ")
+                  << goldenFolder.getFullPathName() << std::endl;
+        if (numUnchecked > 0)
+        {
+            std::cout << numUnchecked << " cases have no golden file and weren't checked, record them with --record" << std::endl;
+        }
+        if (numFailed > 0)
+        {
+            juce::ConsoleApplication::fail(juce::String(numFailed) + (isRecording ? " goldens not recorded" : " cases differ"));
+        }
+    }
+
+    void runStress(const juce::ArgumentList& args)
+    {
+        StressHarness::Settings settings;
+        if (args.containsOption("--blocks"))
+        {
+            settings.numBlocks = juce::jmax(1, args.getValueForOption("--blocks").getIntValue());
+        }
+        if (args.containsOption("--seed"))
+        {
+            settings.seed = args.getValueForOption("--seed").getLargeIntValue();
+        }
+        std::cout << StressHarness::run(settings).toString() << std::endl;
+    }
+
+    void runCost(const juce::ArgumentList&)
+    {
+        //the cycle counter against the clock first, so the medians can be given as times too
+        StressHarness::Report report;
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCycles = StressHarness::readCycleCounter();
+        juce::Thread::sleep(200);
+        const auto elapsedMicroseconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+        report.cyclesPerMicrosecond = (StressHarness::readCycleCounter() - startCycles) / elapsedMicroseconds;
+
+        StressHarness::measureCallCosts(report);
+        std::cout << report.callCostsToString();
+
+        //a build without tracing has no markers to pay for, one with it fails when they cost more than they're allowed to
+        if (report.traceMarkerCycles >= 0)
+        {
+            if (report.cyclesPerMicrosecond <= 0)
+            {
+                juce::ConsoleApplication::fail("the cycle counter couldn't be calibrated, so the trace marker can't be checked against its budget");
+            }
+            const double markerNanoseconds = report.traceMarkerCycles / report.cyclesPerMicrosecond * 1000.0;
+            if (markerNanoseconds > StressHarness::traceMarkerBudgetNanoseconds)
+            {
+                juce::ConsoleApplication::fail("a trace marker takes " + juce::String(markerNanoseconds, 1) + " ns, over the budget of "
+                    + juce::String(StressHarness::traceMarkerBudgetNanoseconds, 0) + " ns");
+            }
+        }
+    }
+
+    //a drummer at 120bpm: a decaying noise burst every half beat over a quiet noise floor
+    juce::AudioBuffer<float> makeDrumInput(double sampleRate, int numSamples)
+    {
+        juce::AudioBuffer<float> input(2, numSamples);
+        juce::Random random(1);
+        const int hitInterval = (int)(sampleRate * 0.25);
+        const float decay = std::exp(-1.0f / (float)(sampleRate * 0.03));
+        float level = 0;
+        for (int sample = 0; sample < numSamples; sample++)
+        {
+            level = sample % hitInterval == 0 ? 1.0f : level * decay;
+            const float value = (level + 0.01f) * (random.nextFloat() * 2.0f - 1.0f);
+            input.setSample(0, sample, value);
+            input.setSample(1, sample, value);
+        }
+        return input;
+    }
+
+    void runBench(const juce::ArgumentList& args)
+    {
+        //per block cost of the tempo follow input path at every block size the plugin is used with, as the median and the worst
+        //block, and the worst as a share of the time the block lasts, which is what has to stay small on the audio thread
+        const double seconds = args.containsOption("--seconds") ? juce::jmax(1.0, args.getValueForOption("--seconds").getDoubleValue()) : 20.0;
+        const int blockSizes[] = { 32, 64, 128, 256, 512, 1024, 2048 };
+        const double sampleRates[] = { 44100.0, 48000.0, 96000.0 };
+        const double ticksPerMicrosecond = (double)juce::Time::getHighResolutionTicksPerSecond() / 1000000.0;
+
+        std::cout << juce::String().paddedRight(' ', 8) << juce::String("rate").paddedLeft(' ', 11) << juce::String("block").paddedLeft(' ', 7)
+                  << juce::String("median").paddedLeft(' ', 12) << juce::String("max").paddedLeft(' ', 12) << juce::String("max/block").paddedLeft(' ', 12) << std::endl;
+        for (const double sampleRate : sampleRates)
+        {
+            const auto input = makeDrumInput(sampleRate, (int)(sampleRate * seconds));
+            for (const int blockSize : blockSizes)
+            {
+                TempoFollower follower;
+                follower.prepare(sampleRate, blockSize);
+                OnsetDetector onsets;
+                onsets.prepare(sampleRate, 0.005);
+
+                std::vector<double> followerMicroseconds, onsetMicroseconds;
+                juce::AudioBuffer<float> block(input.getNumChannels(), blockSize);
+                for (int start = 0; start + blockSize <= input.getNumSamples(); start += blockSize)
+                {
+                    for (int channel = 0; channel < input.getNumChannels(); channel++)
+                    {
+                        block.copyFrom(channel, 0, input, channel, start, blockSize);
+                    }
+
+                    auto startTicks = juce::Time::getHighResolutionTicks();
+                    follower.process(block);
+                    followerMicroseconds.push_back((double)(juce::Time::getHighResolutionTicks() - startTicks) / ticksPerMicrosecond);
+
+                    //the timing analysis runs the detector on its own, one channel as the follower does after mixing down
+                    const float* samples = block.getReadPointer(0);
+                    startTicks = juce::Time::getHighResolutionTicks();
+                    for (int sample = 0; sample < blockSize; sample++)
+                    {
+                        onsets.pushSample(samples[sample]);
+                    }
+                    onsetMicroseconds.push_back((double)(juce::Time::getHighResolutionTicks() - startTicks) / ticksPerMicrosecond);
+                }
+
+                const double blockMicroseconds = blockSize * 1000000.0 / sampleRate;
+                auto printLine = [&](const char* name, std::vector<double>& microseconds)
+                {
+                    std::sort(microseconds.begin(), microseconds.end());
+                    const double median = microseconds[microseconds.size() / 2];
+                    const double max = microseconds.back();
+                    std::cout << juce::String(name).paddedRight(' ', 8) << juce::String(sampleRate, 0).paddedLeft(' ', 11)
+                              << juce::String(blockSize).paddedLeft(' ', 7) << (juce::String(median, 2) + " us").paddedLeft(' ', 12)
+                              << (juce::String(max, 2) + " us").paddedLeft(' ', 12) << (juce::String(100.0 * max / blockMicroseconds, 2) + "%").paddedLeft(' ', 12) << std::endl;
+                };
+                printLine("follower", followerMicroseconds);
+                printLine("onsets", onsetMicroseconds);
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    //the processor's async updates and the kit loader want a message manager, this thread stands in for the message thread
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "MetroGnomeTests, the plugin's processor without a DAW or an audio device", true);
+    app.addCommand({ "scenario", "scenario <scenario file> <output folder>",
+        "Renders a host scenario.",
+        "Plays the scenario file (see HostScenario for the format) through a fresh processor and writes\n"
+        "audio.wav, midi.mid, midi.txt and blocks.txt to the output folder. Tests/Scenarios has the sync cases.",
+        runScenario });
+    app.addCommand({ "golden", "golden [--record] [--require-goldens] [--golden <folder>] [--scenarios <folder>]",
+        "Compares the canonical renders and the scenarios with their golden fingerprints.",
+        "Renders every canonical case (GoldenRenderSuite::getCanonicalCases) and every scenario file, and compares where\n"
+        "each click lands and how loud it is, and every MIDI event, with <case>.golden. The equivalence cases render a session\n"
+        "twice (variable against fixed blocks, loop cache on against off) and compare the two, the song case checks\n"
+        "that every section's first click starts on the section's first sample and the sync cases that a LOCAL_SYNC follower\n"
+        "plays with its leader. Any difference fails, a missing golden file is listed and only fails with --require-goldens.\n"
+        "--record writes the current renders as the new goldens instead, to be committed after checking them.\n"
+        "The folders default to Tests/Golden and Tests/Scenarios under the current folder.",
+        runGolden });
+    app.addCommand({ "stress", "stress [--blocks <count>] [--seed <number>]",
+        "Times the worst blocks under random block sizes and automation.",
+        "Runs StressHarness: an audio thread calls processBlock with random block sizes and automation while this thread\n"
+        "edits steps and requests resets, then prints the percentiles and the slowest blocks with the path each took.\n"
+        "Build it as Release, the timings of a Debug build say little about the plugin.",
+        runStress });
+    app.addCommand({ "cost", "cost",
+        "Times a RealtimeLog::write and a TRACE_SCOPE marker.",
+        "Prints the median cost of one call of each on a thread of its own, in cycles and time, without the cost of reading\n"
+        "the counter. The marker is only measured in a build with METROGNOME_TRACING=1 added to the exporter's preprocessor\n"
+        "definitions, which fails when it's over its 50 ns budget. Build it as Release.",
+        runCost });
+    app.addCommand({ "bench", "bench [--seconds <length>]",
+        "Times TempoFollower and OnsetDetector per block.",
+        "Feeds a synthetic drum input through a TempoFollower and an OnsetDetector at 44.1, 48 and 96kHz and block sizes\n"
+        "from 32 to 2048 samples, and prints the median and worst time per block and the worst as a share of the block's length.\n"
+        "Build it as Release, the timings of a Debug build say little about the plugin.",
+        runBench });
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,291 @@
+/*
+  ==============================================================================
+
+    StressHarness.cpp
+    Created: 20 Oct 2026 3:21:05am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#include "StressHarness.h"
+#include "PluginProcessor.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace
+{
+    //no host, the processor runs on its own clock the whole time
+    class NoHostPlayHead : public juce::AudioPlayHead
+    {
+    public:
+        juce::Optional<PositionInfo> getPosition() const override { return {}; }
+    };
+
+    class AudioThread : public juce::Thread
+    {
+    public:
+        AudioThread(std::function<void()> _work) : juce::Thread("stress audio"), work(std::move(_work)) {}
+        void run() override { work(); }
+
+    private:
+        std::function<void()> work;
+    };
+
+    //BlockPath flag names in bit order
+    const char* const blockPathNames[] = { "engineSwapped", "songSwapped", "patternsAcquired", "resetHandled", "engineRestarted", "hostConnected",
+                                           "followingTempo", "renderedSong", "renderedLoopCache", "renderedEngine", "analyzing", "followingLeader", "leading" };
+
+    juce::String describeBits(juce::uint32 bits, const juce::StringArray& names)
+    {
+        juce::StringArray set;
+        for (int bit = 0; bit < names.size(); bit++)
+        {
+            if ((bits >> bit) & 1)
+            {
+                set.add(names[bit]);
+            }
+        }
+        return set.isEmpty() ? "-" : set.joinIntoString(", ");
+    }
+}
+
+const juce::StringArray StressHarness::automationTargets{ "BPM", "NUMERATOR", "SUBDIVISION", "MODE" };
+
+juce::int64 StressHarness::readCycleCounter()
+{
+#if JUCE_INTEL
+    return (juce::int64)__rdtsc();
+#else
+    return juce::Time::getHighResolutionTicks();
+#endif
+}
+
+StressHarness::Report StressHarness::run(Settings settings)
+{
+    settings.minBlockSize = juce::jmax(1, settings.minBlockSize);
+    settings.maxBlockSize = juce::jmax(settings.minBlockSize, settings.maxBlockSize);
+
+    auto processor = std::make_unique<MetroGnomeAudioProcessor>();
+    NoHostPlayHead playHead;
+    processor->setPlayHead(&playHead);
+    processor->setRateAndBufferSizeDetails(settings.sampleRate, settings.maxBlockSize);
+    processor->prepareToPlay(settings.sampleRate, settings.maxBlockSize);
+    auto* onParam = processor->apvts.getParameter("ON/OFF");
+    onParam->setValueNotifyingHost(1.0f);
+    processor->runMessageThreadUpdates();
+
+    std::vector<juce::AudioProcessorParameter*> targets;
+    for (const auto& id : automationTargets)
+    {
+        targets.push_back(processor->apvts.getParameter(id));
+    }
+
+    //everything the audio thread needs is allocated up front, so the timings are the processor's alone
+    std::vector<BlockTiming> timings((size_t)settings.numBlocks);
+    const int numChannels = juce::jmax(processor->getTotalNumInputChannels(), processor->getTotalNumOutputChannels());
+    juce::AudioBuffer<float> buffer(numChannels, settings.maxBlockSize);
+    juce::MidiBuffer midiMessages;
+    midiMessages.ensureSize(4096);
+
+    AudioThread audioThread([&]
+    {
+        juce::Random random(settings.seed);
+        const double sizeRange = std::log((double)settings.maxBlockSize / settings.minBlockSize);
+        for (int block = 0; block < settings.numBlocks; block++)
+        {
+            //spread evenly over the orders of magnitude, so single sample blocks come up as often as full ones
+            int numSamples = juce::jlimit(settings.minBlockSize, settings.maxBlockSize, juce::roundToInt(settings.minBlockSize * std::exp(random.nextDouble() * sizeRange)));
+
+            //host automation arrives on the audio thread just before the block it belongs to
+            juce::uint32 automated = 0;
+            for (size_t target = 0; target < targets.size(); target++)
+            {
+                if (random.nextFloat() < settings.automationChance)
+                {
+                    targets[target]->setValueNotifyingHost(random.nextFloat());
+                    automated |= 1u << target;
+                }
+            }
+
+            buffer.clear();
+            juce::AudioBuffer<float> view(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+            midiMessages.clear();
+
+            const auto start = readCycleCounter();
+            processor->processBlock(view, midiMessages);
+            const auto end = readCycleCounter();
+
+            auto& timing = timings[(size_t)block];
+            timing.cycles = end - start;
+            timing.index = block;
+            timing.numSamples = numSamples;
+            timing.path = processor->getLastBlockPath();
+            timing.automated = automated;
+            timing.mode = (int)processor->apvts.getRawParameterValue("MODE")->load();
+        }
+    });
+
+    Report report;
+    report.numBlocks = settings.numBlocks;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const auto startCycles = readCycleCounter();
+    audioThread.startThread(juce::Thread::Priority::highest);
+
+    //the editor side, on the calling thread
+    juce::Random editorRandom(settings.seed + 1);
+    while (audioThread.isThreadRunning())
+    {
+        switch (editorRandom.nextInt(4))
+        {
+        case 0:
+            processor->stepPatterns.toggleStep(editorRandom.nextInt(2), editorRandom.nextInt(MAX_LENGTH));
+            break;
+        case 1:
+            processor->requestReset();
+            break;
+        case 2:
+            //a slider being dragged
+            processor->apvts.getParameter("SUBDIVISION")->setValueNotifyingHost(editorRandom.nextFloat());
+            break;
+        default:
+            break;
+        }
+        processor->runMessageThreadUpdates();
+        report.editorWrites++;
+        juce::Thread::sleep(editorRandom.nextInt(settings.editorIntervalMs + 1));
+    }
+    audioThread.stopThread(-1);
+
+    const auto elapsedMicroseconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+    if (elapsedMicroseconds > 0)
+    {
+        report.cyclesPerMicrosecond = (readCycleCounter() - startCycles) / elapsedMicroseconds;
+    }
+    processor->releaseResources();
+    processor->setPlayHead(nullptr);
+
+    measureCallCosts(report);
+
+    if (timings.empty())
+    {
+        return report;
+    }
+    std::vector<juce::int64> cycles;
+    cycles.reserve(timings.size());
+    for (const auto& timing : timings)
+    {
+        cycles.push_back(timing.cycles);
+    }
+    auto percentile = [&cycles](double fraction)
+    {
+        auto nth = cycles.begin() + (std::ptrdiff_t)std::min(cycles.size() - 1, (size_t)(fraction * (double)cycles.size()));
+        std::nth_element(cycles.begin(), nth, cycles.end());
+        return *nth;
+    };
+    report.p50 = percentile(0.5);
+    report.p99 = percentile(0.99);
+    report.p999 = percentile(0.999);
+    report.max = *std::max_element(cycles.begin(), cycles.end());
+
+    const auto numOutliers = (size_t)juce::jlimit(0, (int)timings.size(), settings.numOutliers);
+    std::partial_sort(timings.begin(), timings.begin() + (std::ptrdiff_t)numOutliers, timings.end(), [](const BlockTiming& a, const BlockTiming& b) { return a.cycles > b.cycles; });
+    report.outliers.assign(timings.begin(), timings.begin() + (std::ptrdiff_t)numOutliers);
+    return report;
+}
+
+void StressHarness::measureCallCosts(Report& report)
+{
+    //on a thread of its own, like the audio thread: RealtimeLog::write claims the thread's ring on its first call and every call
+    //after that goes into it, fewer than the ring holds so none take the dropped path, the thread's rings start out empty
+    AudioThread thread([&report]
+    {
+        //what the two counter reads around a call cost on their own, taken off every median below
+        std::vector<juce::int64> timerCycles(1024);
+        for (auto& timerCycle : timerCycles)
+        {
+            const auto start = readCycleCounter();
+            timerCycle = readCycleCounter() - start;
+        }
+        std::nth_element(timerCycles.begin(), timerCycles.begin() + (std::ptrdiff_t)timerCycles.size() / 2, timerCycles.end());
+        report.timerCycles = timerCycles[timerCycles.size() / 2];
+
+        RealtimeLog::write(LogMessage::midiNoteDropped, 60, 0, 2048);
+        std::vector<juce::int64> logCycles((size_t)LogRing::capacity / 2);
+        for (size_t call = 0; call < logCycles.size(); call++)
+        {
+            const auto start = readCycleCounter();
+            RealtimeLog::write(LogMessage::midiNoteDropped, 60, (int)call, 2048);
+            logCycles[call] = readCycleCounter() - start;
+        }
+        std::nth_element(logCycles.begin(), logCycles.begin() + (std::ptrdiff_t)logCycles.size() / 2, logCycles.end());
+        report.logCallCycles = juce::jmax((juce::int64)0, logCycles[logCycles.size() / 2] - report.timerCycles);
+
+#if METROGNOME_TRACING
+        //a marker as the audio thread hits it, the first one claims the ring
+        {
+            TRACE_SCOPE("stress harness marker");
+        }
+        std::vector<juce::int64> markerCycles(1024);
+        for (auto& markerCycle : markerCycles)
+        {
+            const auto start = readCycleCounter();
+            {
+                TRACE_SCOPE("stress harness marker");
+            }
+            markerCycle = readCycleCounter() - start;
+        }
+        std::nth_element(markerCycles.begin(), markerCycles.begin() + (std::ptrdiff_t)markerCycles.size() / 2, markerCycles.end());
+        report.traceMarkerCycles = juce::jmax((juce::int64)0, markerCycles[markerCycles.size() / 2] - report.timerCycles);
+#endif
+    });
+    thread.startThread();
+    thread.waitForThreadToExit(-1);
+}
+
+juce::String StressHarness::Report::formatCycles(juce::int64 cycles) const
+{
+    juce::String text(cycles);
+    text << " cycles";
+    if (cyclesPerMicrosecond > 0)
+    {
+        //a log call or a marker is well under a microsecond
+        const double microseconds = cycles / cyclesPerMicrosecond;
+        text << " (" << (microseconds < 1.0 ? juce::String(microseconds * 1000.0, 1) + " ns" : juce::String(microseconds, 1) + " us") << ")";
+    }
+    return text;
+}
+
+juce::String StressHarness::Report::callCostsToString() const
+{
+    juce::String text;
+    text << "counter reads " << formatCycles(timerCycles) << ", taken off both\n";
+    text << "log call " << formatCycles(logCallCycles) << "\n";
+    text << "trace marker " << (traceMarkerCycles < 0 ? juce::String("off, METROGNOME_TRACING is 0") : formatCycles(traceMarkerCycles) + ", the budget is " + juce::String(traceMarkerBudgetNanoseconds, 0) + " ns") << "\n";
+    return text;
+}
+
+juce::String StressHarness::Report::toString() const
+{
+    juce::StringArray pathNames(blockPathNames, juce::numElementsInArray(blockPathNames));
+    juce::String text;
+    text << numBlocks << " blocks, " << editorWrites << " editor writes\n";
+    text << "p50   " << formatCycles(p50) << "\n";
+    text << "p99   " << formatCycles(p99) << "\n";
+    text << "p99.9 " << formatCycles(p999) << "\n";
+    text << "max   " << formatCycles(max) << "\n";
+    text << callCostsToString();
+    text << "slowest blocks:\n";
+    for (const auto& outlier : outliers)
+    {
+        text << "  #" << outlier.index << " " << outlier.numSamples << " samples, " << formatCycles(outlier.cycles) << ", mode " << outlier.mode
+             << ", path: " << describeBits(outlier.path, pathNames) << ", automated: " << describeBits(outlier.automated, automationTargets) << "\n";
+    }
+    return text;
+}
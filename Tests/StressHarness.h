@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    StressHarness.h
+    Created: 20 Oct 2026 3:21:05am
+    Author:  romal
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class MetroGnomeAudioProcessor;
+
+//finds the worst blocks rather than the average one: an audio thread hammers processBlock with random block sizes
+//and random automation of BPM, NUMERATOR, SUBDIVISION and MODE, while the calling (message) thread toggles steps,
+//requests resets and does the processor's message thread work like an editor that is being clicked at the same time
+//every block is timed with the CPU's cycle counter, the report has the percentiles and the slowest blocks with the path each took
+//(the paths need METROGNOME_BLOCK_PATHS=1, which MetroGnomeTests defines), MetroGnomeTests stress runs it
+class StressHarness
+{
+public:
+    struct Settings
+    {
+        int numBlocks = 200000;
+        int minBlockSize = 1;
+        int maxBlockSize = 2048;
+        double sampleRate = 48000;
+        float automationChance = 0.25f; //per block and param
+        int editorIntervalMs = 2; //longest pause between two of the editor's writes
+        int numOutliers = 20; //slowest blocks kept for the report
+        juce::int64 seed = 1;
+    };
+
+    struct BlockTiming
+    {
+        juce::int64 cycles = 0;
+        int index = 0;
+        int numSamples = 0;
+        juce::uint32 path = 0; //MetroGnomeAudioProcessor::BlockPath flags
+        juce::uint32 automated = 0; //automationTargets bits written right before the block
+        int mode = 0;
+    };
+
+    struct Report
+    {
+        juce::String toString() const;
+        juce::String callCostsToString() const; //the log call and trace marker lines of toString
+        juce::String formatCycles(juce::int64 cycles) const; //with the time they take when the counter was calibrated
+
+        double cyclesPerMicrosecond = 0; //measured over the run, 0 when the counter couldn't be calibrated
+        juce::int64 p50 = 0;
+        juce::int64 p99 = 0;
+        juce::int64 p999 = 0;
+        juce::int64 max = 0;
+        std::vector<BlockTiming> outliers; //slowest first
+        int numBlocks = 0;
+        int editorWrites = 0;
+        juce::int64 timerCycles = 0; //median of the two counter reads around a timed call, with nothing between them
+        juce::int64 logCallCycles = 0; //median of one RealtimeLog::write into the calling thread's ring, less timerCycles
+        juce::int64 traceMarkerCycles = -1; //median of one TRACE_SCOPE, same way, -1 when METROGNOME_TRACING is off
+    };
+
+    //what a TRACE_SCOPE may cost on the audio thread, MetroGnomeTests cost fails a tracing build whose marker takes longer
+    static constexpr double traceMarkerBudgetNanoseconds = 50.0;
+
+    //message thread, blocks until every block has been processed
+    static Report run(Settings settings);
+
+    //times RealtimeLog::write and TRACE_SCOPE on a thread it starts for them, into the report's logCallCycles and traceMarkerCycles
+    static void measureCallCosts(Report& report);
+
+    //rdtsc where there is one, the high resolution tick count otherwise
+    static juce::int64 readCycleCounter();
+
+    //names of the params the audio thread automates, in the bit order of BlockTiming::automated
+    static const juce::StringArray automationTargets;
+};